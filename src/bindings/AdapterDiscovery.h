@@ -0,0 +1,275 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "AdapterIndex.h"
+#include "ThreadPool.h"
+
+/**
+ * A background scan of the search paths that finds and validates every adapter library.
+ *
+ * The directories are listed, and then the libraries probed (loaded, checked against
+ * DEVICE_INTERFACE_VERSION and asked for their devices), on a pool of worker threads, so that
+ * a slow (e.g. network-mounted) plugin directory never blocks the thread that started the
+ * scan.  Libraries with a current entry in the adapter index, if one is given, are taken from
+ * it instead of being probed, and the index is brought up to date once the scan completes.
+ *
+ * A caller that needs one module right away can Claim() it: a claimed module is not probed by
+ * the scan, and the caller loads it instead and hands the result back with Record().  Workers
+ * never touch Python.
+ */
+class AdapterDiscovery {
+ public:
+  /**
+   * Starts scanning `searchPaths` (in order of precedence, as for CPluginManager).
+   *
+   * @param probe Validates one library; runs on the workers and must not throw.
+   * @param index Optional adapter index to serve unchanged libraries from and then update.
+   * @param workers Number of worker threads; 0 means one per hardware thread.
+   */
+  AdapterDiscovery(const std::vector<std::string> &searchPaths, AdapterIndex::Prober probe,
+                   std::shared_ptr<AdapterIndex> index, size_t workers)
+      : probe_(std::move(probe)),
+        index_(std::move(index)),
+        dirFiles_(searchPaths.size()),
+        dirsLeft_(searchPaths.size()),
+        pool_(workers) {
+    if (searchPaths.empty()) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      OnScanned(lock);
+      return;
+    }
+    for (size_t i = 0; i < searchPaths.size(); ++i) {
+      std::string dir = searchPaths[i];
+      pool_.Submit([this, i, dir] { ScanDirectory(i, dir); });
+    }
+  }
+
+  /** Cancels the scan and waits for the libraries being probed right now. */
+  ~AdapterDiscovery() { Cancel(); }
+
+  AdapterDiscovery(const AdapterDiscovery &) = delete;
+  AdapterDiscovery &operator=(const AdapterDiscovery &) = delete;
+
+  /**
+   * Waits for the scan to complete.
+   *
+   * @param timeoutMs How long to wait; negative means no limit.
+   * @return Whether the scan is complete.
+   */
+  bool Wait(double timeoutMs) const {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (timeoutMs < 0) {
+      finished_.wait(lock, [this] { return done_; });
+      return true;
+    }
+    return finished_.wait_for(lock, std::chrono::duration<double, std::milli>(timeoutMs),
+                              [this] { return done_; });
+  }
+
+  bool IsDone() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return done_;
+  }
+
+  /** (libraries validated so far, total libraries); the total is 0 until listing is done. */
+  std::pair<size_t, size_t> GetProgress() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return {results_.size(), files_.size()};
+  }
+
+  /** Modules validated so far whose libraries loaded successfully. */
+  std::vector<std::string> GetModuleNames() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> names;
+    for (const auto &result : results_)
+      if (result.second.error.empty()) names.push_back(result.first);
+    return names;
+  }
+
+  /** Why each module validated so far failed to load, for those that did. */
+  std::map<std::string, std::string> GetErrors() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::map<std::string, std::string> errors;
+    for (const auto &result : results_)
+      if (!result.second.error.empty()) errors[result.first] = result.second.error;
+    return errors;
+  }
+
+  /**
+   * Takes `moduleName` out of the scan's hands, unless it is already validated or being
+   * probed.  Whenever this returns true, the caller must follow up with Record().
+   */
+  bool Claim(const std::string &moduleName) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (done_ || cancelled_ || results_.count(moduleName) || probing_.count(moduleName) ||
+        claimed_.count(moduleName))
+      return false;
+    if (scanned_) {
+      auto it = std::find_if(pending_.begin(), pending_.end(), [&](const AdapterFile &file) {
+        return file.moduleName == moduleName;
+      });
+      if (it == pending_.end()) return false;  // not a library on the search paths
+      pending_.erase(it);
+    }
+    claimed_.insert(moduleName);
+    return true;
+  }
+
+  /**
+   * Waits until no worker is probing `moduleName` (which Claim() refuses meanwhile), so that
+   * the caller doesn't load the library while a worker is loading it too.
+   *
+   * @param adapter Set to the module's result, if it has been validated.
+   * @return Whether it has.
+   */
+  bool WaitForProbe(const std::string &moduleName, IndexedAdapter &adapter) const {
+    std::unique_lock<std::mutex> lock(mutex_);
+    probed_.wait(lock, [&] { return probing_.count(moduleName) == 0; });
+    auto it = results_.find(moduleName);
+    if (it == results_.end()) return false;
+    adapter = it->second;
+    return true;
+  }
+
+  /** Reports the outcome of loading a claimed module (only its device list and error). */
+  void Record(const std::string &moduleName, IndexedAdapter adapter) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!claimed_.erase(moduleName)) return;
+    auto file = paths_.find(moduleName);
+    if (!scanned_ || file != paths_.end()) {
+      if (file != paths_.end()) adapter.file = files_[file->second];
+      results_[moduleName] = std::move(adapter);
+    }
+    MaybeFinish(lock);
+  }
+
+  /** Stops probing further libraries; the scan completes once those in progress are done. */
+  void Cancel() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cancelled_ = true;
+    pending_.clear();
+    if (scanned_) MaybeFinish(lock);
+  }
+
+ private:
+  void ScanDirectory(size_t i, const std::string &dir) {
+    bool cancelled;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      cancelled = cancelled_;
+    }
+    std::vector<AdapterFile> files;
+    if (!cancelled) files = AdapterIndex::Scan({dir});
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    dirFiles_[i] = std::move(files);
+    if (--dirsLeft_ == 0) OnScanned(lock);
+  }
+
+  // Merges the directory listings (earlier search paths win) and queues the libraries that the
+  // index cannot answer for.
+  void OnScanned(std::unique_lock<std::mutex> &lock) {
+    for (const std::vector<AdapterFile> &dir : dirFiles_) {
+      for (const AdapterFile &file : dir) {
+        if (paths_.count(file.moduleName)) continue;
+        paths_[file.moduleName] = files_.size();
+        files_.push_back(file);
+      }
+    }
+    dirFiles_.clear();
+    scanned_ = true;
+
+    // a module claimed before it was found, but that isn't on the search paths, doesn't count
+    for (auto it = results_.begin(); it != results_.end();)
+      it = paths_.count(it->first) ? std::next(it) : results_.erase(it);
+    for (auto &result : results_) result.second.file = files_[paths_[result.first]];
+
+    size_t queued = 0;
+    for (const AdapterFile &file : files_) {
+      if (results_.count(file.moduleName) || claimed_.count(file.moduleName)) continue;
+      IndexedAdapter adapter;
+      if (index_ && index_->Lookup(file, adapter)) {
+        results_[file.moduleName] = std::move(adapter);
+      } else if (!cancelled_) {
+        pending_.push_back(file);
+        ++queued;
+      }
+    }
+    for (size_t k = 0; k < queued; ++k) pool_.Submit([this] { ProbeNext(); });
+    MaybeFinish(lock);
+  }
+
+  void ProbeNext() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (pending_.empty()) return;  // claimed or cancelled in the meantime
+    AdapterFile file = pending_.front();
+    pending_.pop_front();
+    probing_.insert(file.moduleName);
+    lock.unlock();
+
+    IndexedAdapter adapter = probe_(file);
+
+    lock.lock();
+    probing_.erase(file.moduleName);
+    results_[file.moduleName] = std::move(adapter);
+    probed_.notify_all();
+    MaybeFinish(lock);
+  }
+
+  // Completes the scan if nothing is left to probe, updating the index (without the lock held)
+  // unless the scan was cancelled.
+  void MaybeFinish(std::unique_lock<std::mutex> &lock) {
+    if (done_ || finishing_ || !scanned_ || !pending_.empty() || !probing_.empty() ||
+        !claimed_.empty())
+      return;
+    finishing_ = true;
+    if (index_ && !cancelled_) {
+      std::vector<AdapterFile> files = files_;
+      std::map<std::string, IndexedAdapter> results = results_;
+      lock.unlock();
+      index_->Refresh(files, [&](const AdapterFile &file) {
+        auto it = results.find(file.moduleName);
+        // a library that changed after we probed it is probed again
+        if (it == results.end() || it->second.file.mtime != file.mtime ||
+            it->second.file.size != file.size)
+          return probe_(file);
+        return it->second;
+      });
+      lock.lock();
+    }
+    done_ = true;
+    finished_.notify_all();
+  }
+
+  const AdapterIndex::Prober probe_;
+  const std::shared_ptr<AdapterIndex> index_;
+
+  mutable std::mutex mutex_;
+  mutable std::condition_variable finished_;
+  mutable std::condition_variable probed_;  // a worker has finished probing a library
+  std::vector<std::vector<AdapterFile>> dirFiles_;  // listing of each search path
+  size_t dirsLeft_;
+  bool scanned_ = false;
+  std::vector<AdapterFile> files_;                 // every library, once listed
+  std::map<std::string, size_t> paths_;            // module name -> index into files_
+  std::deque<AdapterFile> pending_;                // waiting for a worker
+  std::set<std::string> probing_;                  // on a worker right now
+  std::set<std::string> claimed_;                  // being loaded by a caller
+  std::map<std::string, IndexedAdapter> results_;  // validated, by module name
+  bool cancelled_ = false;
+  bool finishing_ = false;
+  bool done_ = false;
+
+  ThreadPool pool_;  // last, so the workers are joined before anything they use is destroyed
+};
@@ -0,0 +1,305 @@
+#pragma once
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/** A device adapter library found on the search path. */
+struct AdapterFile {
+  std::string moduleName;
+  std::string path;
+  int64_t mtime;
+  int64_t size;
+};
+
+/** What one adapter library advertised when it was last probed. */
+struct IndexedAdapter {
+  struct Device {
+    std::string name;
+    int type;  // MM::DeviceType
+    std::string description;
+  };
+
+  AdapterFile file;
+  std::string error;  // why the library could not be loaded, if it couldn't
+  std::vector<Device> devices;
+};
+
+/**
+ * Persistent record of the devices each adapter library advertises, so that listing them does
+ * not require loading (dlopen-ing and initializing) every library on the search path.
+ *
+ * Entries are keyed by library path and are trusted only while the file's mtime and size are
+ * unchanged and the bindings were built against the same DEVICE_INTERFACE_VERSION as when the
+ * entry was recorded; anything else is probed again on the next Refresh().  The index is kept
+ * in a small text file that is rewritten (atomically) whenever it changes.
+ */
+class AdapterIndex {
+ public:
+  /** Probes one library; must not throw (report failures through IndexedAdapter::error). */
+  using Prober = std::function<IndexedAdapter(const AdapterFile &)>;
+
+  AdapterIndex(std::string indexPath, long interfaceVersion)
+      : indexPath_(std::move(indexPath)), interfaceVersion_(interfaceVersion) {
+    Load();
+  }
+
+  const std::string &GetPath() const { return indexPath_; }
+
+  /**
+   * Lists the adapter libraries in `searchPaths`, named as CPluginManager names them.  If the
+   * same module is found more than once, the first search path wins.
+   */
+  static std::vector<AdapterFile> Scan(const std::vector<std::string> &searchPaths) {
+#ifdef _WIN32
+    const std::string prefix = "mmgr_dal_";
+#else
+    const std::string prefix = "libmmgr_dal_";
+#endif
+    std::vector<AdapterFile> files;
+    std::map<std::string, bool> seen;
+    for (const std::string &dir : searchPaths) {
+      std::vector<std::string> names = List(dir, prefix);
+      std::sort(names.begin(), names.end());
+      for (const std::string &name : names) {
+        std::string moduleName = name.substr(prefix.size());
+        moduleName = moduleName.substr(0, moduleName.find('.'));
+        if (moduleName.empty() || seen[moduleName]) continue;
+        AdapterFile file{moduleName, dir + "/" + name, 0, 0};
+        if (!Stat(file)) continue;
+        seen[moduleName] = true;
+        files.push_back(file);
+      }
+    }
+    return files;
+  }
+
+  /**
+   * Brings the index up to date with `files` (as returned by Scan): libraries that are new or
+   * changed since they were recorded are probed, entries whose library no longer exists are
+   * dropped, and `files` becomes the set that Find() and GetModuleNames() answer from.
+   *
+   * @param probe Called, without any lock held, for each library that needs probing.
+   * @return The number of libraries probed.
+   */
+  size_t Refresh(const std::vector<AdapterFile> &files, const Prober &probe) {
+    std::vector<AdapterFile> stale;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (const AdapterFile &file : files)
+        if (!IsCurrent(file)) stale.push_back(file);
+    }
+
+    std::vector<IndexedAdapter> probed;
+    for (const AdapterFile &file : stale) probed.push_back(probe(file));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    bool changed = !probed.empty();
+    for (IndexedAdapter &adapter : probed) adapters_[adapter.file.path] = std::move(adapter);
+    for (auto it = adapters_.begin(); it != adapters_.end();) {
+      AdapterFile file = it->second.file;
+      if (Stat(file)) {
+        ++it;
+      } else {
+        it = adapters_.erase(it);
+        changed = true;
+      }
+    }
+    current_.clear();
+    for (const AdapterFile &file : files) current_[file.moduleName] = file.path;
+    if (changed) Save();
+    return probed.size();
+  }
+
+  /** Looks up the entry for `file` (as returned by Scan), if it is still current. */
+  bool Lookup(const AdapterFile &file, IndexedAdapter &out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!IsCurrent(file)) return false;
+    out = adapters_.find(file.path)->second;
+    return true;
+  }
+
+  /** Looks up a module among the libraries of the last Refresh(). */
+  bool Find(const std::string &moduleName, IndexedAdapter &out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto path = current_.find(moduleName);
+    if (path == current_.end()) return false;
+    auto it = adapters_.find(path->second);
+    if (it == adapters_.end()) return false;
+    out = it->second;
+    return true;
+  }
+
+  /** Modules from the last Refresh() whose libraries loaded successfully. */
+  std::vector<std::string> GetModuleNames() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> names;
+    for (const auto &module : current_) {
+      auto it = adapters_.find(module.second);
+      if (it != adapters_.end() && it->second.error.empty()) names.push_back(module.first);
+    }
+    return names;
+  }
+
+ private:
+  // File format, one record per line with tab-separated, escaped fields:
+  //   pymmdevice-adapter-index <format version> <DEVICE_INTERFACE_VERSION>
+  //   A <module> <path> <mtime> <size> <error>
+  //   D <name> <type> <description>         (devices of the preceding A record)
+  static constexpr int kFormatVersion = 1;
+
+  // Call with mutex_ held.
+  bool IsCurrent(const AdapterFile &file) const {
+    auto it = adapters_.find(file.path);
+    return it != adapters_.end() && it->second.file.mtime == file.mtime &&
+           it->second.file.size == file.size && it->second.file.moduleName == file.moduleName;
+  }
+
+  // Names of the entries in `dir` that start with `prefix`, in no particular order.
+  static std::vector<std::string> List(const std::string &dir, const std::string &prefix) {
+    std::vector<std::string> names;
+#ifdef _WIN32
+    WIN32_FIND_DATAA entry;
+    HANDLE handle = FindFirstFileA((dir + "\\" + prefix + "*").c_str(), &entry);
+    if (handle == INVALID_HANDLE_VALUE) return names;
+    do {
+      names.push_back(entry.cFileName);
+    } while (FindNextFileA(handle, &entry));
+    FindClose(handle);
+#else
+    DIR *handle = opendir(dir.c_str());
+    if (handle == nullptr) return names;
+    while (dirent *entry = readdir(handle)) {
+      std::string name = entry->d_name;
+      if (name.compare(0, prefix.size(), prefix) == 0) names.push_back(name);
+    }
+    closedir(handle);
+#endif
+    return names;
+  }
+
+  static bool Stat(AdapterFile &file) {
+#ifdef _WIN32
+    struct _stat64 info;
+    if (_stat64(file.path.c_str(), &info) != 0 || !(info.st_mode & _S_IFREG)) return false;
+#else
+    struct stat info;
+    if (stat(file.path.c_str(), &info) != 0 || !S_ISREG(info.st_mode)) return false;
+#endif
+    file.mtime = static_cast<int64_t>(info.st_mtime);
+    file.size = static_cast<int64_t>(info.st_size);
+    return true;
+  }
+
+  static std::string Escape(const std::string &field) {
+    std::string out;
+    for (char c : field) {
+      if (c == '\\')
+        out += "\\\\";
+      else if (c == '\t')
+        out += "\\t";
+      else if (c == '\n')
+        out += "\\n";
+      else if (c == '\r')
+        out += "\\r";
+      else
+        out += c;
+    }
+    return out;
+  }
+
+  static std::vector<std::string> Split(const std::string &line) {
+    std::vector<std::string> fields(1);
+    for (size_t i = 0; i < line.size(); ++i) {
+      char c = line[i];
+      if (c == '\t') {
+        fields.emplace_back();
+      } else if (c == '\\' && i + 1 < line.size()) {
+        char next = line[++i];
+        fields.back() += next == 't' ? '\t' : next == 'n' ? '\n' : next == 'r' ? '\r' : next;
+      } else {
+        fields.back() += c;
+      }
+    }
+    return fields;
+  }
+
+  // A missing, unreadable or outdated index file just means starting from scratch.
+  void Load() {
+    std::ifstream in(indexPath_);
+    std::string line;
+    std::ostringstream expected;
+    expected << "pymmdevice-adapter-index " << kFormatVersion << " " << interfaceVersion_;
+    if (!std::getline(in, line) || line != expected.str()) return;
+
+    IndexedAdapter *current = nullptr;
+    while (std::getline(in, line)) {
+      std::vector<std::string> f = Split(line);
+      try {
+        if (f[0] == "A" && f.size() == 6) {
+          IndexedAdapter adapter;
+          adapter.file = {f[1], f[2], std::stoll(f[3]), std::stoll(f[4])};
+          adapter.error = f[5];
+          current = &(adapters_[adapter.file.path] = std::move(adapter));
+        } else if (f[0] == "D" && f.size() == 4 && current != nullptr) {
+          current->devices.push_back({f[1], std::stoi(f[2]), f[3]});
+        } else {
+          current = nullptr;  // skip a malformed record and its devices
+        }
+      } catch (const std::exception &) {
+        current = nullptr;
+      }
+    }
+  }
+
+  void Save() const {
+    std::string tmpPath = indexPath_ + ".tmp";
+    {
+      std::ofstream out(tmpPath, std::ios::trunc);
+      if (!out) return;  // an index we can't write only costs a re-probe next time
+      out << "pymmdevice-adapter-index " << kFormatVersion << " " << interfaceVersion_ << "\n";
+      for (const auto &entry : adapters_) {
+        const IndexedAdapter &adapter = entry.second;
+        out << "A\t" << Escape(adapter.file.moduleName) << "\t" << Escape(adapter.file.path)
+            << "\t" << adapter.file.mtime << "\t" << adapter.file.size << "\t"
+            << Escape(adapter.error) << "\n";
+        for (const IndexedAdapter::Device &device : adapter.devices)
+          out << "D\t" << Escape(device.name) << "\t" << device.type << "\t"
+              << Escape(device.description) << "\n";
+      }
+      if (!out) return;
+    }
+#ifdef _WIN32
+    // unlike rename(), this replaces an existing index on Windows too
+    MoveFileExA(tmpPath.c_str(), indexPath_.c_str(), MOVEFILE_REPLACE_EXISTING);
+#else
+    std::rename(tmpPath.c_str(), indexPath_.c_str());
+#endif
+  }
+
+  const std::string indexPath_;
+  const long interfaceVersion_;
+  mutable std::mutex mutex_;
+  std::map<std::string, IndexedAdapter> adapters_;  // by library path
+  std::map<std::string, std::string> current_;      // module name -> library path
+};
@@ -0,0 +1,349 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "DeviceRegistry.h"
+
+/**
+ * Counts durations (in ns) in buckets a quarter of an octave wide, so quantiles are good to
+ * about 10% at any scale.  Fixed size: adding never allocates.
+ */
+class LatencyHistogram {
+ public:
+  void Add(uint64_t ns) {
+    ++counts_[Bucket(ns)];
+    ++total_;
+  }
+
+  void Merge(const LatencyHistogram &other) {
+    for (size_t i = 0; i < kBuckets; ++i) counts_[i] += other.counts_[i];
+    total_ += other.total_;
+  }
+
+  /** The duration that a fraction `q` of those added don't exceed (0 if there are none). */
+  double Quantile(double q) const {
+    if (total_ == 0) return 0;
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * total_)));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+      seen += counts_[i];
+      if (seen >= rank) return (Lower(i) + Lower(i + 1)) / 2;  // the bucket's midpoint
+    }
+    return Lower(kBuckets);
+  }
+
+ private:
+  // 0..3 ns exactly, then four buckets per power of two up to 2^64 ns
+  static const size_t kBuckets = 252;
+
+  static size_t Bucket(uint64_t ns) {
+    if (ns < 4) return static_cast<size_t>(ns);
+    int octave = 0;
+    for (uint64_t v = ns; v > 1; v >>= 1) ++octave;
+    return (octave - 1) * 4 + ((ns >> (octave - 2)) & 3);
+  }
+
+  static double Lower(size_t bucket) {
+    if (bucket < 4) return static_cast<double>(bucket);
+    return std::ldexp(4 + bucket % 4, static_cast<int>(bucket / 4) - 1);
+  }
+
+  std::array<uint64_t, kBuckets> counts_{};
+  uint64_t total_ = 0;
+};
+
+/** Where the time of one call went. */
+struct CallTiming {
+  std::chrono::steady_clock::time_point start;
+  int64_t totalNs = 0;     // the whole call, as seen by the bindings
+  int64_t lockWaitNs = 0;  // waiting for the adapter module's lock
+  int64_t adapterNs = 0;   // holding it, i.e. in the adapter (and the hardware)
+};
+
+/**
+ * A ring of the most recent calls of a DeviceManager's devices, for export as a Chrome trace
+ * (chrome://tracing, Perfetto).  Slots are allocated up front and overwritten oldest first.
+ */
+class CallTrace {
+ public:
+  explicit CallTrace(size_t capacity)
+      : events_(std::max<size_t>(capacity, 1)), epoch_(std::chrono::steady_clock::now()) {}
+
+  /** @param label Must outlive the trace (see CallProfile). */
+  void Add(const std::string *label, const char *method, const CallTiming &timing) {
+    static std::atomic<uint32_t> lastThread{0};
+    thread_local uint32_t thread = ++lastThread;
+    std::lock_guard<std::mutex> lock(mutex_);
+    events_[recorded_++ % events_.size()] = Event{label, method, timing, thread};
+  }
+
+  /** Writes the retained calls as a Chrome trace-event JSON object; returns how many. */
+  size_t Write(std::ostream &out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = std::min<uint64_t>(recorded_, events_.size());
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    for (size_t i = 0; i < count; ++i) {
+      const Event &event = events_[(recorded_ - count + i) % events_.size()];
+      double ts = std::chrono::duration<double, std::micro>(event.timing.start - epoch_).count();
+      if (i > 0) out << ',';
+      out << "{\"name\":";
+      WriteString(out, event.method);
+      out << ",\"cat\":";
+      WriteString(out, event.label->c_str());
+      out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread << ",\"ts\":" << ts
+          << ",\"dur\":" << event.timing.totalNs / 1e3 << ",\"args\":{\"device\":";
+      WriteString(out, event.label->c_str());
+      out << ",\"lock_wait_us\":" << event.timing.lockWaitNs / 1e3
+          << ",\"adapter_us\":" << event.timing.adapterNs / 1e3 << "}}";
+    }
+    out << "]}";
+    return count;
+  }
+
+  /** How many calls were added, including those since overwritten. */
+  uint64_t GetRecordedCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return recorded_;
+  }
+
+ private:
+  struct Event {
+    const std::string *label;
+    const char *method;
+    CallTiming timing;
+    uint32_t thread;
+  };
+
+  static void WriteString(std::ostream &out, const char *s) {
+    out << '"';
+    for (; *s; ++s) {
+      unsigned char c = static_cast<unsigned char>(*s);
+      if (c == '"' || c == '\\') {
+        out << '\\' << *s;
+      } else if (c < 0x20) {
+        char escaped[8];
+        std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+        out << escaped;
+      } else {
+        out << *s;
+      }
+    }
+    out << '"';
+  }
+
+  mutable std::mutex mutex_;
+  std::vector<Event> events_;
+  uint64_t recorded_ = 0;
+  std::chrono::steady_clock::time_point epoch_;
+};
+
+/**
+ * Per-method latency of the calls made from Python to one device.
+ *
+ * Methods are keyed by the name they were bound under (a string literal, so keys never need
+ * copying); recording takes a short mutex and allocates only the first time a method is seen.
+ */
+class CallStats {
+ public:
+  struct Method {
+    uint64_t count = 0;
+    int64_t totalNs = 0;
+    int64_t minNs = 0;
+    int64_t maxNs = 0;
+    int64_t lockWaitNs = 0;
+    int64_t adapterNs = 0;
+    LatencyHistogram histogram;
+
+    void Merge(const Method &other) {
+      if (other.count == 0) return;
+      minNs = count == 0 ? other.minNs : std::min(minNs, other.minNs);
+      maxNs = std::max(maxNs, other.maxNs);
+      count += other.count;
+      totalNs += other.totalNs;
+      lockWaitNs += other.lockWaitNs;
+      adapterNs += other.adapterNs;
+      histogram.Merge(other.histogram);
+    }
+  };
+
+  CallStats(std::string label, std::shared_ptr<CallTrace> trace)
+      : label_(std::move(label)), trace_(std::move(trace)) {}
+
+  void Record(const char *method, const CallTiming &timing) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      Method &stats = methods_[method];
+      stats.minNs = stats.count == 0 ? timing.totalNs : std::min(stats.minNs, timing.totalNs);
+      stats.maxNs = std::max(stats.maxNs, timing.totalNs);
+      ++stats.count;
+      stats.totalNs += timing.totalNs;
+      stats.lockWaitNs += timing.lockWaitNs;
+      stats.adapterNs += timing.adapterNs;
+      stats.histogram.Add(static_cast<uint64_t>(std::max<int64_t>(timing.totalNs, 0)));
+    }
+    if (trace_) trace_->Add(&label_, method, timing);
+  }
+
+  /** A copy of the stats so far, by method name. */
+  std::map<std::string, Method> GetMethods() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return std::map<std::string, Method>(methods_.begin(), methods_.end());
+  }
+
+  const std::string &GetLabel() const { return label_; }
+
+ private:
+  struct NameLess {
+    bool operator()(const char *a, const char *b) const { return std::strcmp(a, b) < 0; }
+  };
+
+  const std::string label_;
+  std::shared_ptr<CallTrace> trace_;
+  mutable std::mutex mutex_;
+  std::map<const char *, Method, NameLess> methods_;
+};
+
+/**
+ * The call statistics of one DeviceManager: a CallStats for every device it had while they
+ * were enabled (unloaded ones included, so a profile survives a reconfiguration), and the
+ * optional trace they all feed.
+ */
+class CallProfile {
+ public:
+  explicit CallProfile(size_t traceCapacity)
+      : trace_(traceCapacity > 0 ? std::make_shared<CallTrace>(traceCapacity) : nullptr) {
+    ActiveCount().fetch_add(1, std::memory_order_relaxed);
+  }
+
+  ~CallProfile() { ActiveCount().fetch_sub(1, std::memory_order_relaxed); }
+
+  CallProfile(const CallProfile &) = delete;
+  CallProfile &operator=(const CallProfile &) = delete;
+
+  /** New stats for a device joining the profile. */
+  std::shared_ptr<CallStats> AddDevice(const std::string &label) {
+    auto stats = std::make_shared<CallStats>(label, trace_);
+    std::lock_guard<std::mutex> lock(mutex_);
+    devices_.push_back(stats);
+    return stats;
+  }
+
+  std::vector<std::shared_ptr<const CallStats>> GetDevices() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return std::vector<std::shared_ptr<const CallStats>>(devices_.begin(), devices_.end());
+  }
+
+  /** nullptr unless created with a trace capacity. */
+  const CallTrace *GetTrace() const { return trace_.get(); }
+
+  /** Whether any profile exists; while none does, calls aren't even looked up. */
+  static bool AnyActive() { return ActiveCount().load(std::memory_order_relaxed) > 0; }
+
+ private:
+  static std::atomic<int> &ActiveCount() {
+    static std::atomic<int> count{0};
+    return count;
+  }
+
+  std::shared_ptr<CallTrace> trace_;
+  mutable std::mutex mutex_;
+  std::vector<std::shared_ptr<CallStats>> devices_;
+};
+
+/**
+ * Times one call from Python to a device and records it into the device's CallStats when it
+ * ends.  DeviceCallGuards taken on the same thread meanwhile (see CallScope::Guarded) add how
+ * long they waited for the adapter's lock and how long they held it.
+ */
+class CallScope {
+ public:
+  CallScope(CallStats &stats, const char *method)
+      : stats_(stats), method_(method), previous_(Current()) {
+    timing_.start = std::chrono::steady_clock::now();
+    Current() = this;
+  }
+
+  ~CallScope() {
+    timing_.totalNs = Elapsed(timing_.start);
+    Current() = previous_;
+    stats_.Record(method_, timing_);
+  }
+
+  CallScope(const CallScope &) = delete;
+  CallScope &operator=(const CallScope &) = delete;
+
+  /**
+   * Times a DeviceCallGuard for the scope of the current thread, if any: construct it before
+   * taking the lock, call Locked() once it is held, and destroy it after releasing.  Nested
+   * guards count once, through the outermost.
+   */
+  class Guarded {
+   public:
+    Guarded() : scope_(Current()) {
+      if (!scope_ || scope_->guarded_) {
+        scope_ = nullptr;
+        return;
+      }
+      scope_->guarded_ = true;
+      requested_ = locked_ = std::chrono::steady_clock::now();
+    }
+
+    ~Guarded() {
+      if (!scope_) return;
+      scope_->timing_.lockWaitNs += Between(requested_, locked_);
+      scope_->timing_.adapterNs += Elapsed(locked_);
+      scope_->guarded_ = false;
+    }
+
+    Guarded(const Guarded &) = delete;
+    Guarded &operator=(const Guarded &) = delete;
+
+    void Locked() {
+      if (scope_) locked_ = std::chrono::steady_clock::now();
+    }
+
+   private:
+    CallScope *scope_;
+    std::chrono::steady_clock::time_point requested_, locked_;
+  };
+
+ private:
+  static CallScope *&Current() {
+    thread_local CallScope *current = nullptr;
+    return current;
+  }
+
+  static int64_t Between(std::chrono::steady_clock::time_point from,
+                         std::chrono::steady_clock::time_point to) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count();
+  }
+
+  static int64_t Elapsed(std::chrono::steady_clock::time_point from) {
+    return Between(from, std::chrono::steady_clock::now());
+  }
+
+  CallStats &stats_;
+  const char *method_;
+  CallScope *previous_;
+  CallTiming timing_;
+  bool guarded_ = false;
+};
+
+/** The CallStats of each device whose manager has them enabled, by raw device pointer. */
+inline DeviceRegistry<CallStats> &deviceCallStats() {
+  static DeviceRegistry<CallStats> *registry = new DeviceRegistry<CallStats>();
+  return *registry;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "MMDevice.h"
+
+/**
+ * Side state that the bindings attach to a device, keyed by its raw MM::Device pointer.
+ *
+ * MMCore's DeviceInstance classes can't carry extra members, and inside an MM::Core callback
+ * the raw pointer is the only handle we get on the calling device.  Lookups copy out a
+ * shared_ptr under a short-lived mutex, so an entry stays valid for whoever found it even if
+ * it is detached concurrently.  State that must also be reachable by label (e.g. a serial
+ * port, which adapters address by name) uses a std::string key instead.
+ */
+template <typename T, typename Key = const MM::Device *>
+class DeviceRegistry {
+ public:
+  void Attach(const Key &device, std::shared_ptr<T> value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_[device] = std::move(value);
+    size_.store(entries_.size(), std::memory_order_release);
+  }
+
+  void Detach(const Key &device) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.erase(device);
+    size_.store(entries_.size(), std::memory_order_release);
+  }
+
+  /** The entry of `device`, attaching a new (default-constructed) one if it has none yet. */
+  std::shared_ptr<T> FindOrAttach(const Key &device) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::shared_ptr<T> &entry = entries_[device];
+    if (!entry) entry = std::make_shared<T>();
+    size_.store(entries_.size(), std::memory_order_release);
+    return entry;
+  }
+
+  std::shared_ptr<T> Find(const Key &device) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(device);
+    return it == entries_.end() ? nullptr : it->second;
+  }
+
+  /**
+   * Whether nothing is attached, without taking the mutex: lets a hot path skip building a
+   * key (e.g. a std::string label) for a lookup that can't succeed.
+   */
+  bool IsEmpty() const { return size_.load(std::memory_order_acquire) == 0; }
+
+ private:
+  mutable std::mutex mutex_;
+  std::unordered_map<Key, std::shared_ptr<T>> entries_;
+  std::atomic<size_t> size_{0};
+};
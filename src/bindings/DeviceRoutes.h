@@ -0,0 +1,91 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "DeviceInstance.h"
+#include "DeviceManager.h"
+#include "MMDevice.h"
+
+/**
+ * The devices of one DeviceManager, as an MM::Core callback needs to look them up: by the raw
+ * pointer of a calling device, and by label.
+ *
+ * Callbacks arrive on adapters' own threads (e.g. a camera's acquisition thread) while Python
+ * may be loading or unloading devices, so lookups never touch the DeviceManager.  They read an
+ * immutable table instead, which Update() rebuilds and swaps in after every change; a lookup
+ * costs one atomic shared_ptr copy and one map search, without allocating.  The table only
+ * holds weak references, so a device the manager unloads is destroyed as usual (and can no
+ * longer be found) even before the next Update().
+ */
+class DeviceRoutes {
+ public:
+  /** A device found, with its type (UnknownType, and no device, if there is none). */
+  struct Route {
+    std::shared_ptr<DeviceInstance> device;
+    MM::DeviceType type;
+  };
+
+  /** Rebuilds the table from the manager's current devices.  Python thread only. */
+  void Update(const mm::DeviceManager &manager) {
+    auto table = std::make_shared<Table>();
+    for (const std::string &label : manager.GetDeviceList()) {
+      std::shared_ptr<DeviceInstance> device = manager.GetDevice(label.c_str());
+      Entry entry{device, device->GetType()};
+      table->byDevice.emplace(device->GetRawPtr(), entry);
+      table->byLabel.emplace(label, entry);
+      table->labels.push_back(label);
+    }
+    std::atomic_store(&table_, std::shared_ptr<const Table>(std::move(table)));
+  }
+
+  /** Forgets every device (e.g. before the manager unloads them). */
+  void Clear() { std::atomic_store(&table_, std::make_shared<const Table>()); }
+
+  Route Find(const MM::Device *device) const {
+    std::shared_ptr<const Table> table = std::atomic_load(&table_);
+    auto it = table->byDevice.find(device);
+    return it == table->byDevice.end() ? Route{nullptr, MM::UnknownType} : it->second.Lock();
+  }
+
+  Route Find(const char *label) const {
+    std::shared_ptr<const Table> table = std::atomic_load(&table_);
+    auto it = label ? table->byLabel.find(label) : table->byLabel.end();
+    return it == table->byLabel.end() ? Route{nullptr, MM::UnknownType} : it->second.Lock();
+  }
+
+  /** The label of the `index`th device of `type` (in GetDeviceList order), or nullptr. */
+  std::shared_ptr<const std::string> GetLabelOfType(MM::DeviceType type, size_t index) const {
+    std::shared_ptr<const Table> table = std::atomic_load(&table_);
+    for (const std::string &label : table->labels) {
+      if (type != MM::AnyType && table->byLabel.find(label)->second.type != type) continue;
+      // aliases the table, so the string stays valid for as long as the caller holds it
+      if (index-- == 0) return std::shared_ptr<const std::string>(table, &label);
+    }
+    return nullptr;
+  }
+
+ private:
+  struct Entry {
+    std::weak_ptr<DeviceInstance> device;
+    MM::DeviceType type;
+
+    Route Lock() const {
+      std::shared_ptr<DeviceInstance> locked = device.lock();
+      return locked ? Route{locked, type} : Route{nullptr, MM::UnknownType};
+    }
+  };
+
+  struct Table {
+    std::unordered_map<const MM::Device *, Entry> byDevice;
+    std::map<std::string, Entry, std::less<>> byLabel;  // transparent: find(const char *)
+    std::vector<std::string> labels;                     // in GetDeviceList order
+  };
+
+  std::shared_ptr<const Table> table_ = std::make_shared<const Table>();
+};
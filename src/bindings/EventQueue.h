@@ -0,0 +1,222 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "MMDevice.h"
+
+/** A change notification from a device, as queued for Python. */
+struct DeviceEvent {
+  enum Kind : uint8_t {
+    PropertyChanged,         // name, value
+    PropertiesChanged,       //
+    StagePositionChanged,    // a: position (um)
+    XYStagePositionChanged,  // a, b: x, y (um)
+    ExposureChanged,         // a: exposure (ms)
+    SLMExposureChanged,      // a: exposure (ms)
+    MagnifierChanged,        //
+  };
+
+  Kind kind = PropertiesChanged;
+  const MM::Device *device = nullptr;
+  double a = 0;
+  double b = 0;
+  std::string name;
+  std::string value;
+};
+
+/**
+ * Carries device notifications from adapter threads to one Python consumer.
+ *
+ * Push() is lock-free and never takes the GIL: it claims a slot of a fixed ring (a bounded
+ * multi-producer queue after Vyukov), so a notification costs two atomic operations and a
+ * string copy into storage that slots keep between uses.  A full queue drops the event and
+ * counts it.  The consumer is woken once per batch rather than per event: the first push
+ * after a drain signals a condition variable and, on POSIX, makes a pipe readable, so the
+ * queue can be select()ed on alongside other file descriptors.
+ */
+class EventQueue {
+ public:
+  /** @param capacity Events held at most; rounded up to a power of two. */
+  explicit EventQueue(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) size *= 2;
+    slots_ = std::vector<Slot>(size);
+    for (size_t i = 0; i < size; ++i) slots_[i].seq.store(i, std::memory_order_relaxed);
+    mask_ = size - 1;
+#ifndef _WIN32
+    if (::pipe(pipe_) == 0) {
+      for (int fd : pipe_) ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+    } else {
+      pipe_[0] = pipe_[1] = -1;
+    }
+#endif
+  }
+
+  ~EventQueue() {
+#ifndef _WIN32
+    for (int fd : pipe_)
+      if (fd >= 0) ::close(fd);
+#endif
+  }
+
+  EventQueue(const EventQueue &) = delete;
+  EventQueue &operator=(const EventQueue &) = delete;
+
+  /**
+   * Queues an event, which `fill` writes in place (reusing the slot's strings).  Any thread.
+   *
+   * @return false if the queue was full and the event was dropped.
+   */
+  template <typename Fill>
+  bool Push(Fill fill) {
+    size_t pos = head_.load(std::memory_order_relaxed);
+    Slot *slot;
+    for (;;) {
+      slot = &slots_[pos & mask_];
+      size_t seq = slot->seq.load(std::memory_order_acquire);
+      std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+      if (diff == 0) {
+        if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+      } else if (diff < 0) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      } else {
+        pos = head_.load(std::memory_order_relaxed);
+      }
+    }
+    fill(slot->event);
+    slot->seq.store(pos + 1, std::memory_order_release);
+
+    if (!signaled_.exchange(true, std::memory_order_acq_rel)) Notify();
+    return true;
+  }
+
+  /**
+   * Moves up to `maxEvents` (0: all) queued events to the end of `out`.  Consumer only.
+   *
+   * Strings are swapped rather than copied, so slots and `out` trade storage.
+   */
+  size_t Drain(std::vector<DeviceEvent> &out, size_t maxEvents) {
+#ifndef _WIN32
+    char buf[64];
+    if (pipe_[0] >= 0)
+      while (::read(pipe_[0], buf, sizeof(buf)) > 0) {
+      }
+#endif
+    // Cleared only once the pipe is empty, so that a push from here on writes a byte nobody
+    // eats.  An exchange rather than a store: it reads the flag set by any push that came
+    // before, so that push's event is visible to the loop below.
+    signaled_.exchange(false, std::memory_order_acq_rel);
+    size_t count = 0;
+    while (maxEvents == 0 || count < maxEvents) {
+      Slot &slot = slots_[tail_ & mask_];
+      if (slot.seq.load(std::memory_order_acquire) != tail_ + 1) break;
+      out.emplace_back();
+      DeviceEvent &event = out.back();
+      event.kind = slot.event.kind;
+      event.device = slot.event.device;
+      event.a = slot.event.a;
+      event.b = slot.event.b;
+      event.name.swap(slot.event.name);
+      event.value.swap(slot.event.value);
+      slot.seq.store(tail_ + slots_.size(), std::memory_order_release);
+      ++tail_;
+      ++count;
+    }
+    // events left behind by maxEvents, or pushed while draining, are still pending
+    if (slots_[tail_ & mask_].seq.load(std::memory_order_acquire) == tail_ + 1 &&
+        !signaled_.exchange(true, std::memory_order_acq_rel))
+      Notify();
+    return count;
+  }
+
+  /**
+   * Waits until events may be pending (a push since the last drain) or the queue is closed.
+   *
+   * @param timeoutMs How long to wait; negative means no limit.
+   * @return Whether events may be pending.
+   */
+  bool Wait(double timeoutMs) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto ready = [this] { return signaled_.load(std::memory_order_acquire) || closed_; };
+    if (timeoutMs < 0)
+      wake_.wait(lock, ready);
+    else
+      wake_.wait_for(lock, std::chrono::duration<double, std::milli>(timeoutMs), ready);
+    return signaled_.load(std::memory_order_acquire);
+  }
+
+  /** Wakes any waiter for good; later pushes still queue. */
+  void Close() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      closed_ = true;
+    }
+    wake_.notify_all();
+  }
+
+  bool IsClosed() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return closed_;
+  }
+
+  /** Readable whenever events may be pending; -1 where pipes aren't available. */
+  int GetFileDescriptor() const {
+#ifndef _WIN32
+    return pipe_[0];
+#else
+    return -1;
+#endif
+  }
+
+  uint64_t GetDroppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+
+ private:
+  struct Slot {
+    std::atomic<size_t> seq{0};
+    DeviceEvent event;
+  };
+
+  // Once per batch, so taking the mutex here costs producers next to nothing.
+  void Notify() {
+    {
+      // taken so that a waiter can't miss the wakeup between its check and its wait
+      std::lock_guard<std::mutex> lock(mutex_);
+    }
+    wake_.notify_all();
+#ifndef _WIN32
+    if (pipe_[1] >= 0) {
+      char byte = 1;
+      ssize_t written = ::write(pipe_[1], &byte, 1);
+      (void)written;  // a full pipe is readable already
+    }
+#endif
+  }
+
+  std::vector<Slot> slots_;
+  size_t mask_ = 0;
+  std::atomic<size_t> head_{0};  // next slot to fill
+  size_t tail_ = 0;              // next slot to drain; consumer only
+  std::atomic<bool> signaled_{false};
+  std::atomic<uint64_t> dropped_{0};
+
+  mutable std::mutex mutex_;
+  std::condition_variable wake_;
+  bool closed_ = false;
+#ifndef _WIN32
+  int pipe_[2] = {-1, -1};
+#endif
+};
@@ -0,0 +1,205 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "DeviceRegistry.h"
+#include "SequenceBuffer.h"
+
+/**
+ * Runs image processing between a camera's acquisition thread and its sequence buffer.
+ *
+ * Frames the camera inserts are queued in a small staging ring; a worker thread pops them,
+ * runs every stage on the frame in place, and inserts the result into the output buffer.  The
+ * camera thread therefore only pays for one copy, and processing frame N overlaps with the
+ * acquisition of frame N + 1.  A frame that a stage fails on is dropped and counted.
+ *
+ * Frames the camera asks not to have processed are queued all the same and only skip the
+ * stages, so the worker stays the output buffer's single producer and frames keep their order.
+ */
+class FramePipeline {
+ public:
+  /** Processes a frame in place; returns an error message, or "" on success. */
+  using Stage = std::function<std::string(unsigned char *frame, unsigned width, unsigned height,
+                                          unsigned bytesPerPixel)>;
+  /** Returns the buffer processed frames go to (looked up per frame, as it may be replaced). */
+  using Output = std::function<std::shared_ptr<SequenceBuffer>()>;
+
+  FramePipeline(std::vector<Stage> stages, Output output, size_t queueFrames)
+      : stages_(std::move(stages)),
+        output_(std::move(output)),
+        queueFrames_(queueFrames < 1 ? 1 : queueFrames),
+        worker_([this] { Run(); }) {}
+
+  ~FramePipeline() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    wake_.notify_all();
+    worker_.join();
+  }
+
+  FramePipeline(const FramePipeline &) = delete;
+  FramePipeline &operator=(const FramePipeline &) = delete;
+
+  /**
+   * Sizes the staging ring for frames of the given geometry.  Call before the camera starts
+   * inserting, once WaitIdle() has returned: this never waits, since the caller typically holds
+   * the camera's module lock, which a processor of the same module needs to finish a frame.
+   * Frames still queued in a ring of another geometry are discarded.
+   */
+  void Prepare(unsigned width, unsigned height, unsigned bytesPerPixel) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (staging_ && staging_->Matches(width, height, bytesPerPixel)) return;
+    staging_ = std::make_shared<SequenceBuffer>(width, height, bytesPerPixel, queueFrames_);
+  }
+
+  /**
+   * Queues one frame for processing.  Camera thread only.
+   *
+   * @param process If false the frame is handed on as is, in order with the processed ones.
+   * @return false if the frame doesn't match the prepared geometry or the queue is full.
+   */
+  bool Insert(const unsigned char *frame, unsigned width, unsigned height, unsigned bytesPerPixel,
+              bool process = true) {
+    std::shared_ptr<SequenceBuffer> staging;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      staging = staging_;
+    }
+    if (!staging || !staging->Matches(width, height, bytesPerPixel) ||
+        !staging->Insert(frame, process ? kProcess : 0))
+      return false;
+    {
+      // taken so that the worker can't miss the wakeup between its check and its wait
+      std::lock_guard<std::mutex> lock(mutex_);
+    }
+    wake_.notify_one();
+    return true;
+  }
+
+  /**
+   * Waits until every queued frame has been processed and handed on.
+   *
+   * @param timeoutMs How long to wait; negative means no limit.
+   * @return Whether the pipeline is idle.
+   */
+  bool WaitIdle(double timeoutMs) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (timeoutMs < 0) {
+      idle_.wait(lock, [this] { return IsIdle(); });
+      return true;
+    }
+    return idle_.wait_for(lock, std::chrono::duration<double, std::milli>(timeoutMs),
+                          [this] { return IsIdle(); });
+  }
+
+  uint64_t GetProcessedCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return processed_;
+  }
+
+  uint64_t GetErrorCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return errors_;
+  }
+
+  std::string GetLastError() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lastError_;
+  }
+
+  /** Frames dropped because the staging ring was full. */
+  uint64_t GetOverflowCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return staging_ ? staging_->GetOverflowCount() : 0;
+  }
+
+ private:
+  static constexpr uint32_t kProcess = 1;  // staging tag of frames that go through the stages
+
+  // Call with mutex_ held.
+  bool IsIdle() const { return !busy_ && (!staging_ || staging_->GetRemainingCount() == 0); }
+
+  void Run() {
+    std::vector<unsigned char> frame;
+    for (;;) {
+      std::shared_ptr<SequenceBuffer> staging;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        wake_.wait(lock, [this] {
+          return stopping_ || (staging_ && staging_->GetRemainingCount() > 0);
+        });
+        if (stopping_) return;
+        staging = staging_;
+        busy_ = true;
+      }
+
+      frame.resize(staging->GetFrameBytes());
+      uint32_t tag = 0;
+      while (staging->Pop(frame.data(), &tag)) {
+        const bool process = (tag & kProcess) != 0;
+        std::string error;
+        if (process) {
+          for (const Stage &stage : stages_) {
+            error = stage(frame.data(), staging->GetWidth(), staging->GetHeight(),
+                          staging->GetBytesPerPixel());
+            if (!error.empty()) break;
+          }
+        }
+        if (error.empty()) {
+          std::shared_ptr<SequenceBuffer> output = output_();
+          // a full output buffer counts the overflow itself
+          if (output && output->Matches(staging->GetWidth(), staging->GetHeight(),
+                                        staging->GetBytesPerPixel()))
+            output->Insert(frame.data());
+        }
+        if (!process) continue;
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++processed_;
+        if (!error.empty()) {
+          ++errors_;
+          lastError_ = std::move(error);
+        }
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        busy_ = false;
+      }
+      idle_.notify_all();
+    }
+  }
+
+  const std::vector<Stage> stages_;
+  const Output output_;
+  const size_t queueFrames_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable idle_;
+  std::shared_ptr<SequenceBuffer> staging_;
+  bool busy_ = false;
+  bool stopping_ = false;
+  uint64_t processed_ = 0;
+  uint64_t errors_ = 0;
+  std::string lastError_;
+
+  std::thread worker_;  // last, so it starts after everything it uses is constructed
+};
+
+/** The processing pipeline of every camera that has one, keyed by its raw device pointer. */
+inline DeviceRegistry<FramePipeline> &framePipelines() {
+  // leaked on purpose, like sequenceBuffers()
+  static DeviceRegistry<FramePipeline> *registry = new DeviceRegistry<FramePipeline>();
+  return *registry;
+}
@@ -0,0 +1,327 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/** A log message, as handed to a LogSink's outputs. */
+struct LogRecord {
+  std::chrono::system_clock::time_point time;
+  int level = 0;        // an mm::logging::LogLevel
+  uint32_t thread = 0;  // numbered in the order threads first logged
+  std::string label;    // the device's; empty for the core
+  std::string message;
+};
+
+/**
+ * Collects log messages from devices and writes them out on a thread of its own.
+ *
+ * Logging must not slow down the thread that logs (often a camera's acquisition thread), so
+ * Log() only filters and stages.  Each logging thread fills a fixed ring of its own without
+ * locking; a slot's strings keep their storage for the next message, and a full ring drops
+ * the message and counts it.  The writer thread collects the rings every `interval` (sooner
+ * when one fills up halfway), orders the batch by time and hands it to the log file and the
+ * handler.  Messages below the level of their label (or the default level) are dropped before
+ * staging, as is everything while no output is set.
+ */
+class LogSink {
+ public:
+  using Handler = std::function<void(const std::vector<LogRecord> &)>;
+
+  static const int kOff = 6;  // above mm::logging::LogLevelFatal
+
+  explicit LogSink(size_t ringCapacity = 1024,
+                   std::chrono::milliseconds interval = std::chrono::milliseconds(20))
+      : capacity_(std::max<size_t>(ringCapacity, 2)),
+        interval_(interval),
+        id_(NextId().fetch_add(1) + 1) {}
+
+  ~LogSink() { Stop(); }
+
+  LogSink(const LogSink &) = delete;
+  LogSink &operator=(const LogSink &) = delete;
+
+  /** Whether a message at `level` could be kept at all: one atomic load, any thread. */
+  bool Accepts(int level) const { return level >= threshold_.load(std::memory_order_relaxed); }
+
+  /** Stages a message.  Any thread; never blocks. */
+  void Log(const char *label, int level, const char *message) {
+    if (!Accepts(level) || level < GetLevel(label)) return;
+    Ring &ring = LocalRing();
+    size_t head = ring.head.load(std::memory_order_relaxed);
+    size_t pending = head - ring.tail.load(std::memory_order_acquire);
+    if (pending >= ring.slots.size()) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    LogRecord &slot = ring.slots[head % ring.slots.size()];
+    slot.time = std::chrono::system_clock::now();
+    slot.level = level;
+    slot.label.assign(label);
+    slot.message.assign(message);
+    ring.head.store(head + 1, std::memory_order_release);
+
+    // without waiting out the interval, so that a burst doesn't overflow the ring
+    if (pending + 1 == ring.slots.size() / 2 && !urgent_.exchange(true)) wake_.notify_one();
+  }
+
+  void Log(const std::string &label, int level, const char *message) {
+    Log(label.c_str(), level, message);
+  }
+
+  /** Sets the level of `label`'s messages, or the default level if `label` is empty. */
+  void SetLevel(int level, const std::string &label = "") {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto levels = std::make_shared<Levels>(*std::atomic_load(&levels_));
+    if (label.empty())
+      levels->defaultLevel = level;
+    else
+      levels->byLabel[label] = level;
+    std::atomic_store(&levels_, std::shared_ptr<const Levels>(std::move(levels)));
+    UpdateThreshold();
+  }
+
+  /** The level of `label`'s messages (the default level if `label` has none of its own). */
+  int GetLevel(const char *label) const {
+    std::shared_ptr<const Levels> levels = std::atomic_load(&levels_);
+    auto it = levels->byLabel.find(label);
+    return it == levels->byLabel.end() ? levels->defaultLevel : it->second;
+  }
+
+  /** Hands every batch to `handler` (on the writer thread); nullptr to stop. */
+  void SetHandler(Handler handler) {
+    Handler previous;  // destroyed after the lock is released
+    std::lock_guard<std::mutex> lock(mutex_);
+    previous = std::move(handler_);
+    handler_ = std::move(handler);
+    Start();
+    UpdateThreshold();
+  }
+
+  /** Appends every message to the file at `path`; an empty path closes it. */
+  void SetFile(const std::string &path) {
+    std::shared_ptr<std::ofstream> file;
+    if (!path.empty()) {
+      file = std::make_shared<std::ofstream>(path, std::ios::app);
+      if (!*file) throw std::runtime_error("Cannot open log file " + path);
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    file_ = std::move(file);
+    Start();
+    UpdateThreshold();
+  }
+
+  /** Waits until the messages staged so far have been handed to the outputs. */
+  void Flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!writer_.joinable()) return;
+    uint64_t target = ++flushRequested_;
+    wake_.notify_all();
+    flushed_.wait(lock, [&] { return flushedUpTo_ >= target || !writer_.joinable(); });
+  }
+
+  /** Delivers what is staged and stops the writer thread; until an output is set again,
+   * messages are dropped. */
+  void Stop() {
+    std::thread writer;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!writer_.joinable()) return;
+      stopping_ = true;
+      threshold_.store(kOff, std::memory_order_relaxed);
+      writer = std::move(writer_);
+    }
+    wake_.notify_all();
+    writer.join();
+    std::lock_guard<std::mutex> lock(mutex_);
+    flushed_.notify_all();
+  }
+
+  /** Messages dropped because their thread's ring was full. */
+  uint64_t GetDroppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+
+  /**
+   * Formats a record as MMCore does in CoreLog files:
+   * `2024-01-31T12:00:00.000000 tid3 [IFO,dev:Camera] message`.
+   */
+  static std::string Format(const LogRecord &record) {
+    static const char *const kLevels[] = {"trc", "dbg", "IFO", "WRN", "ERR", "FTL"};
+    std::time_t seconds = std::chrono::system_clock::to_time_t(record.time);
+    std::tm local{};
+#ifdef _WIN32
+    localtime_s(&local, &seconds);
+#else
+    localtime_r(&seconds, &local);
+#endif
+    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(
+                      record.time.time_since_epoch()).count() % 1000000;
+    char stamp[48];
+    size_t n = std::strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%S", &local);
+    std::snprintf(stamp + n, sizeof(stamp) - n, ".%06lld", static_cast<long long>(micros));
+
+    std::string line = stamp;
+    line += " tid" + std::to_string(record.thread) + " [";
+    line += record.level >= 0 && record.level < kOff ? kLevels[record.level] : "???";
+    line += record.label.empty() ? ",Core" : ",dev:" + record.label;
+    line += "] ";
+    line += record.message;
+    return line;
+  }
+
+ private:
+  struct Ring {
+    Ring(size_t capacity, uint32_t thread) : slots(capacity), thread(thread) {}
+    std::vector<LogRecord> slots;
+    std::atomic<size_t> head{0};  // next slot to fill; written by the logging thread only
+    std::atomic<size_t> tail{0};  // next slot to collect; written by the writer only
+    const uint32_t thread;
+  };
+
+  struct Levels {
+    int defaultLevel = 2;  // mm::logging::LogLevelInfo
+    std::map<std::string, int, std::less<>> byLabel;
+  };
+
+  static std::atomic<uint64_t> &NextId() {
+    static std::atomic<uint64_t> id{0};
+    return id;
+  }
+
+  // The calling thread's ring, registered with the sink on its first message.
+  Ring &LocalRing() {
+    // by sink id rather than address, which a later sink may reuse
+    thread_local std::vector<std::pair<uint64_t, std::shared_ptr<Ring>>> rings;
+    for (const auto &entry : rings)
+      if (entry.first == id_) return *entry.second;
+    std::shared_ptr<Ring> ring;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ring = std::make_shared<Ring>(capacity_, ++threadCount_);
+      rings_.push_back(ring);
+    }
+    rings.emplace_back(id_, ring);
+    return *ring;
+  }
+
+  // Under mutex_.
+  void UpdateThreshold() {
+    int threshold = kOff;
+    if (writer_.joinable() && (handler_ || file_)) {
+      std::shared_ptr<const Levels> levels = std::atomic_load(&levels_);
+      threshold = levels->defaultLevel;
+      for (const auto &entry : levels->byLabel) threshold = std::min(threshold, entry.second);
+    }
+    threshold_.store(threshold, std::memory_order_relaxed);
+  }
+
+  // Under mutex_: starts the writer once there is somewhere to write to.
+  void Start() {
+    if (writer_.joinable() || !(handler_ || file_)) return;
+    stopping_ = false;
+    writer_ = std::thread(&LogSink::Run, this);
+  }
+
+  void Run() {
+    std::vector<LogRecord> batch;
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+      wake_.wait_for(lock, interval_, [this] {
+        return stopping_ || flushRequested_ > flushedUpTo_ || urgent_.load();
+      });
+      urgent_.store(false);
+      bool stopping = stopping_;
+      uint64_t flushTarget = flushRequested_;
+      std::vector<std::shared_ptr<Ring>> rings = rings_;
+      Handler handler = handler_;
+      std::shared_ptr<std::ofstream> file = file_;
+      lock.unlock();
+
+      for (const std::shared_ptr<Ring> &ring : rings) Collect(*ring, batch);
+      if (!batch.empty()) Deliver(batch, handler, file);
+      handler = nullptr;  // dropped here, not under the lock
+      rings.clear();
+
+      lock.lock();
+      // forget the rings of threads that have exited, once they are empty
+      rings_.erase(std::remove_if(rings_.begin(), rings_.end(),
+                                  [](const std::shared_ptr<Ring> &ring) {
+                                    return ring.use_count() == 1 &&
+                                           ring->head.load() == ring->tail.load();
+                                  }),
+                   rings_.end());
+      flushedUpTo_ = flushTarget;
+      flushed_.notify_all();
+      if (stopping) return;
+    }
+  }
+
+  static void Collect(Ring &ring, std::vector<LogRecord> &batch) {
+    size_t tail = ring.tail.load(std::memory_order_relaxed);
+    size_t head = ring.head.load(std::memory_order_acquire);
+    for (; tail != head; ++tail) {
+      batch.push_back(ring.slots[tail % ring.slots.size()]);
+      batch.back().thread = ring.thread;
+      ring.tail.store(tail + 1, std::memory_order_release);
+    }
+  }
+
+  static void Deliver(std::vector<LogRecord> &batch, const Handler &handler,
+                      const std::shared_ptr<std::ofstream> &file) {
+    std::stable_sort(batch.begin(), batch.end(),
+                     [](const LogRecord &a, const LogRecord &b) { return a.time < b.time; });
+    if (file) {
+      for (const LogRecord &record : batch) *file << Format(record) << '\n';
+      file->flush();
+    }
+    if (handler) {
+      try {
+        handler(batch);
+      } catch (...) {
+        // a failing handler must not take the writer (and every later message) down with it
+      }
+    }
+    batch.clear();
+  }
+
+  const size_t capacity_;
+  const std::chrono::milliseconds interval_;
+  const uint64_t id_;
+
+  std::atomic<int> threshold_{kOff};
+  std::atomic<bool> urgent_{false};
+  std::atomic<uint64_t> dropped_{0};
+  std::shared_ptr<const Levels> levels_ = std::make_shared<const Levels>();
+
+  std::mutex mutex_;  // guards everything below
+  std::condition_variable wake_;
+  std::condition_variable flushed_;
+  std::vector<std::shared_ptr<Ring>> rings_;
+  uint32_t threadCount_ = 0;
+  Handler handler_;
+  std::shared_ptr<std::ofstream> file_;
+  std::thread writer_;
+  bool stopping_ = false;
+  uint64_t flushRequested_ = 0;
+  uint64_t flushedUpTo_ = 0;
+};
+
+/** The sink that every device's log messages go to. */
+inline LogSink &logSink() {
+  // leaked on purpose, like the registries; the module stops its writer at exit
+  static LogSink *sink = new LogSink();
+  return *sink;
+}
@@ -0,0 +1,274 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Pick the widest vector unit the compiler targets without extra flags: SSE2 is part of the
+// x86-64 baseline and NEON of the AArch64 one, so no runtime dispatch is needed.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PYMMDEVICE_HAVE_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define PYMMDEVICE_HAVE_NEON 1
+#endif
+#if defined(PYMMDEVICE_HAVE_SSE2) || defined(PYMMDEVICE_HAVE_NEON)
+#define PYMMDEVICE_HAVE_SIMD 1
+#endif
+
+namespace pixels {
+
+/**
+ * Converts packed BGRA pixels (Micro-Manager's RGB32 layout) to RGBA by swapping the blue and
+ * red bytes of each pixel.  Alpha is passed through unchanged.
+ *
+ * @param src `count` BGRA pixels (4 bytes each).
+ * @param dst Destination for `count` RGBA pixels; may be the same buffer as `src`.
+ * @param count The number of pixels.
+ */
+inline void bgraToRgba(const uint8_t *src, uint8_t *dst, size_t count) {
+  size_t i = 0;
+#if defined(PYMMDEVICE_HAVE_SSE2)
+  // as little-endian uint32 a BGRA pixel is 0xAARRGGBB; keep G and A, swap the low bytes of
+  // each 16-bit half
+  const __m128i keep = _mm_set1_epi32(static_cast<int>(0xFF00FF00u));
+  const __m128i low = _mm_set1_epi32(0x000000FF);
+  for (; i + 4 <= count; i += 4) {
+    __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 4 * i));
+    __m128i r = _mm_and_si128(_mm_srli_epi32(p, 16), low);
+    __m128i b = _mm_slli_epi32(_mm_and_si128(p, low), 16);
+    __m128i out = _mm_or_si128(_mm_and_si128(p, keep), _mm_or_si128(r, b));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 4 * i), out);
+  }
+#elif defined(PYMMDEVICE_HAVE_NEON)
+  for (; i + 16 <= count; i += 16) {
+    uint8x16x4_t p = vld4q_u8(src + 4 * i);
+    uint8x16_t blue = p.val[0];
+    p.val[0] = p.val[2];
+    p.val[2] = blue;
+    vst4q_u8(dst + 4 * i, p);
+  }
+#endif
+  for (; i < count; ++i) {
+    const uint8_t *s = src + 4 * i;
+    uint8_t *d = dst + 4 * i;
+    uint8_t blue = s[0];
+    d[0] = s[2];
+    d[1] = s[1];
+    d[2] = blue;
+    d[3] = s[3];
+  }
+}
+
+/** How sharp an image is, as scored by focusScore(). */
+enum class FocusMetric {
+  NormalizedVariance,  // intensity variance over mean intensity
+  Brenner,             // squared difference of pixels two apart along a row
+  Tenengrad,           // squared magnitude of the Sobel gradient
+};
+
+namespace detail {
+
+#if defined(PYMMDEVICE_HAVE_SIMD)
+// Four pixels at a time, widened to int32 so that gradients can't overflow: even a Sobel
+// response of 16-bit pixels stays below 2^19.
+#if defined(PYMMDEVICE_HAVE_SSE2)
+using Lanes = __m128i;
+
+inline Lanes load4(const uint8_t *p) {
+  int32_t word;
+  std::memcpy(&word, p, 4);
+  const __m128i zero = _mm_setzero_si128();
+  return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(word), zero), zero);
+}
+inline Lanes load4(const uint16_t *p) {
+  return _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p)),
+                            _mm_setzero_si128());
+}
+inline Lanes add(Lanes a, Lanes b) { return _mm_add_epi32(a, b); }
+inline Lanes sub(Lanes a, Lanes b) { return _mm_sub_epi32(a, b); }
+inline Lanes twice(Lanes a) { return _mm_slli_epi32(a, 1); }
+
+// Sums of lanes and of their squares, kept in 64-bit lanes.
+class Sums {
+ public:
+  void AddValues(Lanes v) {  // non-negative lanes only
+    const __m128i zero = _mm_setzero_si128();
+    values_ = _mm_add_epi64(values_, _mm_add_epi64(_mm_unpacklo_epi32(v, zero),
+                                                   _mm_unpackhi_epi32(v, zero)));
+  }
+  void AddSquares(Lanes v) {
+    // SSE2 only multiplies unsigned 32-bit lanes 0 and 2 (into 64 bits), so square |v|, then
+    // the odd lanes shifted down
+    const __m128i sign = _mm_srai_epi32(v, 31);
+    const __m128i abs = _mm_sub_epi32(_mm_xor_si128(v, sign), sign);
+    const __m128i odd = _mm_srli_epi64(abs, 32);
+    squares_ = _mm_add_epi64(squares_, _mm_add_epi64(_mm_mul_epu32(abs, abs),
+                                                     _mm_mul_epu32(odd, odd)));
+  }
+  uint64_t Values() const { return Total(values_); }
+  uint64_t Squares() const { return Total(squares_); }
+
+ private:
+  static uint64_t Total(__m128i v) {
+    uint64_t halves[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(halves), v);
+    return halves[0] + halves[1];
+  }
+
+  __m128i values_ = _mm_setzero_si128();
+  __m128i squares_ = _mm_setzero_si128();
+};
+#else
+using Lanes = int32x4_t;
+
+inline Lanes load4(const uint8_t *p) {
+  uint32_t word;
+  std::memcpy(&word, p, 4);
+  uint16x8_t wide = vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(word)));
+  return vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(wide)));
+}
+inline Lanes load4(const uint16_t *p) { return vreinterpretq_s32_u32(vmovl_u16(vld1_u16(p))); }
+inline Lanes add(Lanes a, Lanes b) { return vaddq_s32(a, b); }
+inline Lanes sub(Lanes a, Lanes b) { return vsubq_s32(a, b); }
+inline Lanes twice(Lanes a) { return vshlq_n_s32(a, 1); }
+
+// Sums of lanes and of their squares, kept in 64-bit lanes.
+class Sums {
+ public:
+  void AddValues(Lanes v) { values_ = vpadalq_u32(values_, vreinterpretq_u32_s32(v)); }
+  void AddSquares(Lanes v) {
+    uint32x4_t abs = vreinterpretq_u32_s32(vabsq_s32(v));
+    squares_ = vmlal_u32(squares_, vget_low_u32(abs), vget_low_u32(abs));
+    squares_ = vmlal_u32(squares_, vget_high_u32(abs), vget_high_u32(abs));
+  }
+  uint64_t Values() const { return vgetq_lane_u64(values_, 0) + vgetq_lane_u64(values_, 1); }
+  uint64_t Squares() const { return vgetq_lane_u64(squares_, 0) + vgetq_lane_u64(squares_, 1); }
+
+ private:
+  uint64x2_t values_ = vdupq_n_u64(0);
+  uint64x2_t squares_ = vdupq_n_u64(0);
+};
+#endif
+#endif
+
+// The sum of the pixels and of their squares.
+template <typename T>
+void intensitySums(const T *image, size_t count, uint64_t &sum, uint64_t &squares) {
+  size_t i = 0;
+  sum = squares = 0;
+#if defined(PYMMDEVICE_HAVE_SIMD)
+  Sums sums;
+  for (; i + 4 <= count; i += 4) {
+    Lanes v = load4(image + i);
+    sums.AddValues(v);
+    sums.AddSquares(v);
+  }
+  sum = sums.Values();
+  squares = sums.Squares();
+#endif
+  for (; i < count; ++i) {
+    uint64_t p = image[i];
+    sum += p;
+    squares += p * p;
+  }
+}
+
+// The sum over every row of (p[x + 2] - p[x])^2.
+template <typename T>
+uint64_t brennerSum(const T *image, size_t width, size_t height) {
+  uint64_t total = 0;
+#if defined(PYMMDEVICE_HAVE_SIMD)
+  Sums sums;
+#endif
+  for (size_t y = 0; y < height; ++y) {
+    const T *row = image + y * width;
+    size_t x = 0;
+#if defined(PYMMDEVICE_HAVE_SIMD)
+    for (; x + 6 <= width; x += 4) sums.AddSquares(sub(load4(row + x + 2), load4(row + x)));
+#endif
+    for (; x + 2 < width; ++x) {
+      int64_t d = static_cast<int64_t>(row[x + 2]) - row[x];
+      total += static_cast<uint64_t>(d * d);
+    }
+  }
+#if defined(PYMMDEVICE_HAVE_SIMD)
+  total += sums.Squares();
+#endif
+  return total;
+}
+
+// The sum over the interior pixels of Gx^2 + Gy^2, with G the 3x3 Sobel gradient.
+template <typename T>
+uint64_t tenengradSum(const T *image, size_t width, size_t height) {
+  uint64_t total = 0;
+#if defined(PYMMDEVICE_HAVE_SIMD)
+  Sums sums;
+#endif
+  for (size_t y = 1; y + 1 < height; ++y) {
+    const T *up = image + (y - 1) * width;
+    const T *mid = up + width;
+    const T *down = mid + width;
+    size_t x = 1;
+#if defined(PYMMDEVICE_HAVE_SIMD)
+    for (; x + 5 <= width; x += 4) {
+      Lanes ul = load4(up + x - 1), ur = load4(up + x + 1);
+      Lanes dl = load4(down + x - 1), dr = load4(down + x + 1);
+      Lanes gx = sub(add(add(ur, dr), twice(load4(mid + x + 1))),
+                     add(add(ul, dl), twice(load4(mid + x - 1))));
+      Lanes gy = sub(add(add(dl, dr), twice(load4(down + x))),
+                     add(add(ul, ur), twice(load4(up + x))));
+      sums.AddSquares(gx);
+      sums.AddSquares(gy);
+    }
+#endif
+    for (; x + 1 < width; ++x) {
+      int64_t gx = (static_cast<int64_t>(up[x + 1]) + 2 * mid[x + 1] + down[x + 1]) -
+                   (static_cast<int64_t>(up[x - 1]) + 2 * mid[x - 1] + down[x - 1]);
+      int64_t gy = (static_cast<int64_t>(down[x - 1]) + 2 * down[x] + down[x + 1]) -
+                   (static_cast<int64_t>(up[x - 1]) + 2 * up[x] + up[x + 1]);
+      total += static_cast<uint64_t>(gx * gx + gy * gy);
+    }
+  }
+#if defined(PYMMDEVICE_HAVE_SIMD)
+  total += sums.Squares();
+#endif
+  return total;
+}
+
+}  // namespace detail
+
+/**
+ * Scores the sharpness of a grayscale image in place; higher is sharper.  Brenner and
+ * Tenengrad are averaged over the pixels they cover, so that scores don't depend on the image
+ * size.  Sums are exact (64-bit integers) for any image of up to 2^26 pixels.
+ *
+ * @param image `width` x `height` pixels, row by row without padding.
+ */
+template <typename T>
+double focusScore(const T *image, size_t width, size_t height, FocusMetric metric) {
+  switch (metric) {
+    case FocusMetric::NormalizedVariance: {
+      const size_t count = width * height;
+      uint64_t sum, squares;
+      detail::intensitySums(image, count, sum, squares);
+      if (sum == 0) return 0;
+      const double mean = static_cast<double>(sum) / count;
+      const double variance = static_cast<double>(squares) / count - mean * mean;
+      return std::max(variance, 0.0) / mean;
+    }
+    case FocusMetric::Brenner:
+      if (width < 3 || height == 0) return 0;
+      return static_cast<double>(detail::brennerSum(image, width, height)) /
+             (height * (width - 2));
+    case FocusMetric::Tenengrad:
+      if (width < 3 || height < 3) return 0;
+      return static_cast<double>(detail::tenengradSum(image, width, height)) /
+             ((height - 2) * (width - 2));
+  }
+  return 0;
+}
+
+}  // namespace pixels
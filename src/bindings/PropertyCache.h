@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "DeviceRegistry.h"
+
+/**
+ * Last known values of a device's properties, so repeated reads need not reach the adapter.
+ *
+ * Entries are filled by reads that missed (and by a full sweep after Initialize), and are
+ * replaced or dropped as the device reports changes through MM::Core::OnPropertyChanged and
+ * OnPropertiesChanged, or as properties are set through the bindings.  A read that misses
+ * takes a generation ticket first; if anything was invalidated while it was talking to the
+ * device, its (possibly stale) result is returned but not stored.
+ */
+class PropertyCache {
+ public:
+  /**
+   * Look up a property, counting a hit or a miss.
+   *
+   * @param name The property name.
+   * @param value Receives the cached value on a hit.
+   * @param generation Receives the ticket to pass to Fill() on a miss.
+   * @return true on a hit.
+   */
+  bool Lookup(const std::string &name, std::string &value, uint64_t &generation) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = values_.find(name);
+    if (it == values_.end()) {
+      generation = generation_;
+      misses_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    value = it->second;
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  /** Store a value read from the device, unless the cache was invalidated since `generation`. */
+  void Fill(const std::string &name, const std::string &value, uint64_t generation) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (generation == generation_) values_[name] = value;
+  }
+
+  /** Store a value the device reported as current. */
+  void Update(const std::string &name, const std::string &value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++generation_;
+    values_[name] = value;
+  }
+
+  void Invalidate(const std::string &name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++generation_;
+    values_.erase(name);
+  }
+
+  void Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++generation_;
+    values_.clear();
+  }
+
+  uint64_t GetGeneration() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return generation_;
+  }
+
+  size_t GetSize() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return values_.size();
+  }
+
+  uint64_t GetHitCount() const { return hits_.load(std::memory_order_relaxed); }
+  uint64_t GetMissCount() const { return misses_.load(std::memory_order_relaxed); }
+
+ private:
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, std::string> values_;
+  uint64_t generation_ = 0;
+  std::atomic<uint64_t> hits_{0};
+  std::atomic<uint64_t> misses_{0};
+};
+
+/** The property cache of every device that has opted in, keyed by its raw device pointer. */
+inline DeviceRegistry<PropertyCache> &propertyCaches() {
+  // leaked like sequenceBuffers(): device threads may report changes during shutdown
+  static DeviceRegistry<PropertyCache> *registry = new DeviceRegistry<PropertyCache>();
+  return *registry;
+}
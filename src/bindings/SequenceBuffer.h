@@ -0,0 +1,186 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "DeviceRegistry.h"
+
+/**
+ * Preallocated ring of equally sized frame slots for sequence acquisition.
+ *
+ * One producer (the camera's acquisition thread, via MM::Core::InsertImage) copies frames in
+ * and any number of consumers pop them out.  Neither side takes a lock: each slot carries a
+ * sequence number that hands it back and forth between producer and consumers (a bounded
+ * Vyukov queue), so inserting a frame never waits on Python or the GIL.  When every slot is
+ * full the incoming frame is dropped and counted as an overflow.
+ *
+ * For multi-ROI acquisitions the buffer can keep just the ROI pixels of each frame, so the
+ * rest of the sensor never costs a copy.
+ *
+ * Each slot also carries a small tag that the producer sets with the frame and the consumer
+ * gets back with it, for flags that must stay in order with the frames they describe.
+ */
+class SequenceBuffer {
+ public:
+  /** A rectangle of pixels within an incoming frame. */
+  struct Rect {
+    unsigned x, y, width, height;
+
+    bool operator==(const Rect &other) const {
+      return x == other.x && y == other.y && width == other.width && height == other.height;
+    }
+  };
+
+  /**
+   * @param width, height, bytesPerPixel Geometry of the frames the camera will insert.
+   * @param capacity Number of frame slots.
+   * @param rois If not empty, only these regions of each incoming frame are stored, packed
+   *     one after the other (each row-major), instead of the whole frame.  They must lie
+   *     within the frame.
+   */
+  SequenceBuffer(unsigned width, unsigned height, unsigned bytesPerPixel, size_t capacity,
+                 std::vector<Rect> rois = {})
+      : width_(width),
+        height_(height),
+        bytesPerPixel_(bytesPerPixel),
+        rois_(std::move(rois)),
+        frameBytes_(FrameBytes(width, height, bytesPerPixel, rois_)),
+        capacity_(capacity < 1 ? 1 : capacity),
+        sequence_(new std::atomic<uint64_t>[capacity_]),
+        data_(frameBytes_ * capacity_),
+        tags_(capacity_) {
+    Clear();
+  }
+
+  /** Bytes stored per frame for the given geometry and ROIs (see the constructor). */
+  static size_t FrameBytes(unsigned width, unsigned height, unsigned bytesPerPixel,
+                           const std::vector<Rect> &rois) {
+    if (rois.empty()) return static_cast<size_t>(width) * height * bytesPerPixel;
+    size_t pixels = 0;
+    for (const Rect &roi : rois) pixels += static_cast<size_t>(roi.width) * roi.height;
+    return pixels * bytesPerPixel;
+  }
+
+  unsigned GetWidth() const { return width_; }
+  unsigned GetHeight() const { return height_; }
+  unsigned GetBytesPerPixel() const { return bytesPerPixel_; }
+  size_t GetFrameBytes() const { return frameBytes_; }
+  size_t GetCapacity() const { return capacity_; }
+  const std::vector<Rect> &GetROIs() const { return rois_; }
+
+  bool Matches(unsigned width, unsigned height, unsigned bytesPerPixel) const {
+    return width == width_ && height == height_ && bytesPerPixel == bytesPerPixel_;
+  }
+
+  /**
+   * Copy one width x height frame (or just its ROIs) into the next free slot.  Producer side
+   * only.
+   *
+   * @param tag Stored with the frame and handed back by Pop().
+   * @return false if the buffer was full and the frame was dropped.
+   */
+  bool Insert(const unsigned char *frame, uint32_t tag = 0) {
+    uint64_t pos = head_.load(std::memory_order_relaxed);
+    std::atomic<uint64_t> &seq = sequence_[pos % capacity_];
+    if (seq.load(std::memory_order_acquire) != pos) {
+      overflows_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    if (rois_.empty()) {
+      std::memcpy(Slot(pos), frame, frameBytes_);
+    } else {
+      unsigned char *dest = Slot(pos);
+      const size_t stride = static_cast<size_t>(width_) * bytesPerPixel_;
+      for (const Rect &roi : rois_) {
+        const size_t rowBytes = static_cast<size_t>(roi.width) * bytesPerPixel_;
+        const unsigned char *src = frame + roi.y * stride + roi.x * bytesPerPixel_;
+        for (unsigned row = 0; row < roi.height; ++row, src += stride, dest += rowBytes)
+          std::memcpy(dest, src, rowBytes);
+      }
+    }
+    tags_[pos % capacity_] = tag;
+    seq.store(pos + 1, std::memory_order_release);
+    head_.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Copy the oldest frame into `dest` (GetFrameBytes() bytes) and free its slot.  If `dest` is
+   * null the frame is discarded.
+   *
+   * @param tag If not null, receives the tag the frame was inserted with.
+   * @return false if there was nothing to pop.
+   */
+  bool Pop(unsigned char *dest, uint32_t *tag = nullptr) {
+    uint64_t pos = tail_.load(std::memory_order_relaxed);
+    for (;;) {
+      uint64_t seq = sequence_[pos % capacity_].load(std::memory_order_acquire);
+      if (seq == pos + 1) {
+        if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+      } else if (seq < pos + 1) {
+        return false;  // the producer hasn't filled this slot yet
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);  // another consumer got here first
+      }
+    }
+    if (dest != nullptr) std::memcpy(dest, Slot(pos), frameBytes_);
+    if (tag != nullptr) *tag = tags_[pos % capacity_];
+    sequence_[pos % capacity_].store(pos + capacity_, std::memory_order_release);
+    return true;
+  }
+
+  size_t GetRemainingCount() const {
+    uint64_t tail = tail_.load(std::memory_order_acquire);
+    uint64_t head = head_.load(std::memory_order_acquire);
+    return head > tail ? static_cast<size_t>(head - tail) : 0;
+  }
+
+  uint64_t GetInsertedCount() const { return head_.load(std::memory_order_acquire); }
+  uint64_t GetOverflowCount() const { return overflows_.load(std::memory_order_relaxed); }
+
+  /** Pop and discard every available frame.  Safe to call from any thread. */
+  size_t Discard() {
+    size_t n = 0;
+    while (Pop(nullptr)) ++n;
+    return n;
+  }
+
+  /** Drop all frames and reset the counters.  Not safe while the camera is inserting. */
+  void Clear() {
+    for (size_t i = 0; i < capacity_; ++i) sequence_[i].store(i, std::memory_order_relaxed);
+    head_.store(0, std::memory_order_relaxed);
+    tail_.store(0, std::memory_order_relaxed);
+    overflows_.store(0, std::memory_order_release);
+  }
+
+ private:
+  unsigned char *Slot(uint64_t pos) { return data_.data() + (pos % capacity_) * frameBytes_; }
+
+  const unsigned width_;
+  const unsigned height_;
+  const unsigned bytesPerPixel_;
+  const std::vector<Rect> rois_;
+  const size_t frameBytes_;
+  const size_t capacity_;
+  std::unique_ptr<std::atomic<uint64_t>[]> sequence_;
+  std::vector<unsigned char> data_;
+  std::vector<uint32_t> tags_;
+
+  // keep the producer and consumer cursors on separate cache lines
+  std::atomic<uint64_t> head_;
+  char padHead_[64 - sizeof(std::atomic<uint64_t>)];
+  std::atomic<uint64_t> tail_;
+  char padTail_[64 - sizeof(std::atomic<uint64_t>)];
+  std::atomic<uint64_t> overflows_;
+};
+
+/** The sequence buffer of every camera that has one, keyed by its raw device pointer. */
+inline DeviceRegistry<SequenceBuffer> &sequenceBuffers() {
+  // leaked on purpose: camera threads may still insert while the interpreter shuts down
+  static DeviceRegistry<SequenceBuffer> *registry = new DeviceRegistry<SequenceBuffer>();
+  return *registry;
+}
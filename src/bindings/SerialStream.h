@@ -0,0 +1,84 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+
+#include "DeviceRegistry.h"
+#include "MMDeviceConstants.h"
+
+/**
+ * Buffered reading from a serial port.
+ *
+ * Reading up to a terminator in large chunks can pick up the start of the next answer (e.g.
+ * when several commands are in flight); those bytes are kept here and handed out first by the
+ * next read.  Not synchronized: use it under the port's module lock, like the port itself.
+ */
+class SerialStream {
+ public:
+  /** SerialInstance::Read: fills up to `len` bytes, setting how many it read. */
+  using ReadFn = std::function<int(unsigned char *buf, unsigned long len, unsigned long &read)>;
+
+  /** Reads up to `len` bytes: buffered ones first, then whatever the port has. */
+  int Read(const ReadFn &read, unsigned char *buf, size_t len, size_t &count) {
+    count = std::min(len, pending_.size());
+    std::memcpy(buf, pending_.data(), count);
+    pending_.erase(0, count);
+    if (count == len) return DEVICE_OK;
+    unsigned long got = 0;
+    int ret = read(buf + count, static_cast<unsigned long>(len - count), got);
+    count += got;
+    return ret;
+  }
+
+  /**
+   * Reads until `term` arrives, putting what came before it in `answer` and keeping anything
+   * after it for later.
+   *
+   * @return DEVICE_OK, the port's error, or DEVICE_SERIAL_TIMEOUT if `deadline` passed first.
+   */
+  int ReadUntil(const ReadFn &read, const std::string &term,
+                std::chrono::steady_clock::time_point deadline, std::string &answer) {
+    size_t searched = 0;  // no terminator starts before here
+    for (;;) {
+      size_t end = pending_.find(term, searched);
+      if (end != std::string::npos) {
+        answer.assign(pending_, 0, end);
+        pending_.erase(0, end + term.size());
+        return DEVICE_OK;
+      }
+      searched = pending_.size() >= term.size() ? pending_.size() - term.size() + 1 : 0;
+
+      unsigned char chunk[kChunkBytes];
+      unsigned long got = 0;
+      int ret = read(chunk, kChunkBytes, got);
+      if (ret != DEVICE_OK) return ret;
+      if (got > 0) {
+        pending_.append(reinterpret_cast<const char *>(chunk), got);
+      } else if (std::chrono::steady_clock::now() >= deadline) {
+        return DEVICE_SERIAL_TIMEOUT;
+      } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+      }
+    }
+  }
+
+  /** Drops the buffered bytes (e.g. when the port is purged). */
+  void Clear() { pending_.clear(); }
+
+  size_t GetBufferedCount() const { return pending_.size(); }
+
+ private:
+  static const unsigned long kChunkBytes = 4096;
+
+  std::string pending_;
+};
+
+/** The read buffer of every serial port that has been read through, by raw device pointer. */
+inline DeviceRegistry<SerialStream> &serialStreams() {
+  static DeviceRegistry<SerialStream> *registry = new DeviceRegistry<SerialStream>();
+  return *registry;
+}
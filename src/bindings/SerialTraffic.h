@@ -0,0 +1,457 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "DeviceRegistry.h"
+#include "MMDeviceConstants.h"
+#include "SerialStream.h"
+
+/**
+ * What happened on a serial port, as stored in a recording.
+ *
+ * A recording file starts with the 8 bytes "MMSERIAL" and a uint32 format version, followed by
+ * one record per event: uint64 microseconds since the recording started, uint16 port id,
+ * uint8 kind, uint32 length and that many bytes of data (all little-endian).  A PortName
+ * record, whose data is the port's label, precedes the first event of each port id.
+ */
+enum class SerialEvent : uint8_t { PortName = 0, Write = 1, Read = 2, Purge = 3 };
+
+namespace serial_traffic {
+
+static const char kMagic[8] = {'M', 'M', 'S', 'E', 'R', 'I', 'A', 'L'};
+static const uint32_t kVersion = 1;
+
+inline void putLE(std::string &out, uint64_t value, int bytes) {
+  for (int i = 0; i < bytes; ++i) out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+}
+
+inline uint64_t getLE(const unsigned char *in, int bytes) {
+  uint64_t value = 0;
+  for (int i = bytes - 1; i >= 0; --i) value = (value << 8) | in[i];
+  return value;
+}
+
+// For error messages: the bytes, with anything unprintable escaped.
+inline std::string printable(const std::string &data) {
+  static const char hex[] = "0123456789abcdef";
+  std::string out = "\"";
+  for (unsigned char c : data) {
+    if (c >= 0x20 && c < 0x7f && c != '"' && c != '\\') {
+      out.push_back(static_cast<char>(c));
+    } else {
+      out += "\\x";
+      out.push_back(hex[c >> 4]);
+      out.push_back(hex[c & 0xf]);
+    }
+  }
+  return out + "\"";
+}
+
+}  // namespace serial_traffic
+
+/**
+ * Writes the traffic of one or more serial ports to a recording file.
+ *
+ * Ports record through whichever path reaches them (the SerialInstance bindings or an
+ * adapter's MM::Core serial calls), possibly from several threads; events are timestamped and
+ * appended under a mutex, so the file holds them in the order they happened.
+ */
+class SerialRecorder {
+ public:
+  /** @throws std::runtime_error if the file can't be created. */
+  explicit SerialRecorder(const std::string &path)
+      : file_(path, std::ios::binary | std::ios::trunc),
+        start_(std::chrono::steady_clock::now()) {
+    if (!file_) throw std::runtime_error("Cannot create serial recording " + path);
+    std::string header(serial_traffic::kMagic, sizeof(serial_traffic::kMagic));
+    serial_traffic::putLE(header, serial_traffic::kVersion, 4);
+    file_.write(header.data(), static_cast<std::streamsize>(header.size()));
+  }
+
+  ~SerialRecorder() { Close(); }
+
+  SerialRecorder(const SerialRecorder &) = delete;
+  SerialRecorder &operator=(const SerialRecorder &) = delete;
+
+  /** Appends one event; ignored once the recorder is closed. */
+  void Record(const std::string &port, SerialEvent kind, const unsigned char *data,
+              size_t length) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!file_.is_open()) return;
+    uint64_t us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                            std::chrono::steady_clock::now() - start_)
+                                            .count());
+    auto id = portIds_.find(port);
+    if (id == portIds_.end()) {
+      if (portIds_.size() > 0xffff) return;
+      id = portIds_.emplace(port, static_cast<uint16_t>(portIds_.size())).first;
+      Append(us, id->second, SerialEvent::PortName,
+             reinterpret_cast<const unsigned char *>(port.data()), port.size());
+    }
+    Append(us, id->second, kind, data, length);
+    ++events_;
+    bytes_ += length;
+  }
+
+  /** Notes that `port` records here (the bindings attach it in serialRecorders()). */
+  void AddPort(const std::string &port) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ports_.insert(port);
+  }
+
+  void RemovePort(const std::string &port) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ports_.erase(port);
+  }
+
+  std::vector<std::string> GetPortNames() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return std::vector<std::string>(ports_.begin(), ports_.end());
+  }
+
+  /** Flushes and closes the file. */
+  void Close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_.is_open()) file_.close();
+  }
+
+  bool IsOpen() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return file_.is_open();
+  }
+
+  uint64_t GetEventCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return events_;
+  }
+
+  /** Data bytes recorded, in both directions. */
+  uint64_t GetByteCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytes_;
+  }
+
+ private:
+  // Call with mutex_ held.
+  void Append(uint64_t us, uint16_t id, SerialEvent kind, const unsigned char *data,
+              size_t length) {
+    std::string record;
+    record.reserve(15 + length);
+    serial_traffic::putLE(record, us, 8);
+    serial_traffic::putLE(record, id, 2);
+    serial_traffic::putLE(record, static_cast<uint8_t>(kind), 1);
+    serial_traffic::putLE(record, length, 4);
+    record.append(reinterpret_cast<const char *>(data), length);
+    file_.write(record.data(), static_cast<std::streamsize>(record.size()));
+  }
+
+  mutable std::mutex mutex_;
+  std::ofstream file_;
+  const std::chrono::steady_clock::time_point start_;
+  std::set<std::string> ports_;
+  std::map<std::string, uint16_t> portIds_;  // of the ports seen so far
+  uint64_t events_ = 0;
+  uint64_t bytes_ = 0;
+};
+
+/**
+ * Plays a recording back in place of the hardware, one simulated device per recorded port.
+ *
+ * Each port expects the writes and purges it recorded, in order, and answers with the bytes it
+ * recorded reading.  Bytes read after a write become available only once that write has been
+ * replayed, after the recorded delay (times `timeScale`; 0 makes every answer immediate), so
+ * the adapter under test sees the device's original latencies wherever its own code is
+ * faster or slower.  A write or purge that departs from the recording counts as a mismatch; in
+ * strict mode it is also refused with DEVICE_SERIAL_COMMAND_FAILED.
+ */
+class SerialReplay {
+ public:
+  /** @throws std::runtime_error if the file is missing or not a valid recording. */
+  SerialReplay(const std::string &path, double timeScale, bool strict, double answerTimeoutMs)
+      : timeScale_(timeScale < 0 ? 0 : timeScale),
+        strict_(strict),
+        answerTimeoutMs_(answerTimeoutMs) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) throw std::runtime_error("Cannot open serial recording " + path);
+    std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    Parse(path, contents);
+    Rewind();
+  }
+
+  SerialReplay(const SerialReplay &) = delete;
+  SerialReplay &operator=(const SerialReplay &) = delete;
+
+  std::vector<std::string> GetPortNames() const {
+    std::vector<std::string> names;
+    for (const auto &port : ports_) names.push_back(port.first);
+    return names;
+  }
+
+  bool HasPort(const std::string &port) const { return ports_.count(port) > 0; }
+
+  /** How long adapters' GetSerialAnswer calls wait, standing in for the port's AnswerTimeout. */
+  double GetAnswerTimeoutMs() const { return answerTimeoutMs_; }
+
+  /** Starts over from the beginning of the recording. */
+  void Rewind() {
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    for (auto &entry : ports_) {
+      Port &port = *entry.second;
+      std::lock_guard<std::mutex> lock(port.mutex);
+      port.nextHost = port.Next(0, true);
+      port.nextRead = port.Next(0, false);
+      port.readOffset = 0;
+      port.anchorWall = now;
+      port.anchorUs = 0;
+      port.stream.Clear();
+    }
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    mismatches_ = 0;
+    lastMismatch_.clear();
+  }
+
+  int Write(const std::string &name, const unsigned char *buf, unsigned long length) {
+    Port *port = Find(name);
+    if (!port) return DEVICE_SERIAL_COMMAND_FAILED;
+    std::lock_guard<std::mutex> lock(port->mutex);
+    return Consume(name, *port, SerialEvent::Write,
+                   std::string(reinterpret_cast<const char *>(buf), length));
+  }
+
+  int Purge(const std::string &name) {
+    Port *port = Find(name);
+    if (!port) return DEVICE_SERIAL_COMMAND_FAILED;
+    std::lock_guard<std::mutex> lock(port->mutex);
+    int ret = Consume(name, *port, SerialEvent::Purge, std::string());
+    if (ret != DEVICE_OK) return ret;
+    // whatever the device had sent by the time of the purge is gone
+    port->stream.Clear();
+    while (port->nextRead < port->nextHost)
+      port->nextRead = port->Next(port->nextRead + 1, false);
+    port->readOffset = 0;
+    return DEVICE_OK;
+  }
+
+  /** Reads the bytes that have "arrived", up to `length`, without waiting. */
+  int Read(const std::string &name, unsigned char *buf, unsigned long length,
+           unsigned long &read) {
+    read = 0;
+    Port *port = Find(name);
+    if (!port) return DEVICE_SERIAL_COMMAND_FAILED;
+    std::lock_guard<std::mutex> lock(port->mutex);
+    size_t count = 0;
+    int ret = port->stream.Read(Reader(*port), buf, length, count);
+    read = static_cast<unsigned long>(count);
+    return ret;
+  }
+
+  /** Reads up to `term`, waiting at most `timeoutMs` for the recorded answer to arrive. */
+  int GetAnswer(const std::string &name, const std::string &term, double timeoutMs,
+                std::string &answer) {
+    Port *port = Find(name);
+    if (!port) return DEVICE_SERIAL_COMMAND_FAILED;
+    std::lock_guard<std::mutex> lock(port->mutex);
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                        std::chrono::duration<double, std::milli>(timeoutMs));
+    return port->stream.ReadUntil(Reader(*port), term, deadline, answer);
+  }
+
+  /** Whether `name` has recorded bytes left to serve, due yet or not (false if unknown). */
+  bool HasReadsLeft(const std::string &name) {
+    Port *port = Find(name);
+    if (!port) return false;
+    std::lock_guard<std::mutex> lock(port->mutex);
+    return port->stream.GetBufferedCount() > 0 || port->nextRead < port->events.size();
+  }
+
+  /** Whether every recorded event has been replayed. */
+  bool IsFinished() const {
+    for (const auto &entry : ports_) {
+      const Port &port = *entry.second;
+      std::lock_guard<std::mutex> lock(port.mutex);
+      if (port.nextHost < port.events.size() || port.nextRead < port.events.size())
+        return false;
+    }
+    return true;
+  }
+
+  uint64_t GetMismatchCount() const {
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    return mismatches_;
+  }
+
+  std::string GetLastMismatch() const {
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    return lastMismatch_;
+  }
+
+ private:
+  struct Event {
+    uint64_t us;
+    SerialEvent kind;
+    std::string data;
+  };
+
+  struct Port {
+    std::vector<Event> events;
+    mutable std::mutex mutex;
+    size_t nextHost = 0;    // next write or purge to expect
+    size_t nextRead = 0;    // next read to serve; only served once every earlier write was
+    size_t readOffset = 0;  // bytes of events[nextRead] already served
+    std::chrono::steady_clock::time_point anchorWall;  // when the last write was replayed...
+    uint64_t anchorUs = 0;                             // ...and when it was recorded
+    SerialStream stream;                               // for GetAnswer's leftovers
+
+    // The first write/purge (host) or read event at or after `i`.
+    size_t Next(size_t i, bool host) const {
+      while (i < events.size() && (events[i].kind != SerialEvent::Read) != host) ++i;
+      return i;
+    }
+  };
+
+  Port *Find(const std::string &name) {
+    auto it = ports_.find(name);
+    return it == ports_.end() ? nullptr : it->second.get();
+  }
+
+  // Serves the recorded reads that are due.  Call with the port's mutex held.
+  SerialStream::ReadFn Reader(Port &port) {
+    return [this, &port](unsigned char *buf, unsigned long length, unsigned long &read) {
+      read = 0;
+      std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+      while (read < length && port.nextRead < port.nextHost) {
+        const Event &event = port.events[port.nextRead];
+        double delayUs = (static_cast<double>(event.us) - port.anchorUs) * timeScale_;
+        auto due = port.anchorWall +
+                   std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                       std::chrono::duration<double, std::micro>(delayUs));
+        if (delayUs > 0 && now < due) break;
+        size_t n = std::min<size_t>(length - read, event.data.size() - port.readOffset);
+        std::memcpy(buf + read, event.data.data() + port.readOffset, n);
+        read += static_cast<unsigned long>(n);
+        port.readOffset += n;
+        if (port.readOffset == event.data.size()) {
+          port.nextRead = port.Next(port.nextRead + 1, false);
+          port.readOffset = 0;
+        }
+      }
+      return DEVICE_OK;
+    };
+  }
+
+  // Replays the next write or purge, checking it against the recording.  Call with the port's
+  // mutex held.
+  int Consume(const std::string &name, Port &port, SerialEvent kind, const std::string &data) {
+    const char *what = kind == SerialEvent::Write ? "write" : "purge";
+    std::string mismatch;
+    if (port.nextHost == port.events.size()) {
+      mismatch = std::string("unexpected ") + what + " after the end of the recording";
+    } else {
+      const Event &expected = port.events[port.nextHost];
+      if (expected.kind != kind)
+        mismatch = std::string("expected ") +
+                   (expected.kind == SerialEvent::Write ? "a write" : "a purge") + ", got a " +
+                   what;
+      else if (expected.data != data)
+        mismatch = "expected write " + serial_traffic::printable(expected.data) + ", got " +
+                   serial_traffic::printable(data);
+    }
+    if (!mismatch.empty()) {
+      std::lock_guard<std::mutex> lock(statsMutex_);
+      ++mismatches_;
+      lastMismatch_ = "Port \"" + name + "\": " + mismatch;
+      if (strict_) return DEVICE_SERIAL_COMMAND_FAILED;
+    }
+    if (port.nextHost < port.events.size()) {
+      port.anchorWall = std::chrono::steady_clock::now();
+      port.anchorUs = port.events[port.nextHost].us;
+      port.nextHost = port.Next(port.nextHost + 1, true);
+    }
+    return DEVICE_OK;
+  }
+
+  void Parse(const std::string &path, const std::string &contents) {
+    const auto *p = reinterpret_cast<const unsigned char *>(contents.data());
+    const auto *end = p + contents.size();
+    auto invalid = [&path]() {
+      return std::runtime_error("Not a valid serial recording: " + path);
+    };
+    if (contents.size() < 12 || std::memcmp(p, serial_traffic::kMagic, 8) != 0) throw invalid();
+    if (serial_traffic::getLE(p + 8, 4) != serial_traffic::kVersion)
+      throw std::runtime_error("Unsupported serial recording version in " + path);
+    p += 12;
+
+    std::map<uint16_t, Port *> byId;
+    while (p != end) {
+      if (end - p < 15) throw invalid();
+      uint64_t us = serial_traffic::getLE(p, 8);
+      uint16_t id = static_cast<uint16_t>(serial_traffic::getLE(p + 8, 2));
+      uint8_t kind = p[10];
+      uint64_t length = serial_traffic::getLE(p + 11, 4);
+      p += 15;
+      if (static_cast<uint64_t>(end - p) < length || kind > 3) throw invalid();
+      std::string data(reinterpret_cast<const char *>(p), length);
+      p += length;
+
+      if (static_cast<SerialEvent>(kind) == SerialEvent::PortName) {
+        std::unique_ptr<Port> &port = ports_[data];
+        if (!port) port.reset(new Port());
+        byId[id] = port.get();
+        continue;
+      }
+      auto port = byId.find(id);
+      if (port == byId.end()) throw invalid();
+      port->second->events.push_back({us, static_cast<SerialEvent>(kind), std::move(data)});
+    }
+  }
+
+  const double timeScale_;
+  const bool strict_;
+  const double answerTimeoutMs_;
+  std::map<std::string, std::unique_ptr<Port>> ports_;  // fixed once loaded
+
+  mutable std::mutex statsMutex_;
+  uint64_t mismatches_ = 0;
+  std::string lastMismatch_;
+};
+
+/** The recorder each recorded serial port writes to, by port label. */
+inline DeviceRegistry<SerialRecorder, std::string> &serialRecorders() {
+  static DeviceRegistry<SerialRecorder, std::string> *registry =
+      new DeviceRegistry<SerialRecorder, std::string>();
+  return *registry;
+}
+
+/** The replay standing in for each replayed serial port, by port label. */
+inline DeviceRegistry<SerialReplay, std::string> &serialReplays() {
+  static DeviceRegistry<SerialReplay, std::string> *registry =
+      new DeviceRegistry<SerialReplay, std::string>();
+  return *registry;
+}
+
+/** Logs one event of the port's traffic, if the port is being recorded. */
+inline void recordSerialTraffic(const std::string &port, SerialEvent kind,
+                                const unsigned char *data, size_t length) {
+  std::shared_ptr<SerialRecorder> recorder = serialRecorders().Find(port);
+  if (recorder) recorder->Record(port, kind, data, length);
+}
+
+/** As above, for adapters' calls: builds no label unless some port is being recorded. */
+inline void recordSerialTraffic(const char *port, SerialEvent kind, const unsigned char *data,
+                                size_t length) {
+  if (!serialRecorders().IsEmpty()) recordSerialTraffic(std::string(port), kind, data, length);
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * A fixed set of worker threads running submitted tasks in FIFO order.
+ *
+ * Used for fanning device I/O out across adapter modules.  Tasks must not touch Python: the
+ * caller is expected to release the GIL while it waits on their futures.  The destructor lets
+ * queued tasks finish before joining the workers.
+ */
+class ThreadPool {
+ public:
+  /** @param workers Number of threads; 0 means one per hardware thread. */
+  explicit ThreadPool(size_t workers) {
+    if (workers == 0) workers = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t i = 0; i < workers; ++i) threads_.emplace_back([this] { Run(); });
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread &thread : threads_) thread.join();
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  size_t GetWorkerCount() const { return threads_.size(); }
+
+  /**
+   * Queue `task` to run on a worker.
+   *
+   * @return A future for the task's result; an exception thrown by the task is rethrown from
+   *     its get().
+   */
+  template <typename F>
+  std::future<typename std::result_of<F()>::type> Submit(F task) {
+    using Result = typename std::result_of<F()>::type;
+    auto packaged = std::make_shared<std::packaged_task<Result()>>(std::move(task));
+    std::future<Result> result = packaged->get_future();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      queue_.emplace_back([packaged] { (*packaged)(); });
+    }
+    wake_.notify_one();
+    return result;
+  }
+
+ private:
+  void Run() {
+    for (;;) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        wake_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+        if (queue_.empty()) return;  // stopping, and nothing left to do
+        task = std::move(queue_.front());
+        queue_.pop_front();
+      }
+      task();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::deque<std::function<void()>> queue_;
+  bool stopping_ = false;
+  std::vector<std::thread> threads_;
+};
@@ -1,27 +1,55 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>  // For automatic conversion between C++ and Python containers
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <fstream>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <tuple>
 
+#include "AdapterDiscovery.h"
+#include "AdapterIndex.h"
 #include "AutoFocusInstance.h"
+#include "CallStats.h"
 #include "CameraInstance.h"
 #include "CoreCallback.h"
 #include "CoreUtils.h"
 #include "DeviceInstance.h"
 #include "DeviceManager.h"
+#include "DeviceRoutes.h"
+#include "EventQueue.h"
+#include "FramePipeline.h"
 #include "GalvoInstance.h"
 #include "GenericInstance.h"
 #include "HubInstance.h"
+#include "ImageMetadata.h"
 #include "ImageProcessorInstance.h"
 #include "LoadableModules/LoadedDeviceAdapter.h"
+#include "LogSink.h"
 #include "MMCore.h"
 #include "MMDeviceConstants.h"
 #include "MagnifierInstance.h"
+#include "PixelKernels.h"
 #include "PluginManager.h"
+#include "PropertyCache.h"
 #include "SLMInstance.h"
+#include "SequenceBuffer.h"
 #include "SerialInstance.h"
+#include "SerialStream.h"
+#include "SerialTraffic.h"
 #include "ShutterInstance.h"
 #include "SignalIOInstance.h"
+#include "ThreadPool.h"
 #include "StageInstance.h"
 #include "StateInstance.h"
 #include "XYStageInstance.h"
@@ -37,14 +65,47 @@ class MockCMMCore : public CMMCore {
   // You might not need to implement anything if LoadDevice truly does nothing with it
 };
 
+// Devices keep a raw pointer to the core they were loaded with, so every device shares one core
+// that is never destroyed (deliberately leaked to sidestep static destruction order at exit).
+MockCMMCore *sharedMockCore() {
+  static MockCMMCore *core = new MockCMMCore();
+  return core;
+}
+
 class PyDeviceInstance {};
 
+// The logger that a device (or the core, about the device) logs through: to logSink(), under
+// the device's label.
+mm::logging::internal::GenericLogger<mm::logging::EntryData> deviceLogger(
+    const std::string &label) {
+  return mm::logging::internal::GenericLogger<mm::logging::EntryData>(
+      [label](mm::logging::EntryData entry, const char *text) {
+        logSink().Log(label, entry.GetLevel(), text);
+      });
+}
+
+// Reads every property of an initialized device into its cache.  Call under a DeviceCallGuard.
+void fillPropertyCache(DeviceInstance &device, PropertyCache &cache) {
+  cache.Clear();
+  for (const std::string &name : device.GetPropertyNames()) {
+    uint64_t generation = cache.GetGeneration();
+    cache.Fill(name, device.GetProperty(name), generation);
+  }
+}
+
+// Initialize() plus refilling the property cache, if the device has one.
+void initializeDevice(DeviceInstance &device) {
+  util::DeviceCallGuard guard(device);
+  device.Initialize();
+  std::shared_ptr<PropertyCache> cache = propertyCaches().Find(device.GetRawPtr());
+  if (cache) fillPropertyCache(device, *cache);
+}
+
 template <typename DType>
-py::class_<DType, std::shared_ptr<DType>> bindDeviceInstance(py::module_ &m,
-                                                             const std::string &className) {
-  auto cls = py::class_<DType, std::shared_ptr<DType>>(m, className.c_str());
+util::DeviceClass<DType> bindDeviceInstance(py::module_ &m, const std::string &className) {
+  util::DeviceClass<DType> cls(m, className.c_str());
 
-  cls.def(py::init([](MockCMMCore *core, std::shared_ptr<LoadedDeviceAdapter> adapter,
+  cls.Base::def(py::init([](MockCMMCore *core, std::shared_ptr<LoadedDeviceAdapter> adapter,
                       const std::string &name, MM::Device *pDevice,
                       DeleteDeviceFunction deleteFunction, const std::string &label,
                       mm::logging::Logger deviceLogger, mm::logging::Logger coreLogger) {
@@ -52,52 +113,138 @@ py::class_<DType, std::shared_ptr<DType>> bindDeviceInstance(py::module_ &m,
                      coreLogger);
   }));
   cls.def("__enter__", [](DType &self) -> DType & {
-    self.Initialize();
+    initializeDevice(self);
     return self;
   });
-  cls.def("__exit__", [](DType &self, py::args args) -> void { self.Shutdown(); });
+  cls.def("__exit__", [](DType &self, py::args args) -> void {
+    util::DeviceCallGuard guard(self);
+    self.Shutdown();
+    std::shared_ptr<PropertyCache> cache = propertyCaches().Find(self.GetRawPtr());
+    if (cache) cache->Clear();
+  });
 
-  cls.def("AddToPropertySequence", &DeviceInstance::AddToPropertySequence);
-  cls.def("Busy", &DeviceInstance::Busy);
-  cls.def("ClearPropertySequence", &DeviceInstance::ClearPropertySequence);
-  cls.def("DetectDevice", &DeviceInstance::DetectDevice);
+  cls.def("AddToPropertySequence",
+          util::deviceCall<DType>(&DeviceInstance::AddToPropertySequence));
+  cls.def("Busy", util::deviceCall<DType>(&DeviceInstance::Busy),
+          "Return whether the device is still carrying out a command.\n\n"
+          "Polled with the GIL released, under the adapter library's lock.");
+  cls.def(
+      "ClearPropertyCache",
+      [](DType &self) {
+        std::shared_ptr<PropertyCache> cache = propertyCaches().Find(self.GetRawPtr());
+        if (cache) cache->Clear();
+      },
+      "Drop all cached property values; the next reads go to the device.");
+  cls.def("ClearPropertySequence",
+          util::deviceCall<DType>(&DeviceInstance::ClearPropertySequence));
+  cls.def("DetectDevice", util::deviceCall<DType>(&DeviceInstance::DetectDevice));
+  cls.def(
+      "EnablePropertyCache",
+      [](DType &self, bool enable) {
+        if (!enable) {
+          propertyCaches().Detach(self.GetRawPtr());
+          return;
+        }
+        if (propertyCaches().Find(self.GetRawPtr())) return;
+        auto cache = std::make_shared<PropertyCache>();
+        propertyCaches().Attach(self.GetRawPtr(), cache);
+        if (self.IsInitialized()) {
+          util::DeviceCallGuard guard(self);
+          fillPropertyCache(self, *cache);
+        }
+      },
+      "enable"_a = true,
+      "Serve GetProperty from a cache of last known values.\n\n"
+      "The cache is filled on Initialize (or now, if the device is already initialized), "
+      "updated by the device's property-change notifications, and invalidated by "
+      "SetProperty.  Properties the adapter changes without notifying are not refreshed; "
+      "call ClearPropertyCache to force fresh reads.");
   cls.def("GetAdapterModule", &DeviceInstance::GetAdapterModule);
-  cls.def("GetDelayMs", &DeviceInstance::GetDelayMs);
+  cls.def("GetDelayMs", util::deviceCall<DType>(&DeviceInstance::GetDelayMs));
   cls.def("GetDescription", &DeviceInstance::GetDescription);
-  cls.def("GetErrorText", &DeviceInstance::GetErrorText);
+  cls.def("GetErrorText", util::deviceCall<DType>(&DeviceInstance::GetErrorText));
   cls.def("GetLabel", &DeviceInstance::GetLabel);
-  cls.def("GetName", &DeviceInstance::GetName);
-  cls.def("GetNumberOfPropertyValues", &DeviceInstance::GetNumberOfPropertyValues);
-  cls.def("GetParentID", &DeviceInstance::GetParentID);
-  cls.def("GetProperty", &DeviceInstance::GetProperty);
-  cls.def("GetPropertyInitStatus", &DeviceInstance::GetPropertyInitStatus);
-  cls.def("GetPropertyLowerLimit", &DeviceInstance::GetPropertyLowerLimit);
-  cls.def("GetPropertyNames", &DeviceInstance::GetPropertyNames);
-  cls.def("GetPropertyReadOnly", &DeviceInstance::GetPropertyReadOnly);
-  cls.def("GetPropertySequenceMaxLength", &DeviceInstance::GetPropertySequenceMaxLength);
-  cls.def("GetPropertyType", &DeviceInstance::GetPropertyType);
-  cls.def("GetPropertyUpperLimit", &DeviceInstance::GetPropertyUpperLimit);
-  cls.def("GetPropertyValueAt", &DeviceInstance::GetPropertyValueAt);
+  cls.def("GetName", util::deviceCall<DType>(&DeviceInstance::GetName));
+  cls.def("GetNumberOfPropertyValues",
+          util::deviceCall<DType>(&DeviceInstance::GetNumberOfPropertyValues));
+  cls.def("GetParentID", util::deviceCall<DType>(&DeviceInstance::GetParentID));
+  cls.def("GetProperty", [](DType &self, const std::string &name) {
+    std::shared_ptr<PropertyCache> cache = propertyCaches().Find(self.GetRawPtr());
+    std::string value;
+    uint64_t generation = 0;
+    if (cache && cache->Lookup(name, value, generation)) return value;
+    {
+      util::DeviceCallGuard guard(self);
+      value = self.GetProperty(name);
+    }
+    if (cache) cache->Fill(name, value, generation);
+    return value;
+  });
+  cls.def(
+      "GetPropertyCacheStats",
+      [](DType &self) {
+        std::shared_ptr<PropertyCache> cache = propertyCaches().Find(self.GetRawPtr());
+        py::dict stats;
+        stats["hits"] = cache ? cache->GetHitCount() : 0;
+        stats["misses"] = cache ? cache->GetMissCount() : 0;
+        stats["size"] = cache ? cache->GetSize() : 0;
+        return stats;
+      },
+      "Return the property cache's hit and miss counts and number of cached values.");
+  cls.def("GetPropertyInitStatus",
+          util::deviceCall<DType>(&DeviceInstance::GetPropertyInitStatus));
+  cls.def("GetPropertyLowerLimit",
+          util::deviceCall<DType>(&DeviceInstance::GetPropertyLowerLimit));
+  cls.def("GetPropertyNames", util::deviceCall<DType>(&DeviceInstance::GetPropertyNames));
+  cls.def("GetPropertyReadOnly", util::deviceCall<DType>(&DeviceInstance::GetPropertyReadOnly));
+  cls.def("GetPropertySequenceMaxLength",
+          util::deviceCall<DType>(&DeviceInstance::GetPropertySequenceMaxLength));
+  cls.def("GetPropertyType", util::deviceCall<DType>(&DeviceInstance::GetPropertyType));
+  cls.def("GetPropertyUpperLimit",
+          util::deviceCall<DType>(&DeviceInstance::GetPropertyUpperLimit));
+  cls.def("GetPropertyValueAt", util::deviceCall<DType>(&DeviceInstance::GetPropertyValueAt));
   cls.def("GetRawPtr", &DeviceInstance::GetRawPtr);
-  cls.def("GetType", &DeviceInstance::GetType);
+  cls.def("GetType", util::deviceCall<DType>(&DeviceInstance::GetType));
   cls.def("HasInitializationBeenAttempted", &DeviceInstance::HasInitializationBeenAttempted);
-  cls.def("HasProperty", &DeviceInstance::HasProperty);
-  cls.def("HasPropertyLimits", &DeviceInstance::HasPropertyLimits);
-  cls.def("Initialize", &DeviceInstance::Initialize);
+  cls.def("HasProperty", util::deviceCall<DType>(&DeviceInstance::HasProperty));
+  cls.def("HasPropertyLimits", util::deviceCall<DType>(&DeviceInstance::HasPropertyLimits));
+  cls.def(
+      "Initialize", [](DType &self) { initializeDevice(self); },
+      "Initialize the device, refilling its property cache if one is enabled.\n\n"
+      "The GIL is released meanwhile; devices from the same adapter library wait for it.");
   cls.def("IsInitialized", &DeviceInstance::IsInitialized);
-  cls.def("IsPropertySequenceable", &DeviceInstance::IsPropertySequenceable);
+  cls.def("IsPropertyCacheEnabled", [](DType &self) {
+    return propertyCaches().Find(self.GetRawPtr()) != nullptr;
+  });
+  cls.def("IsPropertySequenceable",
+          util::deviceCall<DType>(&DeviceInstance::IsPropertySequenceable));
   cls.def("LogMessage", &DeviceInstance::LogMessage);
-  cls.def("SendPropertySequence", &DeviceInstance::SendPropertySequence);
-  cls.def("SetCallback", &DeviceInstance::SetCallback);
-  cls.def("SetDelayMs", &DeviceInstance::SetDelayMs);
+  cls.def("SendPropertySequence", util::deviceCall<DType>(&DeviceInstance::SendPropertySequence));
+  cls.def("SetCallback", util::deviceCall<DType>(&DeviceInstance::SetCallback));
+  cls.def("SetDelayMs", util::deviceCall<DType>(&DeviceInstance::SetDelayMs));
   cls.def("SetDescription", &DeviceInstance::SetDescription);
-  cls.def("SetParentID", &DeviceInstance::SetParentID);
-  cls.def("SetProperty", &DeviceInstance::SetProperty);
-  cls.def("Shutdown", &DeviceInstance::Shutdown);
-  cls.def("StartPropertySequence", &DeviceInstance::StartPropertySequence);
-  cls.def("StopPropertySequence", &DeviceInstance::StopPropertySequence);
-  cls.def("SupportsDeviceDetection", &DeviceInstance::SupportsDeviceDetection);
-  cls.def("UsesDelay", &DeviceInstance::UsesDelay);
+  cls.def("SetParentID", util::deviceCall<DType>(&DeviceInstance::SetParentID));
+  cls.def("SetProperty", [](DType &self, const std::string &name, const std::string &value) {
+    {
+      util::DeviceCallGuard guard(self);
+      self.SetProperty(name, value);
+    }
+    // the adapter may coerce the value, so read it back on next use rather than storing it
+    std::shared_ptr<PropertyCache> cache = propertyCaches().Find(self.GetRawPtr());
+    if (cache) cache->Invalidate(name);
+  });
+  cls.def("Shutdown", [](DType &self) {
+    util::DeviceCallGuard guard(self);
+    self.Shutdown();
+    std::shared_ptr<PropertyCache> cache = propertyCaches().Find(self.GetRawPtr());
+    if (cache) cache->Clear();
+  });
+  cls.def("StartPropertySequence",
+          util::deviceCall<DType>(&DeviceInstance::StartPropertySequence));
+  cls.def("StopPropertySequence", util::deviceCall<DType>(&DeviceInstance::StopPropertySequence));
+  cls.def("SupportsDeviceDetection",
+          util::deviceCall<DType>(&DeviceInstance::SupportsDeviceDetection));
+  cls.def("UsesDelay", util::deviceCall<DType>(&DeviceInstance::UsesDelay));
   cls.def("__repr__", [className](const DType &self) {
     std::string repr = "<" + className;
     repr += " '" + self.GetLabel() + "'";
@@ -117,44 +264,2360 @@ std::string getErrorMessage(DeviceInstance *device, int errorCode) {
          device->GetErrorText(errorCode) + " (" + ToString(errorCode) + ")";
 }
 
-// Just a hack for now...
-// It's the CoreCallback that makes me recognize that this may never work.
-// Much of the Core API is exposed to the Devices through the CoreCallback,
-// So, it might not ever make sense to directly control device libraries without
-// a core (even if you don't technically need it).
+// The port's SerialStream, created on first use (atomically, so that concurrent readers never
+// end up with streams of their own).  Use it under the port's module lock.
+std::shared_ptr<SerialStream> serialStream(SerialInstance &port) {
+  return serialStreams().FindOrAttach(port.GetRawPtr());
+}
+
+SerialStream::ReadFn serialReader(SerialInstance &port) {
+  // small enough for std::function to hold without allocating
+  if (serialRecorders().IsEmpty())
+    return [&port](unsigned char *buf, unsigned long len, unsigned long &read) {
+      return port.Read(buf, len, read);
+    };
+  std::shared_ptr<SerialRecorder> recorder = serialRecorders().Find(port.GetLabel());
+  return [&port, recorder](unsigned char *buf, unsigned long len, unsigned long &read) {
+    int ret = port.Read(buf, len, read);
+    if (recorder && ret == DEVICE_OK && read > 0)
+      recorder->Record(port.GetLabel(), SerialEvent::Read, buf, read);
+    return ret;
+  };
+}
+
+// SerialInstance::GetAnswer, but through the port's SerialStream, so that bytes buffered by an
+// earlier Read or Transact come first.  Waits as long as the port's AnswerTimeout property
+// says (as SerialManager ports do), or a second for ports without one.  Call under the port's
+// module lock.
+int getSerialAnswer(SerialInstance &port, const char *term, unsigned long maxChars,
+                    std::string &answer) {
+  double timeoutMs = 1000;
+  if (port.HasProperty(MM::g_Keyword_AnswerTimeout))
+    timeoutMs = std::atof(port.GetProperty(MM::g_Keyword_AnswerTimeout).c_str());
+  const auto deadline =
+      std::chrono::steady_clock::now() +
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<double, std::milli>(timeoutMs));
+  int ret = serialStream(port)->ReadUntil(serialReader(port), term, deadline, answer);
+  if (ret == DEVICE_OK && answer.size() >= maxChars) return DEVICE_SERIAL_BUFFER_OVERRUN;
+  return ret;
+}
+
+// The MM::Core that devices loaded through these bindings call back into.
+//
+// Much of the Core API is exposed to the devices through the CoreCallback.  Whatever involves
+// other devices (hubs, state devices, serial ports, device properties) is routed here to the
+// devices of the DeviceManager that owns the callback, through its DeviceRoutes; frames and
+// property notifications go to the registries the bindings keep per device.  CoreCallback's
+// own implementation, backed by the shared mock core, is left with the stateless remainder
+// (clock, sleep, ...).  Devices loaded outside a DeviceManager get a callback with no routes.
 class PyCoreCallback : public CoreCallback {
  public:
   using CoreCallback::CoreCallback;  // Inherit constructors
 
-  // .def("GetLoadedDeviceOfType", &PyCoreCallback::GetLoadedDeviceOfType, "caller"_a,
-  //      "devType"_a, "deviceName"_a, "deviceIterator"_a);
+  /** The devices this callback routes to; updated as its DeviceManager loads and unloads. */
+  DeviceRoutes &Routes() { return routes_; }
+
+  /** How many stage position notifications have arrived so far. */
+  uint64_t GetMoveCount() const { return moves_.load(); }
+
+  /** Waits for a stage position notification beyond the first `seen`, or until `until`. */
+  void WaitForMove(uint64_t seen, std::chrono::steady_clock::time_point until) {
+    std::unique_lock<std::mutex> lock(moveMutex_);
+    ++moveWaiters_;
+    moved_.wait_until(lock, until, [&] { return moves_.load() != seen; });
+    --moveWaiters_;
+  }
 
+  // there is no current image processor or autofocus device outside of a CMMCore
   MM::ImageProcessor *GetImageProcessor(const MM::Device *caller) { return nullptr; }
-  MM::State *GetStateDevice(const MM::Device *caller, const char *label) { return nullptr; }
-  MM::SignalIO *GetSignalIODevice(const MM::Device *caller, const char *label) { return nullptr; }
   MM::AutoFocus *GetAutoFocus(const MM::Device *caller) { return nullptr; }
-  MM::Hub *GetParentHub(const MM::Device *caller) const { return nullptr; }
+  // the caller's own label is all the log sink needs: no DeviceInstance to look up
   int LogMessage(const MM::Device *caller, const char *msg, bool debugOnly) const {
+    int level = debugOnly ? mm::logging::LogLevelDebug : mm::logging::LogLevelInfo;
+    if (!logSink().Accepts(level)) return DEVICE_OK;
+    char label[MM::MaxStrLength] = "";
+    if (caller) caller->GetLabel(label);
+    logSink().Log(label, level, msg);
+    return DEVICE_OK;
+  }
+
+  MM::Device *GetDevice(const MM::Device *caller, const char *label) {
+    std::shared_ptr<DeviceInstance> device = routes_.Find(label).device;
+    return device ? device->GetRawPtr() : nullptr;
+  }
+  MM::State *GetStateDevice(const MM::Device *caller, const char *label) {
+    DeviceRoutes::Route route = routes_.Find(label);
+    if (route.type != MM::StateDevice) return nullptr;
+    return static_cast<MM::State *>(route.device->GetRawPtr());
+  }
+  MM::SignalIO *GetSignalIODevice(const MM::Device *caller, const char *label) {
+    DeviceRoutes::Route route = routes_.Find(label);
+    if (route.type != MM::SignalIODevice) return nullptr;
+    return static_cast<MM::SignalIO *>(route.device->GetRawPtr());
+  }
+  // as in DeviceManager::GetParentDevice: a hub is its own parent, and a peripheral's is the
+  // hub from its own library named by its parent ID
+  MM::Hub *GetParentHub(const MM::Device *caller) const {
+    DeviceRoutes::Route device = routes_.Find(caller);
+    if (device.type == MM::HubDevice) return static_cast<MM::Hub *>(device.device->GetRawPtr());
+    if (!device.device) return nullptr;
+    DeviceRoutes::Route hub = routes_.Find(device.device->GetParentID().c_str());
+    if (hub.type != MM::HubDevice ||
+        hub.device->GetAdapterModule() != device.device->GetAdapterModule())
+      return nullptr;
+    return static_cast<MM::Hub *>(hub.device->GetRawPtr());
+  }
+  void GetLoadedDeviceOfType(const MM::Device *caller, MM::DeviceType devType,
+                             char *pDeviceName, const unsigned int deviceIterator) {
+    std::shared_ptr<const std::string> label = routes_.GetLabelOfType(devType, deviceIterator);
+    pDeviceName[0] = '\0';
+    if (label) std::strncat(pDeviceName, label->c_str(), MM::MaxStrLength - 1);
+  }
+
+  int GetDeviceProperty(const char *deviceName, const char *propName, char *value) {
+    std::shared_ptr<DeviceInstance> device = routes_.Find(deviceName).device;
+    if (!device) return DEVICE_ERR;
+    try {
+      MMThreadGuard lock(device->GetAdapterModule()->GetLock());
+      value[0] = '\0';
+      std::strncat(value, device->GetProperty(propName).c_str(), MM::MaxStrLength - 1);
+    } catch (const std::exception &) {
+      return DEVICE_ERR;
+    }
+    return DEVICE_OK;
+  }
+  int SetDeviceProperty(const char *deviceName, const char *propName, const char *value) {
+    std::shared_ptr<DeviceInstance> device = routes_.Find(deviceName).device;
+    if (!device) return DEVICE_ERR;
+    try {
+      MMThreadGuard lock(device->GetAdapterModule()->GetLock());
+      device->SetProperty(propName, value);
+    } catch (const std::exception &) {
+      return DEVICE_ERR;
+    }
+    std::shared_ptr<PropertyCache> cache = propertyCaches().Find(device->GetRawPtr());
+    if (cache) cache->Invalidate(propName);
+    return DEVICE_OK;
+  }
+
+  // Sequence acquisition: frames go straight into the calling camera's SequenceBuffer.
+  // This runs on the camera's own thread and never touches Python or the GIL.
+  int InsertImage(const MM::Device *caller, const unsigned char *buf, unsigned width,
+                  unsigned height, unsigned byteDepth, unsigned nComponents,
+                  const char *serializedMetadata, const bool doProcess = true) {
+    // with image processors attached, every frame takes a detour through the camera's pipeline,
+    // even one that skips them: its worker must stay the buffer's only producer
+    std::shared_ptr<FramePipeline> pipeline = framePipelines().Find(caller);
+    if (pipeline)
+      return pipeline->Insert(buf, width, height, byteDepth, doProcess) ? DEVICE_OK
+                                                                        : DEVICE_BUFFER_OVERFLOW;
+    std::shared_ptr<SequenceBuffer> buffer = sequenceBuffers().Find(caller);
+    // without a buffer there is nowhere to put the frame; report it like a full buffer
+    if (!buffer) return DEVICE_BUFFER_OVERFLOW;
+    if (!buffer->Matches(width, height, byteDepth)) return DEVICE_INCOMPATIBLE_IMAGE;
+    return buffer->Insert(buf) ? DEVICE_OK : DEVICE_BUFFER_OVERFLOW;
+  }
+  int InsertImage(const MM::Device *caller, const unsigned char *buf, unsigned width,
+                  unsigned height, unsigned byteDepth, const char *serializedMetadata,
+                  const bool doProcess = true) {
+    return InsertImage(caller, buf, width, height, byteDepth, 1u, serializedMetadata, doProcess);
+  }
+  int InsertImage(const MM::Device *caller, const unsigned char *buf, unsigned width,
+                  unsigned height, unsigned byteDepth, const Metadata *pMd = 0,
+                  const bool doProcess = true) {
+    return InsertImage(caller, buf, width, height, byteDepth, 1u, nullptr, doProcess);
+  }
+  void ClearImageBuffer(const MM::Device *caller) {
+    // Cameras call this from their acquisition thread (e.g. to recover from an overflow), so
+    // drain the buffer as a consumer would rather than resetting it underneath one.
+    std::shared_ptr<SequenceBuffer> buffer = sequenceBuffers().Find(caller);
+    if (buffer) buffer->Discard();
+  }
+  int PrepareForAcq(const MM::Device *caller) { return DEVICE_OK; }
+  int AcqFinished(const MM::Device *caller, int statusCode) { return DEVICE_OK; }
+
+  /** Starts delivering device notifications to `queue`.  Python thread only. */
+  void AddEventQueue(std::shared_ptr<EventQueue> queue) {
+    auto queues = std::make_shared<EventQueues>();
+    if (std::shared_ptr<const EventQueues> current = std::atomic_load(&queues_)) *queues = *current;
+    queues->push_back(std::move(queue));
+    std::atomic_store(&queues_, std::shared_ptr<const EventQueues>(std::move(queues)));
+  }
+  void RemoveEventQueue(const std::shared_ptr<EventQueue> &queue) {
+    std::shared_ptr<const EventQueues> current = std::atomic_load(&queues_);
+    if (!current) return;
+    auto queues = std::make_shared<EventQueues>();
+    for (const std::shared_ptr<EventQueue> &q : *current)
+      if (q != queue) queues->push_back(q);
+    std::atomic_store(&queues_, std::shared_ptr<const EventQueues>(std::move(queues)));
+  }
+
+  // Notifications keep the calling device's PropertyCache (if any) current and are queued for
+  // the manager's event streams.  They arrive on adapter threads and never take the GIL.
+  int OnPropertiesChanged(const MM::Device *caller) {
+    std::shared_ptr<PropertyCache> cache = propertyCaches().Find(caller);
+    if (cache) cache->Clear();
+    Publish(DeviceEvent::PropertiesChanged, caller);
+    return DEVICE_OK;
+  }
+  int OnPropertyChanged(const MM::Device *device, const char *propName, const char *value) {
+    std::shared_ptr<PropertyCache> cache = propertyCaches().Find(device);
+    if (cache && propName != nullptr) {
+      if (value != nullptr)
+        cache->Update(propName, value);
+      else
+        cache->Invalidate(propName);
+    }
+    if (propName != nullptr)
+      Publish(DeviceEvent::PropertyChanged, device, 0, 0, propName, value ? value : "");
+    return DEVICE_OK;
+  }
+  int OnStagePositionChanged(const MM::Device *device, double pos) {
+    Publish(DeviceEvent::StagePositionChanged, device, pos);
+    NotifyMove();
+    return DEVICE_OK;
+  }
+  int OnXYStagePositionChanged(const MM::Device *device, double xPos, double yPos) {
+    Publish(DeviceEvent::XYStagePositionChanged, device, xPos, yPos);
+    NotifyMove();
+    return DEVICE_OK;
+  }
+  int OnExposureChanged(const MM::Device *device, double newExposure) {
+    Publish(DeviceEvent::ExposureChanged, device, newExposure);
+    return DEVICE_OK;
+  }
+  int OnSLMExposureChanged(const MM::Device *device, double newExposure) {
+    Publish(DeviceEvent::SLMExposureChanged, device, newExposure);
+    return DEVICE_OK;
+  }
+  int OnMagnifierChanged(const MM::Device *device) {
+    Publish(DeviceEvent::MagnifierChanged, device);
+    return DEVICE_OK;
+  }
+
+  // Serial I/O from adapters: a replayed port is served from its recording instead of the
+  // hardware, and a recorded port logs what went through.  Ports are looked up by the
+  // adapter's const char * name, so that while nothing is replayed or recorded, a call to a
+  // real port allocates nothing.
+  int WriteToSerial(const MM::Device *caller, const char *portName, const unsigned char *buf,
+                    unsigned long length) {
+    std::shared_ptr<SerialReplay> replay = Replay(portName);
+    if (replay) return replay->Write(portName, buf, length);
+    std::shared_ptr<SerialInstance> port = SerialPort(portName);
+    if (!port) return DEVICE_SERIAL_COMMAND_FAILED;
+    int ret;
+    {
+      MMThreadGuard lock(port->GetAdapterModule()->GetLock());
+      ret = port->Write(buf, length);
+    }
+    if (ret == DEVICE_OK) recordSerialTraffic(portName, SerialEvent::Write, buf, length);
+    return ret;
+  }
+  int ReadFromSerial(const MM::Device *caller, const char *portName, unsigned char *buf,
+                     unsigned long bufLength, unsigned long &bytesRead) {
+    std::shared_ptr<SerialReplay> replay = Replay(portName);
+    if (replay) return replay->Read(portName, buf, bufLength, bytesRead);
+    std::shared_ptr<SerialInstance> port = SerialPort(portName);
+    if (!port) return DEVICE_SERIAL_COMMAND_FAILED;
+    int ret;
+    {
+      MMThreadGuard lock(port->GetAdapterModule()->GetLock());
+      ret = port->Read(buf, bufLength, bytesRead);
+    }
+    if (ret == DEVICE_OK && bytesRead > 0)
+      recordSerialTraffic(portName, SerialEvent::Read, buf, bytesRead);
+    return ret;
+  }
+  int PurgeSerial(const MM::Device *caller, const char *portName) {
+    std::shared_ptr<SerialReplay> replay = Replay(portName);
+    if (replay) return replay->Purge(portName);
+    std::shared_ptr<SerialInstance> port = SerialPort(portName);
+    if (!port) return DEVICE_SERIAL_COMMAND_FAILED;
+    int ret;
+    {
+      MMThreadGuard lock(port->GetAdapterModule()->GetLock());
+      ret = port->Purge();
+    }
+    if (ret == DEVICE_OK) recordSerialTraffic(portName, SerialEvent::Purge, nullptr, 0);
+    return ret;
+  }
+  int SetSerialCommand(const MM::Device *caller, const char *portName, const char *command,
+                       const char *term) {
+    // what went out, as one write (only needed for a replay or a recording)
+    auto sent = [command, term] { return std::string(command) + term; };
+    std::shared_ptr<SerialReplay> replay = Replay(portName);
+    if (replay) {
+      const std::string data = sent();
+      return replay->Write(portName, reinterpret_cast<const unsigned char *>(data.data()),
+                           data.size());
+    }
+    std::shared_ptr<SerialInstance> port = SerialPort(portName);
+    if (!port) return DEVICE_SERIAL_COMMAND_FAILED;
+    int ret;
+    {
+      MMThreadGuard lock(port->GetAdapterModule()->GetLock());
+      ret = port->SetCommand(command, term);
+    }
+    if (ret == DEVICE_OK && !serialRecorders().IsEmpty()) {
+      const std::string data = sent();
+      recordSerialTraffic(portName, SerialEvent::Write,
+                          reinterpret_cast<const unsigned char *>(data.data()), data.size());
+    }
+    return ret;
+  }
+  int GetSerialAnswer(const MM::Device *caller, const char *portName, unsigned long ansLength,
+                      char *answerTxt, const char *term) {
+    std::shared_ptr<SerialReplay> replay = Replay(portName);
+    if (replay) {
+      std::string answer;
+      int ret = replay->GetAnswer(portName, term, replay->GetAnswerTimeoutMs(), answer);
+      if (ret != DEVICE_OK) return ret;
+      if (answer.size() >= ansLength) return DEVICE_SERIAL_BUFFER_OVERRUN;
+      std::memcpy(answerTxt, answer.c_str(), answer.size() + 1);
+      return DEVICE_OK;
+    }
+    std::shared_ptr<SerialInstance> port = SerialPort(portName);
+    if (!port) return DEVICE_SERIAL_COMMAND_FAILED;
+    if (!term || !*term) return DEVICE_SERIAL_COMMAND_FAILED;
+    // reused, so that once it has grown to fit the answers it stops allocating
+    thread_local std::string answer;
+    answer.clear();
+    {
+      MMThreadGuard lock(port->GetAdapterModule()->GetLock());
+      // recorded as read, terminator included
+      int ret = getSerialAnswer(*port, term, ansLength, answer);
+      if (ret != DEVICE_OK) return ret;
+    }
+    std::memcpy(answerTxt, answer.c_str(), answer.size() + 1);
+    return DEVICE_OK;
+  }
+  int SetSerialProperties(const char *portName, const char *answerTimeout, const char *baudRate,
+                          const char *delayBetweenCharsMs, const char *handshaking,
+                          const char *parity, const char *stopBits) {
+    std::shared_ptr<SerialInstance> port = SerialPort(portName);
+    if (!port) return DEVICE_SERIAL_COMMAND_FAILED;
+    try {
+      MMThreadGuard lock(port->GetAdapterModule()->GetLock());
+      port->SetProperty(MM::g_Keyword_AnswerTimeout, answerTimeout);
+      port->SetProperty(MM::g_Keyword_BaudRate, baudRate);
+      port->SetProperty(MM::g_Keyword_DelayBetweenCharsMs, delayBetweenCharsMs);
+      port->SetProperty(MM::g_Keyword_Handshaking, handshaking);
+      port->SetProperty(MM::g_Keyword_Parity, parity);
+      port->SetProperty(MM::g_Keyword_StopBits, stopBits);
+    } catch (const std::exception &) {
+      return DEVICE_ERR;
+    }
     return DEVICE_OK;
   }
+
+ private:
+  using EventQueues = std::vector<std::shared_ptr<EventQueue>>;
+
+  void Publish(DeviceEvent::Kind kind, const MM::Device *device, double a = 0, double b = 0,
+               const char *name = "", const char *value = "") {
+    std::shared_ptr<const EventQueues> queues = std::atomic_load(&queues_);
+    if (!queues) return;
+    for (const std::shared_ptr<EventQueue> &queue : *queues) {
+      queue->Push([&](DeviceEvent &event) {
+        event.kind = kind;
+        event.device = device;
+        event.a = a;
+        event.b = b;
+        event.name.assign(name);
+        event.value.assign(value);
+      });
+    }
+  }
+
+  // Wakes WaitForMove; costs an atomic increment while nobody waits.
+  void NotifyMove() {
+    moves_.fetch_add(1);
+    if (moveWaiters_.load() == 0) return;
+    {
+      // taken so that a waiter can't miss the wakeup between its check and its wait
+      std::lock_guard<std::mutex> lock(moveMutex_);
+    }
+    moved_.notify_all();
+  }
+
+  static std::shared_ptr<SerialReplay> Replay(const char *portName) {
+    return serialReplays().IsEmpty() ? nullptr : serialReplays().Find(portName);
+  }
+
+  std::shared_ptr<SerialInstance> SerialPort(const char *portName) const {
+    DeviceRoutes::Route route = routes_.Find(portName);
+    if (route.type != MM::SerialDevice) return nullptr;
+    return std::static_pointer_cast<SerialInstance>(route.device);
+  }
+
+  DeviceRoutes routes_;
+  std::shared_ptr<const EventQueues> queues_;  // copied on write; see AddEventQueue
+  std::atomic<uint64_t> moves_{0};
+  std::atomic<int> moveWaiters_{0};
+  std::mutex moveMutex_;
+  std::condition_variable moved_;
+};
+
+// The callback installed on devices loaded outside a DeviceManager (and on unloaded ones).
+PyCoreCallback *defaultCoreCallback() {
+  static PyCoreCallback *callback = new PyCoreCallback(sharedMockCore());
+  return callback;
+}
+
+// The callback owned by each DeviceManager created through the bindings.
+DeviceRegistry<PyCoreCallback, const mm::DeviceManager *> &managerCallbacks() {
+  // leaked on purpose, like sequenceBuffers()
+  static auto *registry = new DeviceRegistry<PyCoreCallback, const mm::DeviceManager *>();
+  return *registry;
+}
+
+// The call profile of each DeviceManager with call stats enabled (see EnableCallStats).
+DeviceRegistry<CallProfile, const mm::DeviceManager *> &managerCallProfiles() {
+  static auto *registry = new DeviceRegistry<CallProfile, const mm::DeviceManager *>();
+  return *registry;
+}
+
+// Starts timing a device's calls, if its manager has call stats enabled.
+void profileDevice(const mm::DeviceManager &manager, const DeviceInstance &device) {
+  std::shared_ptr<CallProfile> profile = managerCallProfiles().Find(&manager);
+  if (profile)
+    deviceCallStats().Attach(device.GetRawPtr(), profile->AddDevice(device.GetLabel()));
+}
+
+// The points added through the bindings to each device's sequence (stage, XY stage, DA,
+// exposure or SLM; a device has at most one of these) since it was last cleared, so that an
+// upload can be checked against what is already queued.  Accessed under the module lock.
+DeviceRegistry<size_t> &queuedSequencePoints() {
+  static auto *registry = new DeviceRegistry<size_t>();
+  return *registry;
+}
+
+// Drops the side state kept for a device (see DeviceRegistry).  Called when a device is loaded,
+// so that nothing attached to an earlier device at the same address carries over, and when it
+// is unloaded.
+void forgetDevice(const MM::Device *device) {
+  sequenceBuffers().Detach(device);
+  framePipelines().Detach(device);
+  propertyCaches().Detach(device);
+  serialStreams().Detach(device);
+  deviceCallStats().Detach(device);
+  queuedSequencePoints().Detach(device);
+}
+
+// Unloads every device.  They keep their manager's callback while they shut down, so they can
+// still reach their hubs and ports; any that Python still holds get the default callback, as
+// they may outlive the manager.
+void unloadAllDevices(mm::DeviceManager &manager) {
+  std::vector<std::weak_ptr<DeviceInstance>> devices;
+  for (const std::string &label : manager.GetDeviceList()) {
+    std::shared_ptr<DeviceInstance> device = manager.GetDevice(label.c_str());
+    forgetDevice(device->GetRawPtr());
+    devices.push_back(device);
+  }
+  manager.UnloadAllDevices();
+  for (const std::weak_ptr<DeviceInstance> &weak : devices)
+    if (std::shared_ptr<DeviceInstance> device = weak.lock())
+      device->SetCallback(defaultCoreCallback());
+  std::shared_ptr<PyCoreCallback> callback = managerCallbacks().Find(&manager);
+  if (callback) callback->Routes().Clear();
+}
+
+// A DeviceManager with its own PyCoreCallback, which routes its devices' calls to each other.
+// The callback is dropped only once every device has been unloaded.
+std::shared_ptr<mm::DeviceManager> makeDeviceManager() {
+  auto *manager = new mm::DeviceManager();
+  managerCallbacks().Attach(manager, std::make_shared<PyCoreCallback>(sharedMockCore()));
+  return std::shared_ptr<mm::DeviceManager>(manager, [](mm::DeviceManager *manager) {
+    try {
+      unloadAllDevices(*manager);
+    } catch (const std::exception &) {
+      // nothing to report to at this point; the devices are gone either way
+    }
+    managerCallbacks().Detach(manager);
+    managerCallProfiles().Detach(manager);
+    delete manager;
+  });
+}
+
+// A DeviceManager's device notifications, as delivered to Python (see EventQueue).
+class PyEventStream {
+ public:
+  PyEventStream(std::shared_ptr<PyCoreCallback> callback, size_t capacity, bool coalesce)
+      : callback_(std::move(callback)),
+        queue_(std::make_shared<EventQueue>(capacity)),
+        coalesce_(coalesce) {
+    callback_->AddEventQueue(queue_);
+  }
+
+  ~PyEventStream() { Close(); }
+
+  // Drains the queue into a list of tuples, keeping only the latest of repeated updates to the
+  // same property, position or exposure if coalescing.
+  py::list Drain(size_t maxEvents) {
+    batch_.clear();
+    queue_->Drain(batch_, maxEvents);
+    std::vector<bool> keep(batch_.size(), true);
+    if (coalesce_) {
+      std::set<std::tuple<int, const MM::Device *, std::string>> seen;
+      for (size_t i = batch_.size(); i-- > 0;)
+        keep[i] = seen.emplace(batch_[i].kind, batch_[i].device, batch_[i].name).second;
+    }
+    py::list events;
+    for (size_t i = 0; i < batch_.size(); ++i)
+      if (keep[i]) events.append(ToTuple(batch_[i]));
+    return events;
+  }
+
+  bool Wait(double timeoutMs) {
+    py::gil_scoped_release release;
+    return queue_->Wait(timeoutMs);
+  }
+
+  // The next event, waiting for one; nullptr once the stream is closed and drained.
+  py::object Next() {
+    while (pending_.empty()) {
+      for (py::handle event : Drain(0))
+        pending_.push_back(py::reinterpret_borrow<py::object>(event));
+      if (!pending_.empty()) break;
+      if (queue_->IsClosed()) return py::object();
+      // in slices, so that Ctrl-C gets through
+      Wait(100);
+      if (PyErr_CheckSignals() != 0) throw py::error_already_set();
+    }
+    py::object event = pending_.front();
+    pending_.pop_front();
+    return event;
+  }
+
+  void Close() {
+    callback_->RemoveEventQueue(queue_);
+    queue_->Close();
+  }
+
+  const std::shared_ptr<EventQueue> &Queue() const { return queue_; }
+
+ private:
+  py::tuple ToTuple(const DeviceEvent &event) const {
+    std::shared_ptr<DeviceInstance> device = callback_->Routes().Find(event.device).device;
+    py::str label(device ? device->GetLabel() : std::string());
+    switch (event.kind) {
+      case DeviceEvent::PropertyChanged:
+        return py::make_tuple("PropertyChanged", label, event.name, event.value);
+      case DeviceEvent::StagePositionChanged:
+        return py::make_tuple("StagePositionChanged", label, event.a);
+      case DeviceEvent::XYStagePositionChanged:
+        return py::make_tuple("XYStagePositionChanged", label, event.a, event.b);
+      case DeviceEvent::ExposureChanged:
+        return py::make_tuple("ExposureChanged", label, event.a);
+      case DeviceEvent::SLMExposureChanged:
+        return py::make_tuple("SLMExposureChanged", label, event.a);
+      case DeviceEvent::MagnifierChanged:
+        return py::make_tuple("MagnifierChanged", label);
+      default:
+        return py::make_tuple("PropertiesChanged", label);
+    }
+  }
+
+  const std::shared_ptr<PyCoreCallback> callback_;
+  const std::shared_ptr<EventQueue> queue_;
+  const bool coalesce_;
+  std::vector<DeviceEvent> batch_;
+  std::deque<py::object> pending_;  // drained but not yet returned by Next()
+};
+
+// Calls `fn(i, *devices[i])` for every device, with one task per adapter module.  Each task
+// holds its module's lock throughout, so devices sharing a library are visited in order while
+// different libraries run in parallel on up to `maxWorkers` threads (0: one per module).
+// Call without the GIL.  The first exception thrown by `fn` is rethrown once all tasks are done.
+template <typename Fn>
+void forEachDeviceByModule(const std::vector<std::shared_ptr<DeviceInstance>> &devices,
+                           size_t maxWorkers, Fn fn) {
+  std::map<LoadedDeviceAdapter *, std::vector<size_t>> groups;
+  for (size_t i = 0; i < devices.size(); ++i)
+    groups[devices[i]->GetAdapterModule().get()].push_back(i);
+  if (groups.empty()) return;
+
+  ThreadPool pool(maxWorkers == 0 ? groups.size() : std::min(maxWorkers, groups.size()));
+  std::vector<std::future<void>> done;
+  for (auto &group : groups) {
+    done.push_back(pool.Submit([&group, &devices, &fn] {
+      MMThreadGuard lock(group.first->GetLock());
+      for (size_t i : group.second) fn(i, *devices[i]);
+    }));
+  }
+  for (std::future<void> &task : done) task.wait();
+  for (std::future<void> &task : done) task.get();
+}
+
+std::vector<std::shared_ptr<DeviceInstance>> loadedDevices(
+    const mm::DeviceManager &manager, const std::vector<std::string> &labels) {
+  std::vector<std::shared_ptr<DeviceInstance>> devices;
+  for (const std::string &label : labels) devices.push_back(manager.GetDevice(label.c_str()));
+  return devices;
+}
+
+// Reads every property of every loaded device into columns: device, name, value, type and
+// readOnly.
+py::dict snapshotProperties(const mm::DeviceManager &manager, size_t maxWorkers) {
+  struct Row {
+    std::string name, value;
+    MM::PropertyType type;
+    bool readOnly;
+  };
+  std::vector<std::string> labels = manager.GetDeviceList();
+  std::vector<std::shared_ptr<DeviceInstance>> devices = loadedDevices(manager, labels);
+  std::vector<std::vector<Row>> rows(devices.size());
+  {
+    py::gil_scoped_release release;
+    forEachDeviceByModule(devices, maxWorkers, [&rows](size_t i, DeviceInstance &device) {
+      for (const std::string &name : device.GetPropertyNames())
+        rows[i].push_back({name, device.GetProperty(name), device.GetPropertyType(name),
+                           device.GetPropertyReadOnly(name)});
+    });
+  }
+
+  py::list deviceColumn, nameColumn, valueColumn, typeColumn, readOnlyColumn;
+  for (size_t i = 0; i < devices.size(); ++i) {
+    py::str label(labels[i]);
+    for (const Row &row : rows[i]) {
+      deviceColumn.append(label);
+      nameColumn.append(row.name);
+      valueColumn.append(row.value);
+      typeColumn.append(row.type);
+      readOnlyColumn.append(row.readOnly);
+    }
+  }
+  py::dict snapshot;
+  snapshot["device"] = deviceColumn;
+  snapshot["name"] = nameColumn;
+  snapshot["value"] = valueColumn;
+  snapshot["type"] = typeColumn;
+  snapshot["readOnly"] = readOnlyColumn;
+  return snapshot;
+}
+
+// Sets the properties in a snapshot whose current value differs, device by device in snapshot
+// order.  Read-only properties are skipped.  Returns the (device, name) pairs that were set;
+// failures don't stop the other properties and are reported together at the end.
+std::vector<std::pair<std::string, std::string>> applyProperties(
+    const mm::DeviceManager &manager, const py::dict &snapshot, size_t maxWorkers) {
+  auto column = [&snapshot](const char *key) {
+    if (!snapshot.contains(key))
+      throw py::value_error(std::string("snapshot has no '") + key + "' column");
+    return snapshot[key].cast<std::vector<std::string>>();
+  };
+  std::vector<std::string> deviceColumn = column("device");
+  std::vector<std::string> nameColumn = column("name");
+  std::vector<std::string> valueColumn = column("value");
+  std::vector<bool> readOnlyColumn(deviceColumn.size(), false);
+  if (snapshot.contains("readOnly"))
+    readOnlyColumn = snapshot["readOnly"].cast<std::vector<bool>>();
+  if (nameColumn.size() != deviceColumn.size() || valueColumn.size() != deviceColumn.size() ||
+      readOnlyColumn.size() != deviceColumn.size())
+    throw py::value_error("snapshot columns must all have the same length");
+
+  // group the rows by device, keeping their order
+  std::vector<std::string> labels;
+  std::map<std::string, std::vector<size_t>> rowsOf;
+  for (size_t r = 0; r < deviceColumn.size(); ++r) {
+    if (readOnlyColumn[r]) continue;
+    std::vector<size_t> &deviceRows = rowsOf[deviceColumn[r]];
+    if (deviceRows.empty()) labels.push_back(deviceColumn[r]);
+    deviceRows.push_back(r);
+  }
+  std::vector<std::shared_ptr<DeviceInstance>> devices = loadedDevices(manager, labels);
+
+  std::vector<std::vector<size_t>> changed(devices.size());
+  std::vector<std::vector<std::string>> errors(devices.size());
+  {
+    py::gil_scoped_release release;
+    forEachDeviceByModule(devices, maxWorkers, [&](size_t i, DeviceInstance &device) {
+      std::shared_ptr<PropertyCache> cache = propertyCaches().Find(device.GetRawPtr());
+      for (size_t r : rowsOf.at(labels[i])) {
+        const std::string &name = nameColumn[r];
+        try {
+          if (device.GetPropertyReadOnly(name) || device.GetProperty(name) == valueColumn[r])
+            continue;
+          device.SetProperty(name, valueColumn[r]);
+          if (cache) cache->Invalidate(name);
+          changed[i].push_back(r);
+        } catch (const std::exception &e) {
+          errors[i].push_back(labels[i] + "." + name + ": " + e.what());
+        }
+      }
+    });
+  }
+
+  std::string message;
+  std::vector<std::pair<std::string, std::string>> applied;
+  for (size_t i = 0; i < devices.size(); ++i) {
+    for (size_t r : changed[i]) applied.emplace_back(deviceColumn[r], nameColumn[r]);
+    for (const std::string &error : errors[i]) message += "\n  " + error;
+  }
+  if (!message.empty()) throw std::runtime_error("Failed to apply properties:" + message);
+  return applied;
+}
+
+std::shared_ptr<DeviceInstance> loadManagedDevice(mm::DeviceManager &manager,
+                                                  std::shared_ptr<LoadedDeviceAdapter> module,
+                                                  const std::string &deviceName,
+                                                  const std::string &label) {
+  std::shared_ptr<DeviceInstance> dev =
+      manager.LoadDevice(module, deviceName, label, sharedMockCore(), deviceLogger(label),
+                         deviceLogger(label));
+  forgetDevice(dev->GetRawPtr());
+  std::shared_ptr<PyCoreCallback> callback = managerCallbacks().Find(&manager);
+  if (callback) {
+    dev->SetCallback(callback.get());
+    callback->Routes().Update(manager);
+  } else {
+    dev->SetCallback(defaultCoreCallback());
+  }
+  profileDevice(manager, *dev);
+  return dev;
+}
+
+// DeviceManager.EnableCallStats: (re)starts or stops profiling every device of the manager.
+void enableCallStats(mm::DeviceManager &manager, bool enable, size_t traceCapacity) {
+  std::vector<std::string> labels = manager.GetDeviceList();
+  for (const std::string &label : labels)
+    deviceCallStats().Detach(manager.GetDevice(label.c_str())->GetRawPtr());
+  managerCallProfiles().Detach(&manager);
+  if (!enable) return;
+  managerCallProfiles().Attach(&manager, std::make_shared<CallProfile>(traceCapacity));
+  for (const std::string &label : labels) profileDevice(manager, *manager.GetDevice(label.c_str()));
+}
+
+// DeviceManager.GetCallStats: {label: {method: {stat: value}}}, merging devices that were
+// reloaded under the same label.
+py::dict getCallStats(const mm::DeviceManager &manager) {
+  std::map<std::string, std::map<std::string, CallStats::Method>> merged;
+  std::shared_ptr<CallProfile> profile = managerCallProfiles().Find(&manager);
+  if (profile)
+    for (const std::shared_ptr<const CallStats> &device : profile->GetDevices())
+      for (const auto &method : device->GetMethods())
+        merged[device->GetLabel()][method.first].Merge(method.second);
+
+  auto ms = [](double ns) { return ns / 1e6; };
+  py::dict result;
+  for (const auto &device : merged) {
+    py::dict methods;
+    for (const auto &entry : device.second) {
+      const CallStats::Method &method = entry.second;
+      py::dict stats;
+      stats["count"] = method.count;
+      stats["total_ms"] = ms(method.totalNs);
+      stats["mean_ms"] = ms(static_cast<double>(method.totalNs) / method.count);
+      stats["min_ms"] = ms(method.minNs);
+      stats["max_ms"] = ms(method.maxNs);
+      stats["p50_ms"] = ms(method.histogram.Quantile(0.5));
+      stats["p99_ms"] = ms(method.histogram.Quantile(0.99));
+      stats["lock_wait_ms"] = ms(method.lockWaitNs);
+      stats["adapter_ms"] = ms(method.adapterNs);
+      methods[py::str(entry.first)] = stats;
+    }
+    result[py::str(device.first)] = methods;
+  }
+  return result;
+}
+
+// DeviceManager.ExportCallTrace
+size_t exportCallTrace(const mm::DeviceManager &manager, const std::string &path) {
+  std::shared_ptr<CallProfile> profile = managerCallProfiles().Find(&manager);
+  if (!profile || !profile->GetTrace())
+    throw std::runtime_error("Call tracing is not enabled (see EnableCallStats)");
+  std::ofstream out(path, std::ios::trunc);
+  if (!out) throw std::runtime_error("Cannot create call trace " + path);
+  return profile->GetTrace()->Write(out);
+}
+
+// Loads every (module, deviceName, label[, parentLabel]) spec, then initializes them all.
+//
+// A device depends on its parent hub: the one named in its spec, or else a hub loaded from the
+// same module in this batch that lists the device among its installed peripherals once it is
+// initialized; that hub becomes its parent ID.  A hub always shares its peripherals' module,
+// and a module's lock admits one device call at a time anyway, so the schedule is one task per
+// module that initializes its hubs before the rest (skipping the peripherals of a hub that
+// failed), with modules running in parallel.  Returns how long each device took to initialize,
+// in ms; failures are reported together once all are done.
+py::dict loadAndInitializeAll(mm::DeviceManager &manager, const std::vector<py::tuple> &specs,
+                              size_t maxWorkers) {
+  const size_t n = specs.size();
+  std::vector<std::shared_ptr<DeviceInstance>> devices;
+  std::vector<std::string> labels, parents;
+  for (const py::tuple &spec : specs) {
+    if (spec.size() != 3 && spec.size() != 4)
+      throw py::value_error(
+          "each spec must be (module, deviceName, label) or (module, deviceName, label, "
+          "parentLabel)");
+    auto module = spec[0].cast<std::shared_ptr<LoadedDeviceAdapter>>();
+    std::string label = spec[2].cast<std::string>();
+    devices.push_back(loadManagedDevice(manager, module, spec[1].cast<std::string>(), label));
+    labels.push_back(label);
+    parents.push_back(spec.size() == 4 ? spec[3].cast<std::string>() : "");
+  }
+
+  // resolve each named parent hub within the batch (-1 for none); the others are looked up
+  // among the hubs' installed peripherals as the hubs come up
+  std::map<LoadedDeviceAdapter *, std::vector<size_t>> hubsOf;
+  for (size_t i = 0; i < n; ++i)
+    if (devices[i]->GetType() == MM::HubDevice)
+      hubsOf[devices[i]->GetAdapterModule().get()].push_back(i);
+  std::vector<long> parentOf(n, -1);
+  for (size_t i = 0; i < n; ++i) {
+    if (devices[i]->GetType() == MM::HubDevice || parents[i].empty()) continue;
+    const std::vector<size_t> &hubs = hubsOf[devices[i]->GetAdapterModule().get()];
+    auto hub = std::find_if(hubs.begin(), hubs.end(),
+                            [&](size_t h) { return labels[h] == parents[i]; });
+    if (hub != hubs.end()) parentOf[i] = static_cast<long>(*hub);
+    util::DeviceCallGuard guard(*devices[i]);
+    devices[i]->SetParentID(parents[i].c_str());
+  }
+
+  // hubs first; otherwise keep the given order
+  std::vector<size_t> order(n);
+  for (size_t i = 0; i < n; ++i) order[i] = i;
+  std::stable_partition(order.begin(), order.end(),
+                        [&](size_t i) { return devices[i]->GetType() == MM::HubDevice; });
+  std::vector<std::shared_ptr<DeviceInstance>> ordered;
+  for (size_t i : order) ordered.push_back(devices[i]);
+
+  std::vector<double> elapsed(n, 0.0);
+  std::vector<char> failed(n, 0);
+  std::vector<std::string> errors(n);
+  std::vector<std::vector<std::string>> peripherals(n);
+  {
+    py::gil_scoped_release release;
+    forEachDeviceByModule(ordered, maxWorkers, [&](size_t k, DeviceInstance &device) {
+      const size_t i = order[k];
+      auto hubs = hubsOf.find(device.GetAdapterModule().get());
+      if (device.GetType() != MM::HubDevice && parents[i].empty() && hubs != hubsOf.end()) {
+        for (size_t hub : hubs->second) {
+          const std::vector<std::string> &names = peripherals[hub];
+          if (std::find(names.begin(), names.end(), device.GetName()) == names.end()) continue;
+          parentOf[i] = static_cast<long>(hub);
+          device.SetParentID(labels[hub].c_str());
+          break;
+        }
+      }
+      // a hub and its peripherals share a module, so the hub's task already ran, on this thread
+      if (parentOf[i] >= 0 && failed[parentOf[i]]) {
+        failed[i] = 1;
+        errors[i] = "parent hub " + ToQuotedString(labels[parentOf[i]]) + " failed to initialize";
+        return;
+      }
+      const auto start = std::chrono::steady_clock::now();
+      try {
+        device.Initialize();
+      } catch (const std::exception &e) {
+        failed[i] = 1;
+        errors[i] = e.what();
+      }
+      std::chrono::duration<double, std::milli> took = std::chrono::steady_clock::now() - start;
+      elapsed[i] = took.count();
+      if (device.GetType() == MM::HubDevice && !failed[i]) {
+        try {
+          peripherals[i] = static_cast<HubInstance &>(device).GetInstalledPeripheralNames();
+        } catch (const std::exception &) {
+          // a hub that can't list its peripherals adopts none
+        }
+      }
+    });
+  }
+
+  py::dict timings;
+  std::string message;
+  for (size_t i = 0; i < n; ++i) {
+    timings[py::str(labels[i])] = elapsed[i];
+    if (failed[i]) message += "\n  " + labels[i] + ": " + errors[i];
+  }
+  if (!message.empty()) throw std::runtime_error("Failed to initialize devices:" + message);
+  return timings;
+}
+
+// Waits until none of `devices` is busy, polling each one's Busy() (under its module lock;
+// call without the GIL) on a schedule of its own: first after the device's delay, if it uses
+// one, then at intervals that double from kFirstPollMs up to kMaxPollMs, so a quick device is
+// caught at once and a slow one isn't hammered.  A stage position notification through
+// `callback` (if any) -- many stages send one on arriving -- makes every device due at once.
+// Returns how long each device took to settle, in ms, or -1 for those still busy at `deadline`.
+std::vector<double> settleDevices(const std::vector<std::shared_ptr<DeviceInstance>> &devices,
+                                  PyCoreCallback *callback,
+                                  std::chrono::steady_clock::time_point deadline) {
+  using Clock = std::chrono::steady_clock;
+  using Ms = std::chrono::duration<double, std::milli>;
+  const double kFirstPollMs = 0.5;
+  const double kMaxPollMs = 10.0;
+
+  struct Waiting {
+    Clock::time_point delayedUntil;
+    Clock::time_point nextPoll;
+    double intervalMs;
+  };
+  const Clock::time_point start = Clock::now();
+  std::vector<Waiting> waiting(devices.size());
+  std::vector<double> settledMs(devices.size(), -1.0);
+  for (size_t i = 0; i < devices.size(); ++i) {
+    MMThreadGuard lock(devices[i]->GetAdapterModule()->GetLock());
+    double delayMs = devices[i]->UsesDelay() ? devices[i]->GetDelayMs() : 0.0;
+    waiting[i].delayedUntil = start + std::chrono::duration_cast<Clock::duration>(Ms(delayMs));
+    waiting[i].nextPoll = waiting[i].delayedUntil;
+    waiting[i].intervalMs = kFirstPollMs;
+  }
+
+  size_t remaining = devices.size();
+  while (remaining > 0) {
+    const uint64_t moves = callback ? callback->GetMoveCount() : 0;
+    Clock::time_point now = Clock::now();
+    const bool last = now >= deadline;  // a final look at every device before giving up
+    Clock::time_point wakeAt = deadline;
+    for (size_t i = 0; i < devices.size(); ++i) {
+      if (settledMs[i] >= 0) continue;
+      Waiting &w = waiting[i];
+      if (w.nextPoll <= now || last) {
+        bool busy;
+        {
+          MMThreadGuard lock(devices[i]->GetAdapterModule()->GetLock());
+          busy = devices[i]->Busy();
+        }
+        now = Clock::now();
+        if (!busy && now >= w.delayedUntil) {
+          settledMs[i] = Ms(now - start).count();
+          --remaining;
+          continue;
+        }
+        w.nextPoll = std::max(w.delayedUntil, now + std::chrono::duration_cast<Clock::duration>(
+                                                        Ms(w.intervalMs)));
+        w.intervalMs = std::min(w.intervalMs * 2, kMaxPollMs);
+      }
+      wakeAt = std::min(wakeAt, w.nextPoll);
+    }
+    if (remaining == 0 || last) break;
+
+    if (!callback) {
+      std::this_thread::sleep_until(wakeAt);
+      continue;
+    }
+    callback->WaitForMove(moves, wakeAt);
+    if (callback->GetMoveCount() == moves) continue;
+    now = Clock::now();
+    for (Waiting &w : waiting) w.nextPoll = std::max(w.delayedUntil, now);
+  }
+  return settledMs;
+}
+
+// The deadline `timeout` seconds from now; none if it is None.
+std::chrono::steady_clock::time_point deadlineAfter(py::object timeout) {
+  using Clock = std::chrono::steady_clock;
+  if (timeout.is_none()) return Clock::time_point::max();
+  return Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                            std::chrono::duration<double>(timeout.cast<double>()));
+}
+
+// DeviceManager.WaitForDevices: settleDevices for the labelled devices, or TimeoutError.
+py::dict waitForDevices(mm::DeviceManager &manager, const std::vector<std::string> &labels,
+                        py::object timeout) {
+  std::vector<std::shared_ptr<DeviceInstance>> devices;
+  for (const std::string &label : labels) devices.push_back(manager.GetDevice(label.c_str()));
+  std::shared_ptr<PyCoreCallback> callback = managerCallbacks().Find(&manager);
+  const auto start = std::chrono::steady_clock::now();
+  const auto deadline = deadlineAfter(timeout);
+  std::vector<double> settledMs;
+  {
+    py::gil_scoped_release release;
+    settledMs = settleDevices(devices, callback.get(), deadline);
+  }
+
+  py::dict settled;
+  std::string busy;
+  for (size_t i = 0; i < devices.size(); ++i) {
+    if (settledMs[i] >= 0)
+      settled[py::str(devices[i]->GetLabel())] = settledMs[i];
+    else
+      busy += (busy.empty() ? "" : ", ") + ToQuotedString(devices[i]->GetLabel());
+  }
+  if (!busy.empty()) {
+    std::chrono::duration<double, std::milli> waited = std::chrono::steady_clock::now() - start;
+    PyErr_SetString(PyExc_TimeoutError, ("Devices still busy after " +
+                                         std::to_string(std::lround(waited.count())) +
+                                         " ms: " + busy)
+                                            .c_str());
+    throw py::error_already_set();
+  }
+  return settled;
+}
+
+// CPluginManager, plus the adapter index it may serve device listings from and the background
+// discovery scan it may be running.
+class PyPluginManager : public CPluginManager {
+ public:
+  std::shared_ptr<AdapterIndex> index;
+  std::shared_ptr<AdapterDiscovery> discovery;
+};
+
+// Records the devices a loaded adapter library advertises.
+void describeAdapter(LoadedDeviceAdapter &module, IndexedAdapter &adapter) {
+  for (const std::string &name : module.GetAvailableDeviceNames()) {
+    adapter.devices.push_back({name, static_cast<int>(module.GetAdvertisedDeviceType(name)),
+                               module.GetDeviceDescription(name)});
+  }
+}
+
+// Loads one adapter library just long enough to record what it advertises.
+IndexedAdapter probeAdapter(const AdapterFile &file) {
+  IndexedAdapter adapter;
+  adapter.file = file;
+  try {
+    auto module = std::make_shared<LoadedDeviceAdapter>(file.moduleName, file.path);
+    describeAdapter(*module, adapter);
+    module->Unload();
+  } catch (const std::exception &e) {
+    adapter.error = e.what();
+  }
+  return adapter;
+}
+
+// Cancels the manager's discovery scan, if any, waiting (without the GIL) for the libraries it
+// is probing right now.
+void stopDiscovery(PyPluginManager &manager) {
+  std::shared_ptr<AdapterDiscovery> discovery = std::move(manager.discovery);
+  if (!discovery) return;
+  py::gil_scoped_release release;
+  discovery->Cancel();
+  discovery->Wait(-1);
+}
+
+// Like CPluginManager::GetDeviceAdapter, but while a discovery scan is running, a module it
+// has not reached yet is loaded (and validated) right away instead of waiting its turn.  One
+// that a worker is probing right now is waited for, and not loaded if the probe failed.
+std::shared_ptr<LoadedDeviceAdapter> getDeviceAdapter(PyPluginManager &manager,
+                                                      const std::string &moduleName) {
+  std::shared_ptr<AdapterDiscovery> discovery = manager.discovery;
+  if (!discovery) return manager.GetDeviceAdapter(moduleName);
+  if (!discovery->Claim(moduleName)) {
+    // never load a library while a worker loads it too: the module's own initialization
+    // would race with itself
+    IndexedAdapter probed;
+    bool validated;
+    {
+      py::gil_scoped_release release;
+      validated = discovery->WaitForProbe(moduleName, probed);
+    }
+    if (validated && !probed.error.empty()) throw std::runtime_error(probed.error);
+    return manager.GetDeviceAdapter(moduleName);
+  }
+
+  IndexedAdapter adapter;
+  try {
+    std::shared_ptr<LoadedDeviceAdapter> module = manager.GetDeviceAdapter(moduleName);
+    describeAdapter(*module, adapter);
+    discovery->Record(moduleName, adapter);
+    return module;
+  } catch (const std::exception &e) {
+    adapter.devices.clear();
+    adapter.error = e.what();
+    discovery->Record(moduleName, adapter);
+    throw;
+  }
+}
+
+size_t refreshAdapterIndex(PyPluginManager &manager) {
+  if (!manager.index) throw std::runtime_error("The adapter index is not enabled");
+  std::vector<std::string> searchPaths = manager.GetSearchPaths();
+  py::gil_scoped_release release;
+  return manager.index->Refresh(AdapterIndex::Scan(searchPaths), probeAdapter);
+}
+
+// Like MMCore, size a default sequence buffer by memory footprint rather than frame count.
+const size_t kDefaultSequenceBufferMB = 250;
+
+// The camera's multi-ROI rectangles relative to its image, or none if multi-ROI is not set.
+// A multi-ROI camera delivers the bounding box of all its ROIs, so each ROI sits at its offset
+// from the top-left-most one.
+std::vector<SequenceBuffer::Rect> multiROIRects(CameraInstance &camera) {
+  std::vector<SequenceBuffer::Rect> rects;
+  if (!camera.IsMultiROISet()) return rects;
+  unsigned count = 0;
+  int ret = camera.GetMultiROICount(count);
+  if (ret != DEVICE_OK) throw std::runtime_error(getErrorMessage(&camera, ret));
+  std::vector<unsigned> xs(count), ys(count), widths(count), heights(count);
+  ret = camera.GetMultiROI(xs.data(), ys.data(), widths.data(), heights.data(), &count);
+  if (ret != DEVICE_OK) throw std::runtime_error(getErrorMessage(&camera, ret));
+  if (count == 0) return rects;
+
+  unsigned left = *std::min_element(xs.begin(), xs.begin() + count);
+  unsigned top = *std::min_element(ys.begin(), ys.begin() + count);
+  unsigned width = camera.GetImageWidth(), height = camera.GetImageHeight();
+  for (unsigned i = 0; i < count; ++i) {
+    SequenceBuffer::Rect rect{xs[i] - left, ys[i] - top, widths[i], heights[i]};
+    if (rect.x + rect.width > width || rect.y + rect.height > height)
+      throw std::runtime_error("ROI " + std::to_string(i) + " does not fit in the " +
+                               std::to_string(width) + "x" + std::to_string(height) +
+                               " camera image");
+    rects.push_back(rect);
+  }
+  return rects;
+}
+
+std::shared_ptr<SequenceBuffer> initializeSequenceBuffer(CameraInstance &camera,
+                                                         size_t capacity) {
+  unsigned width = camera.GetImageWidth();
+  unsigned height = camera.GetImageHeight();
+  unsigned bytesPerPixel = camera.GetImageBytesPerPixel();
+  std::vector<SequenceBuffer::Rect> rois = multiROIRects(camera);
+  if (capacity == 0) {
+    size_t frameBytes =
+        std::max<size_t>(1, SequenceBuffer::FrameBytes(width, height, bytesPerPixel, rois));
+    capacity = std::max<size_t>(2, kDefaultSequenceBufferMB * 1024 * 1024 / frameBytes);
+  }
+  auto buffer =
+      std::make_shared<SequenceBuffer>(width, height, bytesPerPixel, capacity, std::move(rois));
+  sequenceBuffers().Attach(camera.GetRawPtr(), buffer);
+  return buffer;
+}
+
+// Waits, without the GIL or the camera's lock, until the camera's processing pipeline (if any)
+// has handed on every queued frame.  Call before prepareSequenceBuffer(): the processors may
+// belong to the camera's adapter module, and so need its lock to finish.
+void drainFramePipeline(CameraInstance &camera) {
+  std::shared_ptr<FramePipeline> pipeline = framePipelines().Find(camera.GetRawPtr());
+  if (pipeline) pipeline->WaitIdle(-1);
+}
+
+// Called before a sequence starts, with the camera's lock held: reuse the camera's buffer if
+// the frame geometry and ROIs still match, otherwise reallocate it (keeping the requested
+// capacity).  The camera's processing pipeline, if any, is sized for the new frames first.
+void prepareSequenceBuffer(CameraInstance &camera) {
+  std::shared_ptr<FramePipeline> pipeline = framePipelines().Find(camera.GetRawPtr());
+  if (pipeline)
+    pipeline->Prepare(camera.GetImageWidth(), camera.GetImageHeight(),
+                      camera.GetImageBytesPerPixel());
+  std::shared_ptr<SequenceBuffer> buffer = sequenceBuffers().Find(camera.GetRawPtr());
+  if (buffer &&
+      buffer->Matches(camera.GetImageWidth(), camera.GetImageHeight(),
+                      camera.GetImageBytesPerPixel()) &&
+      buffer->GetROIs() == multiROIRects(camera)) {
+    buffer->Clear();
+    return;
+  }
+  initializeSequenceBuffer(camera, buffer ? buffer->GetCapacity() : 0);
+}
+
+// Attaches a FramePipeline running `processors` to the camera, replacing any earlier one; with
+// no processors, just detaches it.
+void setImageProcessors(CameraInstance &camera,
+                        const std::vector<std::shared_ptr<ImageProcessorInstance>> &processors,
+                        size_t queueFrames) {
+  const MM::Device *device = camera.GetRawPtr();
+  std::shared_ptr<FramePipeline> previous = framePipelines().Find(device);
+  framePipelines().Detach(device);
+  {
+    py::gil_scoped_release release;
+    previous.reset();  // joins its worker
+  }
+  if (processors.empty()) return;
+
+  std::vector<FramePipeline::Stage> stages;
+  for (const std::shared_ptr<ImageProcessorInstance> &processor : processors) {
+    stages.push_back([processor](unsigned char *frame, unsigned width, unsigned height,
+                                 unsigned bytesPerPixel) {
+      MMThreadGuard lock(processor->GetAdapterModule()->GetLock());
+      int ret = processor->Process(frame, width, height, bytesPerPixel);
+      return ret == DEVICE_OK ? std::string() : getErrorMessage(processor.get(), ret);
+    });
+  }
+  auto pipeline = std::make_shared<FramePipeline>(
+      std::move(stages), [device] { return sequenceBuffers().Find(device); }, queueFrames);
+  {
+    util::DeviceCallGuard guard(camera);
+    pipeline->Prepare(camera.GetImageWidth(), camera.GetImageHeight(),
+                      camera.GetImageBytesPerPixel());
+  }
+  framePipelines().Attach(device, pipeline);
+}
+
+// Snaps `n` frames back to back into the first `n` planes of `out`, a C-contiguous
+// (N, height, width) stack whose itemsize matches the camera's bytes per pixel.  The whole
+// loop runs without the GIL; the adapter module lock is taken per frame so that other devices
+// in the same module (e.g. a focus drive) can be moved between calls.  Returns the time at
+// which each frame was read out, in ms since the call started.
+py::array_t<double> snapInto(CameraInstance &camera, py::array out, long n) {
+  unsigned width, height, bytesPerPixel;
+  {
+    util::DeviceCallGuard guard(camera);
+    width = camera.GetImageWidth();
+    height = camera.GetImageHeight();
+    bytesPerPixel = camera.GetImageBytesPerPixel();
+  }
+  if (out.ndim() != 3)
+    throw py::value_error("out must be a 3-D (N, height, width) array, got " +
+                          std::to_string(out.ndim()) + " dimensions");
+  if (out.shape(1) != static_cast<py::ssize_t>(height) ||
+      out.shape(2) != static_cast<py::ssize_t>(width))
+    throw py::value_error("out frames are " + std::to_string(out.shape(1)) + "x" +
+                          std::to_string(out.shape(2)) + " but the camera image is " +
+                          std::to_string(height) + "x" + std::to_string(width));
+  if (out.itemsize() != static_cast<py::ssize_t>(bytesPerPixel))
+    throw py::value_error("out has " + std::to_string(out.itemsize()) +
+                          " bytes per item but the camera has " +
+                          std::to_string(bytesPerPixel) + " bytes per pixel");
+  if (!(out.flags() & py::array::c_style)) throw py::value_error("out must be C-contiguous");
+  if (!out.writeable()) throw py::value_error("out must be writeable");
+  if (n < 0) n = static_cast<long>(out.shape(0));
+  if (n > out.shape(0))
+    throw py::value_error("Cannot snap " + std::to_string(n) + " frames into a stack of " +
+                          std::to_string(out.shape(0)));
+
+  py::array_t<double> timestamps(n);
+  double *stamps = timestamps.mutable_data();
+  auto *dest = static_cast<unsigned char *>(out.mutable_data());
+  const size_t frameBytes = static_cast<size_t>(width) * height * bytesPerPixel;
+
+  py::gil_scoped_release release;
+  const auto start = std::chrono::steady_clock::now();
+  for (long i = 0; i < n; ++i, dest += frameBytes) {
+    MMThreadGuard lock(camera.GetAdapterModule()->GetLock());
+    int ret = camera.SnapImage();
+    if (ret != DEVICE_OK) throw std::runtime_error(getErrorMessage(&camera, ret));
+    const unsigned char *buffer = camera.GetImageBuffer();
+    if (buffer == nullptr || static_cast<size_t>(camera.GetImageBufferSize()) != frameBytes)
+      throw std::runtime_error("Camera image size changed during SnapInto");
+    std::memcpy(dest, buffer, frameBytes);
+    stamps[i] =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+            .count();
+  }
+  return timestamps;
+}
+
+// Copies every channel of the last snapped image into one freshly allocated array:
+// (C, height, width) for grayscale cameras, and (height, width, 4) RGBA -- or (C, height,
+// width, 4) with several channels -- for RGB32 cameras, whose BGRA pixels are reordered on
+// the way.
+py::array getImageChannels(CameraInstance &camera) {
+  unsigned width, height, bytesPerPixel, nComponents, nChannels;
+  {
+    util::DeviceCallGuard guard(camera);
+    width = camera.GetImageWidth();
+    height = camera.GetImageHeight();
+    bytesPerPixel = camera.GetImageBytesPerPixel();
+    nComponents = camera.GetNumberOfComponents();
+    nChannels = std::max(camera.GetNumberOfChannels(), 1u);
+  }
+  const bool rgb = nComponents == 4 && bytesPerPixel == 4;
+  const size_t planeBytes = static_cast<size_t>(width) * height * bytesPerPixel;
+
+  py::array out;
+  if (rgb) {
+    std::vector<py::ssize_t> shape = {static_cast<py::ssize_t>(height),
+                                      static_cast<py::ssize_t>(width), 4};
+    if (nChannels > 1) shape.insert(shape.begin(), nChannels);
+    out = py::array(py::dtype::of<uint8_t>(), shape);
+  } else {
+    py::array plane = util::bufferToNumpy(nullptr, height, width, bytesPerPixel);
+    out = py::array(plane.dtype(), {static_cast<py::ssize_t>(nChannels),
+                                    static_cast<py::ssize_t>(height),
+                                    static_cast<py::ssize_t>(width)});
+  }
+  auto *dest = static_cast<uint8_t *>(out.mutable_data());
+
+  {
+    util::DeviceCallGuard guard(camera);
+    for (unsigned c = 0; c < nChannels; ++c, dest += planeBytes) {
+      const unsigned char *buffer =
+          rgb && nChannels == 1
+              ? reinterpret_cast<const unsigned char *>(camera.GetImageBufferAsRGB32())
+              : camera.GetImageBuffer(c);
+      if (buffer == nullptr)
+        throw std::runtime_error("No image in the camera buffer; call SnapImage first");
+      if (rgb)
+        pixels::bgraToRgba(buffer, dest, static_cast<size_t>(width) * height);
+      else
+        std::memcpy(dest, buffer, planeBytes);
+    }
+  }
+  return out;
+}
+
+void checkDeviceError(DeviceInstance &device, int ret) {
+  if (ret != DEVICE_OK) throw std::runtime_error(getErrorMessage(&device, ret));
+}
+
+// Raised (as pymmdevice.SequenceError, a RuntimeError) when a sequence upload is rejected.
+class SequenceError : public std::runtime_error {
+ public:
+  using std::runtime_error::runtime_error;
+};
+
+using DoubleArray = py::array_t<double, py::array::c_style | py::array::forcecast>;
+
+// Adds `n` points to a device sequence in one loop, under a single DeviceCallGuard.
+// `maxLength(long &)` and `add(i)` are the device's Get*SequenceMaxLength and AddTo*Sequence
+// calls; the whole upload, together with the points already queued (see
+// queuedSequencePoints), is checked against the former before anything is added.  Returns the
+// time taken, in ms.
+template <typename MaxLength, typename Add>
+double addToSequence(DeviceInstance &device, size_t n, MaxLength maxLength, Add add) {
+  util::DeviceCallGuard guard(device);
+  const auto start = std::chrono::steady_clock::now();
+  long max = 0;
+  int ret = maxLength(max);
+  if (ret != DEVICE_OK) throw SequenceError(getErrorMessage(&device, ret));
+  if (max <= 0)
+    throw SequenceError("Device " + ToQuotedString(device.GetLabel()) + " is not sequenceable");
+  std::shared_ptr<size_t> queued = queuedSequencePoints().FindOrAttach(device.GetRawPtr());
+  if (*queued > static_cast<size_t>(max) || n > static_cast<size_t>(max) - *queued)
+    throw SequenceError("Cannot add " + std::to_string(n) + " points to the sequence of " +
+                        ToQuotedString(device.GetLabel()) + ", which already holds " +
+                        std::to_string(*queued) + " of at most " + std::to_string(max));
+  for (size_t i = 0; i < n; ++i) {
+    ret = add(i);
+    if (ret != DEVICE_OK)
+      throw SequenceError(getErrorMessage(&device, ret) + " at point " + std::to_string(i) +
+                          " of " + std::to_string(n));
+    ++*queued;
+  }
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+// Wraps a device's single-point AddTo*Sequence for binding, counting the point as queued.
+template <typename DType, typename Class, typename... Args>
+auto addToSequenceCall(int (Class::*add)(Args...)) {
+  return [add](DType &self, Args... args) {
+    util::DeviceCallGuard guard(self);
+    int ret = (self.*add)(args...);
+    if (ret == DEVICE_OK) ++*queuedSequencePoints().FindOrAttach(self.GetRawPtr());
+    return ret;
+  };
+}
+
+// Wraps a device's Clear*Sequence for binding, resetting its count of queued points.
+template <typename DType, typename Class>
+auto clearSequenceCall(int (Class::*clear)()) {
+  return [clear](DType &self) {
+    util::DeviceCallGuard guard(self);
+    int ret = (self.*clear)();
+    if (ret == DEVICE_OK) queuedSequencePoints().Detach(self.GetRawPtr());
+    return ret;
+  };
+}
+
+// The values of a 1-D array.
+const double *sequenceValues(const DoubleArray &values, const char *name) {
+  if (values.ndim() != 1)
+    throw py::value_error(std::string(name) + " must be a 1-D array, got " +
+                          std::to_string(values.ndim()) + " dimensions");
+  return values.data();
+}
+
+// Where the images in a buffer passed to an SLM are.
+struct SLMImages {
+  size_t count;
+  size_t imageBytes;
+  unsigned bytesPerPixel;
+};
+
+// Checks that `pixels` holds SLM images in the device's own layout -- (height, width) with
+// GetBytesPerPixel()-sized items, or (height, width, components) bytes -- preceded by a stack
+// axis if `allowStack` is set, and C-contiguous so it can be handed to the adapter as is.
+// The adapter only takes 8-bit grayscale or RGB32 images, so the SLM must report one of those.
+SLMImages checkSLMPixels(SLMInstance &slm, const py::buffer_info &pixels, bool allowStack) {
+  unsigned width, height, bytesPerPixel, components;
+  {
+    util::DeviceCallGuard guard(slm);
+    width = slm.GetWidth();
+    height = slm.GetHeight();
+    bytesPerPixel = slm.GetBytesPerPixel();
+    components = slm.GetNumberOfComponents();
+  }
+  if (bytesPerPixel != 1 && bytesPerPixel != 4)
+    throw py::value_error("The SLM reports " + std::to_string(bytesPerPixel) +
+                          " bytes per pixel; only 1 (8-bit) and 4 (RGB32) are supported");
+  if ((bytesPerPixel == 1) != (components == 1))
+    throw py::value_error("The SLM reports " + std::to_string(components) + " components at " +
+                          std::to_string(bytesPerPixel) + " bytes per pixel");
+  const bool perComponent = pixels.ndim >= 3 && pixels.itemsize == 1 && bytesPerPixel > 1 &&
+                            pixels.shape.back() == static_cast<py::ssize_t>(bytesPerPixel);
+  const py::ssize_t lead = pixels.ndim - (perComponent ? 3 : 2);
+  if (lead < 0 || lead > (allowStack ? 1 : 0) ||
+      (!perComponent && pixels.itemsize != static_cast<py::ssize_t>(bytesPerPixel)))
+    throw py::value_error(std::string("pixels must be ") + (allowStack ? "a [N, ]" : "a ") +
+                          "(height, width) array of " + std::to_string(bytesPerPixel) +
+                          "-byte items" +
+                          (bytesPerPixel > 1
+                               ? " or (height, width, " + std::to_string(bytesPerPixel) + ") bytes"
+                               : ""));
+  if (pixels.shape[lead] != static_cast<py::ssize_t>(height) ||
+      pixels.shape[lead + 1] != static_cast<py::ssize_t>(width))
+    throw py::value_error("pixels are " + std::to_string(pixels.shape[lead]) + "x" +
+                          std::to_string(pixels.shape[lead + 1]) + " but the SLM is " +
+                          std::to_string(height) + "x" + std::to_string(width));
+  py::ssize_t stride = pixels.itemsize;
+  for (py::ssize_t d = pixels.ndim - 1; d >= 0; --d) {
+    if (pixels.shape[d] > 1 && pixels.strides[d] != stride)
+      throw py::value_error("pixels must be C-contiguous");
+    stride *= pixels.shape[d];
+  }
+  return {lead ? static_cast<size_t>(pixels.shape[0]) : 1,
+          static_cast<size_t>(width) * height * bytesPerPixel, bytesPerPixel};
+}
+
+// The adapter has separate entry points for 8-bit and RGB32 images (see checkSLMPixels).
+int setSLMImage(SLMInstance &slm, unsigned char *pixels, unsigned bytesPerPixel) {
+  if (bytesPerPixel == 4) return slm.SetImage(reinterpret_cast<unsigned int *>(pixels));
+  return slm.SetImage(pixels);
+}
+
+int addToSLMSequence(SLMInstance &slm, const unsigned char *pixels, unsigned bytesPerPixel) {
+  if (bytesPerPixel == 4)
+    return slm.AddToSLMSequence(reinterpret_cast<const unsigned int *>(pixels));
+  return slm.AddToSLMSequence(pixels);
+}
+
+bool isContiguousBuffer(const py::buffer_info &info) {
+  py::ssize_t stride = info.itemsize;
+  for (py::ssize_t d = info.ndim - 1; d >= 0; --d) {
+    if (info.shape[d] > 1 && info.strides[d] != stride) return false;
+    stride *= info.shape[d];
+  }
+  return true;
+}
+
+// SerialInstance::Write, recording the bytes if the port is being recorded.  Call under a
+// DeviceCallGuard.
+int writeSerial(SerialInstance &port, const unsigned char *data, size_t length) {
+  int ret = port.Write(data, static_cast<unsigned long>(length));
+  if (ret == DEVICE_OK) recordSerialTraffic(port.GetLabel(), SerialEvent::Write, data, length);
+  return ret;
+}
+
+// Reads whatever has arrived, up to `len` bytes, without waiting.
+size_t readSerial(SerialInstance &port, unsigned char *buf, size_t len) {
+  util::DeviceCallGuard guard(port);
+  size_t count = 0;
+  checkDeviceError(port, serialStream(port)->Read(serialReader(port), buf, len, count));
+  return count;
+}
+
+// Writes each command followed by `term`, keeping up to `window` (0: all) unanswered, and
+// returns the answers in order -- all under one DeviceCallGuard.  On a timeout the port is
+// purged, so that answers still on their way don't turn up in the next read.
+std::vector<std::string> transactSerial(SerialInstance &port,
+                                        const std::vector<std::string> &commands,
+                                        const std::string &term, py::object answerTerm,
+                                        double timeout, size_t window) {
+  const std::string endOfAnswer = answerTerm.is_none() ? term : answerTerm.cast<std::string>();
+  if (term.empty() || endOfAnswer.empty())
+    throw py::value_error("Null or empty terminator; cannot delimit received message");
+  if (window == 0) window = commands.size();
+  const auto wait = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      std::chrono::duration<double>(timeout));
+
+  std::vector<std::string> answers(commands.size());
+  size_t timedOut = commands.size();  // the command whose answer didn't come, if any
+  {
+    util::DeviceCallGuard guard(port);
+    std::shared_ptr<SerialStream> stream = serialStream(port);
+    SerialStream::ReadFn read = serialReader(port);
+    size_t sent = 0;
+    for (size_t i = 0; i < commands.size(); ++i) {
+      // top up the commands in flight, in one write
+      std::string batch;
+      for (; sent < commands.size() && sent < i + window; ++sent) batch += commands[sent] + term;
+      if (!batch.empty())
+        checkDeviceError(
+            port,
+            writeSerial(port, reinterpret_cast<const unsigned char *>(batch.data()), batch.size()));
+      int ret = stream->ReadUntil(read, endOfAnswer, std::chrono::steady_clock::now() + wait,
+                                  answers[i]);
+      if (ret == DEVICE_SERIAL_TIMEOUT) {
+        timedOut = i;  // raised once the GIL is back
+        stream->Clear();
+        if (port.Purge() == DEVICE_OK)
+          recordSerialTraffic(port.GetLabel(), SerialEvent::Purge, nullptr, 0);
+        break;
+      }
+      checkDeviceError(port, ret);
+    }
+  }
+  if (timedOut < commands.size()) {
+    PyErr_SetString(PyExc_TimeoutError, ("No answer from " + ToQuotedString(port.GetLabel()) +
+                                         " to command " + std::to_string(timedOut) + " within " +
+                                         std::to_string(std::lround(timeout * 1000)) + " ms")
+                                            .c_str());
+    throw py::error_already_set();
+  }
+  return answers;
+}
+
+// Detaches the recorder from its ports and closes its file.
+void closeSerialRecorder(std::shared_ptr<SerialRecorder> recorder) {
+  for (const std::string &port : recorder->GetPortNames())
+    if (serialRecorders().Find(port) == recorder) serialRecorders().Detach(port);
+  recorder->Close();
+}
+
+void attachSerialReplay(std::shared_ptr<SerialReplay> replay,
+                        const std::vector<std::string> &ports) {
+  for (const std::string &port : ports)
+    if (!replay->HasPort(port))
+      throw py::value_error("Port " + ToQuotedString(port) + " is not in the recording");
+  for (const std::string &port : ports) serialReplays().Attach(port, replay);
+}
+
+void detachSerialReplay(std::shared_ptr<SerialReplay> replay) {
+  for (const std::string &port : replay->GetPortNames())
+    if (serialReplays().Find(port) == replay) serialReplays().Detach(port);
+}
+
+// Raises a failed SerialReplay call: TimeoutError (with `timeout` as the message) if nothing
+// arrived, RuntimeError if the port isn't in the recording or strict mode refused a write or
+// purge that departs from it.  Call with the GIL.
+void checkReplayCall(const SerialReplay &replay, int ret, const std::string &port,
+                     const std::string &timeout = std::string()) {
+  if (ret == DEVICE_OK) return;
+  if (ret == DEVICE_SERIAL_TIMEOUT) {
+    PyErr_SetString(PyExc_TimeoutError, timeout.c_str());
+    throw py::error_already_set();
+  }
+  const std::vector<std::string> ports = replay.GetPortNames();
+  if (std::find(ports.begin(), ports.end(), port) == ports.end())
+    throw std::runtime_error("Unknown replayed port " + port);
+  throw std::runtime_error("Refused by strict replay: " + replay.GetLastMismatch());
+}
+
+// The galvo's usable area, as (xMin, xMax, yMin, yMax).
+std::tuple<double, double, double, double> galvoLimits(GalvoInstance &galvo) {
+  util::DeviceCallGuard guard(galvo);
+  const double xMin = galvo.GetXMinimum(), yMin = galvo.GetYMinimum();
+  return std::make_tuple(xMin, xMin + galvo.GetXRange(), yMin, yMin + galvo.GetYRange());
+}
+
+// The (N, 2) x, y pairs in `points`, all of which must lie within the galvo's range.
+const double *checkGalvoPoints(GalvoInstance &galvo, const DoubleArray &points,
+                               const char *name) {
+  if (points.ndim() != 2 || points.shape(1) != 2)
+    throw py::value_error(std::string(name) + " must be an (N, 2) array of x, y pairs");
+  double xMin, xMax, yMin, yMax;
+  std::tie(xMin, xMax, yMin, yMax) = galvoLimits(galvo);
+  const double *data = points.data();
+  for (py::ssize_t i = 0; i < points.shape(0); ++i) {
+    const double x = data[2 * i], y = data[2 * i + 1];
+    if (!(x >= xMin && x <= xMax && y >= yMin && y <= yMax))
+      throw py::value_error(std::string(name) + "[" + std::to_string(i) + "] = (" +
+                            std::to_string(x) + ", " + std::to_string(y) +
+                            ") is outside the galvo range x: [" + std::to_string(xMin) + ", " +
+                            std::to_string(xMax) + "], y: [" + std::to_string(yMin) + ", " +
+                            std::to_string(yMax) + "]");
+  }
+  return data;
+}
+
+// Replaces the galvo's polygons with those in `vertices`, polygon i being the vertices from
+// offsets[i] up to offsets[i + 1] (or the end), and loads them onto the device.
+void loadGalvoPolygons(GalvoInstance &galvo, const DoubleArray &vertices,
+                       const std::vector<size_t> &offsets) {
+  const double *data = checkGalvoPoints(galvo, vertices, "vertices");
+  const size_t n = static_cast<size_t>(vertices.shape(0));
+  if (n == 0) throw py::value_error("vertices is empty; there are no polygons to load");
+  std::vector<size_t> bounds = offsets;
+  if (bounds.empty() || bounds.back() != n) bounds.push_back(n);
+  if (bounds.size() < 2 || bounds[0] != 0)
+    throw py::value_error("polygon_offsets must start at 0");
+  for (size_t p = 1; p < bounds.size(); ++p)
+    if (bounds[p] <= bounds[p - 1] || bounds[p] > n)
+      throw py::value_error("polygon_offsets must be increasing indices into vertices");
+
+  util::DeviceCallGuard guard(galvo);
+  checkDeviceError(galvo, galvo.DeletePolygons());
+  for (size_t p = 0; p + 1 < bounds.size(); ++p)
+    for (size_t i = bounds[p]; i < bounds[p + 1]; ++i)
+      checkDeviceError(galvo, galvo.AddPolygonVertex(static_cast<int>(p), data[2 * i],
+                                                     data[2 * i + 1]));
+  checkDeviceError(galvo, galvo.LoadPolygons());
+}
+
+// Points and fires at each of `points` in turn, for dwell_us[i] microseconds each, without the
+// GIL and taking the module lock per spot.  Returns when each spot was fired, in ms since the
+// call started.
+py::array_t<double> pointAndFireSequence(GalvoInstance &galvo, const DoubleArray &points,
+                                         const DoubleArray &dwell_us) {
+  const double *xy = checkGalvoPoints(galvo, points, "points");
+  const py::ssize_t n = points.shape(0);
+  if (dwell_us.ndim() != 1 || dwell_us.shape(0) != n)
+    throw py::value_error("dwell_us must be a 1-D array with one time per point");
+  const double *dwell = dwell_us.data();
+
+  py::array_t<double> timestamps(n);
+  double *stamps = timestamps.mutable_data();
+  py::gil_scoped_release release;
+  const auto start = std::chrono::steady_clock::now();
+  for (py::ssize_t i = 0; i < n; ++i) {
+    MMThreadGuard lock(galvo.GetAdapterModule()->GetLock());
+    stamps[i] =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+            .count();
+    checkDeviceError(galvo, galvo.PointAndFire(xy[2 * i], xy[2 * i + 1], dwell[i]));
+  }
+  return timestamps;
+}
+
+// A hardware-timed acquisition: at every event the camera takes one frame while each channel's
+// device steps to its next value, driven by the camera's trigger output.  The plan runs in
+// chunks no longer than the shortest device sequence.  For each chunk the sequences are
+// uploaded (one task per adapter module, without the GIL), started, and then the camera's
+// sequence acquisition is started last so that nothing misses its first trigger.
+class HardwareSequence {
+ public:
+  HardwareSequence(std::shared_ptr<mm::DeviceManager> manager, const std::string &cameraLabel)
+      : manager_(std::move(manager)),
+        camera_(manager_->GetCameraDevice(manager_->GetDevice(cameraLabel.c_str()))) {}
+
+  void AddStage(const std::string &label, std::vector<double> positions) {
+    Channel channel{Channel::Stage, Get<StageInstance>(label, "a stage")};
+    {
+      util::DeviceCallGuard guard(*channel.device);
+      auto &stage = static_cast<StageInstance &>(*channel.device);
+      bool sequenceable = false;
+      checkDeviceError(stage, stage.IsStageSequenceable(sequenceable));
+      if (sequenceable) checkDeviceError(stage, stage.GetStageSequenceMaxLength(channel.maxLength));
+    }
+    channel.values = std::move(positions);
+    Add(std::move(channel), label);
+  }
+
+  void AddXYStage(const std::string &label, std::vector<double> xs, std::vector<double> ys) {
+    if (xs.size() != ys.size())
+      throw py::value_error("Got " + std::to_string(xs.size()) + " x but " +
+                            std::to_string(ys.size()) + " y positions");
+    Channel channel{Channel::XYStage, Get<XYStageInstance>(label, "an XY stage")};
+    {
+      util::DeviceCallGuard guard(*channel.device);
+      auto &stage = static_cast<XYStageInstance &>(*channel.device);
+      bool sequenceable = false;
+      checkDeviceError(stage, stage.IsXYStageSequenceable(sequenceable));
+      if (sequenceable)
+        checkDeviceError(stage, stage.GetXYStageSequenceMaxLength(channel.maxLength));
+    }
+    channel.values = std::move(xs);
+    channel.yValues = std::move(ys);
+    Add(std::move(channel), label);
+  }
+
+  void AddDA(const std::string &label, std::vector<double> voltages) {
+    Channel channel{Channel::DA, Get<SignalIOInstance>(label, "a signal IO device")};
+    {
+      util::DeviceCallGuard guard(*channel.device);
+      auto &da = static_cast<SignalIOInstance &>(*channel.device);
+      bool sequenceable = false;
+      checkDeviceError(da, da.IsDASequenceable(sequenceable));
+      if (sequenceable) checkDeviceError(da, da.GetDASequenceMaxLength(channel.maxLength));
+    }
+    channel.values = std::move(voltages);
+    Add(std::move(channel), label);
+  }
+
+  void AddExposure(std::vector<double> exposures) {
+    Channel channel{Channel::Exposure, camera_};
+    {
+      util::DeviceCallGuard guard(*camera_);
+      bool sequenceable = false;
+      checkDeviceError(*camera_, camera_->IsExposureSequenceable(sequenceable));
+      if (sequenceable)
+        checkDeviceError(*camera_, camera_->GetExposureSequenceMaxLength(channel.maxLength));
+    }
+    channel.values = std::move(exposures);
+    Add(std::move(channel), camera_->GetLabel());
+  }
+
+  void AddProperty(const std::string &label, const std::string &name,
+                   std::vector<std::string> values) {
+    Channel channel{Channel::Property, manager_->GetDevice(label.c_str())};
+    channel.property = name;
+    {
+      util::DeviceCallGuard guard(*channel.device);
+      if (channel.device->IsPropertySequenceable(name))
+        channel.maxLength = channel.device->GetPropertySequenceMaxLength(name);
+    }
+    channel.strings = std::move(values);
+    Add(std::move(channel), label + "." + name);
+  }
+
+  /** Number of events (frames) in the plan. */
+  size_t GetLength() const { return channels_.empty() ? 0 : channels_[0].Size(); }
+
+  /** The [begin, end) event ranges the plan is run in. */
+  std::vector<std::pair<size_t, size_t>> GetChunks() const {
+    size_t chunk = std::numeric_limits<size_t>::max();
+    for (const Channel &channel : channels_)
+      chunk = std::min(chunk, static_cast<size_t>(channel.maxLength));
+    std::vector<std::pair<size_t, size_t>> chunks;
+    for (size_t begin = 0; begin < GetLength(); begin += chunk)
+      chunks.emplace_back(begin, std::min(begin + chunk, GetLength()));
+    return chunks;
+  }
+
+  /**
+   * Runs the whole plan; call without the GIL.  Frames go to the camera's sequence buffer,
+   * which another thread may drain meanwhile.  Returns the number of chunks completed, fewer
+   * than GetChunks().size() if Abort() was called.
+   */
+  size_t Run(double intervalMs, bool stopOnOverflow, size_t maxWorkers) {
+    if (channels_.empty()) throw std::runtime_error("The sequence has no channels");
+    aborted_ = false;
+    std::vector<std::shared_ptr<DeviceInstance>> devices;
+    for (const Channel &channel : channels_) devices.push_back(channel.device);
+    drainFramePipeline(*camera_);
+    {
+      MMThreadGuard lock(camera_->GetAdapterModule()->GetLock());
+      prepareSequenceBuffer(*camera_);
+    }
+
+    size_t completed = 0;
+    try {
+      for (const std::pair<size_t, size_t> &chunk : GetChunks()) {
+        if (aborted_) break;
+        forEachDeviceByModule(devices, maxWorkers, [&](size_t i, DeviceInstance &) {
+          Upload(channels_[i], chunk.first, chunk.second);
+        });
+        for (Channel &channel : channels_) {
+          MMThreadGuard lock(channel.device->GetAdapterModule()->GetLock());
+          Start(channel);
+        }
+        {
+          MMThreadGuard lock(camera_->GetAdapterModule()->GetLock());
+          checkDeviceError(*camera_, camera_->StartSequenceAcquisition(
+                                         static_cast<long>(chunk.second - chunk.first),
+                                         intervalMs, stopOnOverflow));
+        }
+        WaitForCamera();
+        StopChannels();
+        if (aborted_) break;  // the chunk may have been cut short
+        ++completed;
+      }
+    } catch (...) {
+      // leave no device running a sequence, then report the original error; the channels
+      // are stopped after the camera's lock is released, as on the normal path
+      try {
+        MMThreadGuard lock(camera_->GetAdapterModule()->GetLock());
+        camera_->StopSequenceAcquisition();
+      } catch (...) {
+      }
+      try {
+        StopChannels();
+      } catch (...) {
+      }
+      throw;
+    }
+    return completed;
+  }
+
+  /** Stops a Run() in progress (from another thread) after the camera's current frame. */
+  void Abort() { aborted_ = true; }
+
+ private:
+  struct Channel {
+    enum Kind { Stage, XYStage, DA, Exposure, Property };
+
+    Kind kind;
+    std::shared_ptr<DeviceInstance> device;
+    long maxLength = 0;  // 0 if the device can't sequence this
+    std::string property;
+    std::vector<double> values, yValues;
+    std::vector<std::string> strings;
+
+    size_t Size() const { return kind == Property ? strings.size() : values.size(); }
+  };
+
+  template <typename DType>
+  std::shared_ptr<DType> Get(const std::string &label, const std::string &what) const {
+    std::shared_ptr<DType> device =
+        std::dynamic_pointer_cast<DType>(manager_->GetDevice(label.c_str()));
+    if (!device) throw py::type_error(ToQuotedString(label) + " is not " + what);
+    return device;
+  }
+
+  void Add(Channel channel, const std::string &name) {
+    if (channel.maxLength <= 0)
+      throw std::runtime_error(ToQuotedString(name) + " is not hardware-sequenceable");
+    if (channel.Size() == 0) throw py::value_error("No values given for " + ToQuotedString(name));
+    if (!channels_.empty() && channel.Size() != GetLength())
+      throw py::value_error("Got " + std::to_string(channel.Size()) + " values for " +
+                            ToQuotedString(name) + " but the sequence has " +
+                            std::to_string(GetLength()) + " events");
+    channels_.push_back(std::move(channel));
+  }
+
+  // Call with the channel's module lock held.
+  static void Upload(Channel &channel, size_t begin, size_t end) {
+    DeviceInstance &device = *channel.device;
+    // the device's sequence is replaced, so is its count of queued points
+    if (channel.kind != Channel::Property) queuedSequencePoints().Detach(device.GetRawPtr());
+    switch (channel.kind) {
+      case Channel::Stage: {
+        auto &stage = static_cast<StageInstance &>(device);
+        checkDeviceError(stage, stage.ClearStageSequence());
+        for (size_t i = begin; i < end; ++i)
+          checkDeviceError(stage, stage.AddToStageSequence(channel.values[i]));
+        checkDeviceError(stage, stage.SendStageSequence());
+        break;
+      }
+      case Channel::XYStage: {
+        auto &stage = static_cast<XYStageInstance &>(device);
+        checkDeviceError(stage, stage.ClearXYStageSequence());
+        for (size_t i = begin; i < end; ++i)
+          checkDeviceError(stage,
+                           stage.AddToXYStageSequence(channel.values[i], channel.yValues[i]));
+        checkDeviceError(stage, stage.SendXYStageSequence());
+        break;
+      }
+      case Channel::DA: {
+        auto &da = static_cast<SignalIOInstance &>(device);
+        checkDeviceError(da, da.ClearDASequence());
+        for (size_t i = begin; i < end; ++i)
+          checkDeviceError(da, da.AddToDASequence(channel.values[i]));
+        checkDeviceError(da, da.SendDASequence());
+        break;
+      }
+      case Channel::Exposure: {
+        auto &camera = static_cast<CameraInstance &>(device);
+        checkDeviceError(camera, camera.ClearExposureSequence());
+        for (size_t i = begin; i < end; ++i)
+          checkDeviceError(camera, camera.AddToExposureSequence(channel.values[i]));
+        checkDeviceError(camera, camera.SendExposureSequence());
+        break;
+      }
+      case Channel::Property:
+        device.ClearPropertySequence(channel.property);
+        for (size_t i = begin; i < end; ++i)
+          device.AddToPropertySequence(channel.property, channel.strings[i]);
+        device.SendPropertySequence(channel.property);
+        return;
+    }
+    queuedSequencePoints().Attach(device.GetRawPtr(), std::make_shared<size_t>(end - begin));
+  }
+
+  // Call with the channel's module lock held.
+  static void Start(Channel &channel) {
+    DeviceInstance &device = *channel.device;
+    switch (channel.kind) {
+      case Channel::Stage:
+        checkDeviceError(device, static_cast<StageInstance &>(device).StartStageSequence());
+        break;
+      case Channel::XYStage:
+        checkDeviceError(device, static_cast<XYStageInstance &>(device).StartXYStageSequence());
+        break;
+      case Channel::DA:
+        checkDeviceError(device, static_cast<SignalIOInstance &>(device).StartDASequence());
+        break;
+      case Channel::Exposure:
+        checkDeviceError(device, static_cast<CameraInstance &>(device).StartExposureSequence());
+        break;
+      case Channel::Property:
+        device.StartPropertySequence(channel.property);
+        break;
+    }
+  }
+
+  // Call with the channel's module lock held.
+  static void Stop(Channel &channel) {
+    DeviceInstance &device = *channel.device;
+    switch (channel.kind) {
+      case Channel::Stage:
+        checkDeviceError(device, static_cast<StageInstance &>(device).StopStageSequence());
+        break;
+      case Channel::XYStage:
+        checkDeviceError(device, static_cast<XYStageInstance &>(device).StopXYStageSequence());
+        break;
+      case Channel::DA:
+        checkDeviceError(device, static_cast<SignalIOInstance &>(device).StopDASequence());
+        break;
+      case Channel::Exposure:
+        checkDeviceError(device, static_cast<CameraInstance &>(device).StopExposureSequence());
+        break;
+      case Channel::Property:
+        device.StopPropertySequence(channel.property);
+        break;
+    }
+  }
+
+  // In reverse order of starting them.
+  void StopChannels() {
+    for (auto it = channels_.rbegin(); it != channels_.rend(); ++it) {
+      MMThreadGuard lock(it->device->GetAdapterModule()->GetLock());
+      Stop(*it);
+    }
+  }
+
+  // Polls until the camera has delivered the chunk (or is stopped by Abort()).  The camera's
+  // module lock is only held for each check, so its frames keep flowing to the buffer.
+  void WaitForCamera() {
+    for (;;) {
+      {
+        MMThreadGuard lock(camera_->GetAdapterModule()->GetLock());
+        if (!camera_->IsCapturing()) return;
+        if (aborted_) camera_->StopSequenceAcquisition();
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+
+  const std::shared_ptr<mm::DeviceManager> manager_;
+  const std::shared_ptr<CameraInstance> camera_;
+  std::vector<Channel> channels_;
+  std::atomic<bool> aborted_{false};
+};
+
+// A tiled acquisition: the XY stage visits each position in turn, and once it has settled the
+// camera snaps one frame there.  Frames are read out of the camera and copied to their place
+// in the destination on a second thread, so that the copy of one tile overlaps the move to the
+// next; the camera is only snapped again once its previous frame is out of its buffer.
+class TileScan {
+ public:
+  TileScan(std::shared_ptr<mm::DeviceManager> manager, const std::string &cameraLabel,
+           const std::string &stageLabel)
+      : manager_(std::move(manager)),
+        camera_(manager_->GetCameraDevice(manager_->GetDevice(cameraLabel.c_str()))),
+        stage_(std::dynamic_pointer_cast<XYStageInstance>(
+            manager_->GetDevice(stageLabel.c_str()))) {
+    if (!stage_) throw py::type_error(ToQuotedString(stageLabel) + " is not an XY stage");
+  }
+
+  /**
+   * Scans `positions`, an (N, 2) array of x, y in um, into `out`: either an (N, height,
+   * width) stack, or a 2-D mosaic with each tile's top-left (row, column) given in `offsets`.
+   * Returns the time each tile settled, was snapped and was copied, in ms since the start
+   * (NaN for tiles not reached because of Abort()).
+   */
+  py::dict Run(const DoubleArray &positions, py::array out, py::object offsets,
+               py::object settleTimeout) {
+    if (positions.ndim() != 2 || positions.shape(1) != 2)
+      throw py::value_error("positions must be an (N, 2) array of x, y");
+    const size_t n = static_cast<size_t>(positions.shape(0));
+
+    Destination dest;
+    {
+      util::DeviceCallGuard guard(*camera_);
+      dest.width = camera_->GetImageWidth();
+      dest.height = camera_->GetImageHeight();
+      dest.bytesPerPixel = camera_->GetImageBytesPerPixel();
+    }
+    if (out.itemsize() != static_cast<py::ssize_t>(dest.bytesPerPixel))
+      throw py::value_error("out has " + std::to_string(out.itemsize()) +
+                            " bytes per item but the camera has " +
+                            std::to_string(dest.bytesPerPixel) + " bytes per pixel");
+    if (!(out.flags() & py::array::c_style)) throw py::value_error("out must be C-contiguous");
+    if (!out.writeable()) throw py::value_error("out must be writeable");
+    dest.data = static_cast<unsigned char *>(out.mutable_data());
+
+    py::array_t<int64_t, py::array::c_style | py::array::forcecast> tileOffsets;
+    if (out.ndim() == 3) {
+      if (!offsets.is_none()) throw py::value_error("offsets only apply to a 2-D mosaic");
+      if (out.shape(0) < static_cast<py::ssize_t>(n) ||
+          out.shape(1) != static_cast<py::ssize_t>(dest.height) ||
+          out.shape(2) != static_cast<py::ssize_t>(dest.width))
+        throw py::value_error("out must be an (N, " + std::to_string(dest.height) + ", " +
+                              std::to_string(dest.width) + ") stack with N >= " +
+                              std::to_string(n));
+      dest.rowBytes = static_cast<size_t>(dest.width) * dest.bytesPerPixel;
+    } else if (out.ndim() == 2) {
+      if (offsets.is_none()) throw py::value_error("A 2-D mosaic needs tile offsets");
+      tileOffsets = offsets.cast<decltype(tileOffsets)>();
+      if (tileOffsets.ndim() != 2 || tileOffsets.shape(0) != static_cast<py::ssize_t>(n) ||
+          tileOffsets.shape(1) != 2)
+        throw py::value_error("offsets must be an (N, 2) array of row, column");
+      dest.offsets = tileOffsets.data();
+      for (size_t i = 0; i < n; ++i) {
+        int64_t row = dest.offsets[2 * i], col = dest.offsets[2 * i + 1];
+        if (row < 0 || col < 0 || row + dest.height > out.shape(0) ||
+            col + dest.width > out.shape(1))
+          throw py::value_error("Tile " + std::to_string(i) + " at (" + std::to_string(row) +
+                                ", " + std::to_string(col) + ") does not fit in the mosaic");
+      }
+      dest.rowBytes = static_cast<size_t>(out.shape(1)) * dest.bytesPerPixel;
+    } else {
+      throw py::value_error("out must be a 3-D stack or a 2-D mosaic");
+    }
+
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    py::array_t<double> settled(n), snapped(n), copied(n);
+    Timings timings{settled.mutable_data(), snapped.mutable_data(), copied.mutable_data()};
+    std::fill_n(timings.settled, n, nan);
+    std::fill_n(timings.snapped, n, nan);
+    std::fill_n(timings.copied, n, nan);
+
+    const double timeoutS = settleTimeout.is_none() ? -1 : settleTimeout.cast<double>();
+    bool settledAll;
+    {
+      py::gil_scoped_release release;
+      settledAll = Execute(positions.data(), n, dest, timings, timeoutS);
+    }
+    if (!settledAll) {
+      PyErr_SetString(PyExc_TimeoutError,
+                      ("Stage " + ToQuotedString(stage_->GetLabel()) + " did not settle within " +
+                       std::to_string(std::lround(timeoutS * 1000)) + " ms")
+                          .c_str());
+      throw py::error_already_set();
+    }
+
+    py::dict result;
+    result["settled_ms"] = settled;
+    result["snapped_ms"] = snapped;
+    result["copied_ms"] = copied;
+    return result;
+  }
+
+  /** Stops a Run() in progress (from another thread) once the current tile is taken. */
+  void Abort() { aborted_ = true; }
+
+ private:
+  // Where tiles go: consecutive frames of a stack, or (with offsets) places in a mosaic.
+  struct Destination {
+    unsigned char *data = nullptr;
+    size_t rowBytes = 0;  // of `data`
+    unsigned width = 0, height = 0, bytesPerPixel = 0;
+    const int64_t *offsets = nullptr;  // (row, column) per tile, for a mosaic
+
+    void Copy(size_t tile, const unsigned char *frame) const {
+      const size_t frameRowBytes = static_cast<size_t>(width) * bytesPerPixel;
+      unsigned char *dst =
+          offsets ? data + offsets[2 * tile] * rowBytes + offsets[2 * tile + 1] * bytesPerPixel
+                  : data + tile * frameRowBytes * height;
+      for (unsigned y = 0; y < height; ++y)
+        std::memcpy(dst + y * rowBytes, frame + y * frameRowBytes, frameRowBytes);
+    }
+  };
+
+  struct Timings {
+    double *settled, *snapped, *copied;
+  };
+
+  // The scan itself, without the GIL.  Each tile's settle may take up to `settleTimeoutS`
+  // seconds (no limit if negative); returns false if one took longer.
+  bool Execute(const double *xy, size_t n, const Destination &dest, Timings timings,
+               double settleTimeoutS) {
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point start = Clock::now();
+    auto sinceStart = [&] {
+      return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    };
+    std::shared_ptr<PyCoreCallback> callback = managerCallbacks().Find(manager_.get());
+    const std::vector<std::shared_ptr<DeviceInstance>> stage{stage_};
+    const size_t frameBytes = static_cast<size_t>(dest.width) * dest.height * dest.bytesPerPixel;
+    aborted_ = false;
+
+    // hand-over between the two threads: the last tile snapped, and the last one copied
+    std::mutex mutex;
+    std::condition_variable changed;
+    long snapped = -1, taken = -1;
+    bool finished = false;
+    std::exception_ptr readError;
+
+    std::thread reader([&] {
+      for (;;) {
+        long tile;
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          changed.wait(lock, [&] { return snapped > taken || finished; });
+          if (snapped == taken) return;
+          tile = snapped;
+        }
+        try {
+          MMThreadGuard lock(camera_->GetAdapterModule()->GetLock());
+          const unsigned char *buffer = camera_->GetImageBuffer();
+          if (buffer == nullptr || static_cast<size_t>(camera_->GetImageBufferSize()) != frameBytes)
+            throw std::runtime_error("Camera image size changed during the tile scan");
+          dest.Copy(tile, buffer);
+          timings.copied[tile] = sinceStart();
+        } catch (...) {
+          std::lock_guard<std::mutex> lock(mutex);
+          readError = std::current_exception();
+        }
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          taken = tile;
+        }
+        changed.notify_all();
+      }
+    });
+
+    bool timedOut = false;
+    std::exception_ptr scanError;
+    try {
+      for (size_t i = 0; i < n && !aborted_; ++i) {
+        {
+          MMThreadGuard lock(stage_->GetAdapterModule()->GetLock());
+          checkDeviceError(*stage_, stage_->SetPositionUm(xy[2 * i], xy[2 * i + 1]));
+        }
+        const Clock::time_point deadline =
+            settleTimeoutS < 0 ? Clock::time_point::max()
+                               : Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                                    std::chrono::duration<double>(settleTimeoutS));
+        if (settleDevices(stage, callback.get(), deadline)[0] < 0) {
+          timedOut = true;
+          break;
+        }
+        timings.settled[i] = sinceStart();
+        {
+          // the previous frame must be out of the camera's buffer before the next snap
+          std::unique_lock<std::mutex> lock(mutex);
+          changed.wait(lock, [&] { return taken == snapped; });
+          if (readError) break;
+        }
+        {
+          MMThreadGuard lock(camera_->GetAdapterModule()->GetLock());
+          checkDeviceError(*camera_, camera_->SnapImage());
+        }
+        timings.snapped[i] = sinceStart();
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          snapped = static_cast<long>(i);
+        }
+        changed.notify_all();
+      }
+    } catch (...) {
+      scanError = std::current_exception();
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      finished = true;
+    }
+    changed.notify_all();
+    reader.join();
+    if (scanError) std::rethrow_exception(scanError);
+    if (readError) std::rethrow_exception(readError);
+    return !timedOut;
+  }
+
+  const std::shared_ptr<mm::DeviceManager> manager_;
+  const std::shared_ptr<CameraInstance> camera_;
+  const std::shared_ptr<XYStageInstance> stage_;
+  std::atomic<bool> aborted_{false};
+};
+
+// Scores an image of 1 or 2 bytes per pixel in place.
+double scoreImage(const void *pixels, unsigned width, unsigned height, unsigned bytesPerPixel,
+                  pixels::FocusMetric metric) {
+  switch (bytesPerPixel) {
+    case 1:
+      return pixels::focusScore(static_cast<const uint8_t *>(pixels), width, height, metric);
+    case 2:
+      return pixels::focusScore(static_cast<const uint16_t *>(pixels), width, height, metric);
+    default:
+      throw py::value_error("Focus scores need grayscale images of 1 or 2 bytes per pixel, not " +
+                            std::to_string(bytesPerPixel));
+  }
+}
+
+// Software autofocus, for rigs without an autofocus device: steps a focus stage through a range
+// around its current position, snaps a frame at each step and scores it right in the camera's
+// buffer, then searches ever more finely around the best position so far.
+class SoftwareAutofocus {
+ public:
+  SoftwareAutofocus(std::shared_ptr<mm::DeviceManager> manager, const std::string &cameraLabel,
+                    const std::string &stageLabel)
+      : manager_(std::move(manager)),
+        camera_(manager_->GetCameraDevice(manager_->GetDevice(cameraLabel.c_str()))),
+        stage_(
+            std::dynamic_pointer_cast<StageInstance>(manager_->GetDevice(stageLabel.c_str()))) {
+    if (!stage_) throw py::type_error(ToQuotedString(stageLabel) + " is not a stage");
+  }
+
+  /** Snaps a frame where the stage is and returns its score. */
+  double SnapAndScore(pixels::FocusMetric metric) {
+    CheckCamera();
+    py::gil_scoped_release release;
+    double scoreMs = 0;
+    return Snap(metric, scoreMs);
+  }
+
+  /**
+   * Scans `rangeUm` around `centerUm` (the current position if None) in steps of `stepUm`,
+   * then repeatedly rescans either side of the best position in quarter steps, down to
+   * `minStepUm`; the stage is left at the best position.
+   */
+  py::dict Run(double rangeUm, double stepUm, double minStepUm, pixels::FocusMetric metric,
+               py::object centerUm, py::object settleTimeout) {
+    if (!(rangeUm >= 0 && stepUm > 0 && minStepUm > 0))
+      throw py::value_error("range_um must be >= 0 and step_um, min_step_um > 0");
+    CheckCamera();
+    const double timeoutS = settleTimeout.is_none() ? -1 : settleTimeout.cast<double>();
+    double center = centerUm.is_none() ? 0 : centerUm.cast<double>();
+
+    Search search;
+    bool settledAll;
+    {
+      py::gil_scoped_release release;
+      if (centerUm.is_none()) {
+        MMThreadGuard lock(stage_->GetAdapterModule()->GetLock());
+        checkDeviceError(*stage_, stage_->GetPositionUm(center));
+      }
+      settledAll = Execute(center, rangeUm, stepUm, minStepUm, metric, timeoutS, search);
+    }
+    if (!settledAll) {
+      PyErr_SetString(PyExc_TimeoutError,
+                      ("Stage " + ToQuotedString(stage_->GetLabel()) + " did not settle within " +
+                       std::to_string(std::lround(timeoutS * 1000)) + " ms")
+                          .c_str());
+      throw py::error_already_set();
+    }
+
+    const size_t best = search.Best();
+    py::dict result;
+    result["position_um"] = search.positions[best];
+    result["score"] = search.scores[best];
+    result["positions"] = py::array_t<double>(search.positions.size(), search.positions.data());
+    result["scores"] = py::array_t<double>(search.scores.size(), search.scores.data());
+    result["score_ms"] = search.scoreMs;
+    return result;
+  }
+
+ private:
+  // The positions scored so far, in the order visited.
+  struct Search {
+    std::vector<double> positions;
+    std::vector<double> scores;
+    double scoreMs = 0;  // spent computing scores
+
+    size_t Best() const {
+      return std::max_element(scores.begin(), scores.end()) - scores.begin();
+    }
+    bool Visited(double z) const {
+      for (double p : positions)
+        if (std::abs(p - z) < 1e-9) return true;
+      return false;
+    }
+  };
+
+  void CheckCamera() {
+    unsigned bytesPerPixel;
+    {
+      util::DeviceCallGuard guard(*camera_);
+      bytesPerPixel = camera_->GetImageBytesPerPixel();
+    }
+    if (bytesPerPixel != 1 && bytesPerPixel != 2)
+      throw py::value_error("Software autofocus needs a grayscale camera of 1 or 2 bytes per "
+                            "pixel, not " + std::to_string(bytesPerPixel));
+  }
+
+  // Without the GIL: snaps a frame and scores it before the camera's lock is released.
+  double Snap(pixels::FocusMetric metric, double &scoreMs) {
+    MMThreadGuard lock(camera_->GetAdapterModule()->GetLock());
+    checkDeviceError(*camera_, camera_->SnapImage());
+    const unsigned char *buffer = camera_->GetImageBuffer();
+    if (buffer == nullptr) throw std::runtime_error("Camera returned no image");
+    const auto start = std::chrono::steady_clock::now();
+    double score = scoreImage(buffer, camera_->GetImageWidth(), camera_->GetImageHeight(),
+                              camera_->GetImageBytesPerPixel(), metric);
+    scoreMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+                   .count();
+    return score;
+  }
+
+  // Without the GIL: moves the stage to `z` and waits for it; false if it didn't settle in time.
+  bool MoveTo(double z, PyCoreCallback *callback, double timeoutS) {
+    using Clock = std::chrono::steady_clock;
+    {
+      MMThreadGuard lock(stage_->GetAdapterModule()->GetLock());
+      checkDeviceError(*stage_, stage_->SetPositionUm(z));
+    }
+    const Clock::time_point deadline =
+        timeoutS < 0 ? Clock::time_point::max()
+                     : Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                          std::chrono::duration<double>(timeoutS));
+    return settleDevices({stage_}, callback, deadline)[0] >= 0;
+  }
+
+  bool Execute(double center, double rangeUm, double stepUm, double minStepUm,
+               pixels::FocusMetric metric, double timeoutS, Search &search) {
+    std::shared_ptr<PyCoreCallback> callback = managerCallbacks().Find(manager_.get());
+    const double lo = center - rangeUm / 2, hi = center + rangeUm / 2;
+    auto visit = [&](double z) {
+      if (z < lo - 1e-9 || z > hi + 1e-9 || search.Visited(z)) return true;
+      if (!MoveTo(z, callback.get(), timeoutS)) return false;
+      search.scores.push_back(Snap(metric, search.scoreMs));
+      search.positions.push_back(z);
+      return true;
+    };
+
+    // coarse: the whole range; the last step may be short
+    const auto coarseSteps = static_cast<long>(std::floor(rangeUm / stepUm + 1e-9));
+    for (long i = 0; i <= coarseSteps; ++i)
+      if (!visit(lo + i * stepUm)) return false;
+    if (!visit(hi)) return false;
+
+    // fine: the interval either side of the best position, in quarter steps
+    for (double step = stepUm; step > minStepUm;) {
+      const double fine = std::max(step / 4, minStepUm);
+      const double best = search.positions[search.Best()];
+      const auto fineSteps = static_cast<long>(std::ceil(step / fine - 1e-9));
+      for (long i = -fineSteps + 1; i < fineSteps; ++i)
+        if (!visit(best + i * fine)) return false;
+      step = fine;
+    }
+
+    const double best = search.positions[search.Best()];
+    if (search.positions.back() == best) return true;
+    return MoveTo(best, callback.get(), timeoutS);
+  }
+
+  const std::shared_ptr<mm::DeviceManager> manager_;
+  const std::shared_ptr<CameraInstance> camera_;
+  const std::shared_ptr<StageInstance> stage_;
 };
 
 auto loadDevice_ = [](LoadedDeviceAdapter &self, const std::string &name,
                       const std::string &label) -> std::shared_ptr<DeviceInstance> {
-  MockCMMCore mockCore;
-  mm::logging::internal::GenericLogger<mm::logging::EntryData> deviceLogger(0);
-  mm::logging::internal::GenericLogger<mm::logging::EntryData> coreLogger(0);
   // NOTE:
   // in DeviceManager.LoadDevice, the description is taken from the module
   // and assigned to the device.  It's not immediately obvious why that shouldn't
   // also be done here...
   std::shared_ptr<DeviceInstance> dev =
-      self.LoadDevice(&mockCore, name, label, deviceLogger, coreLogger);
-  // PyCoreCallback *cb = new PyCoreCallback(&mockCore);
-  // dev->SetCallback(cb);
+      self.LoadDevice(sharedMockCore(), name, label, deviceLogger(label), deviceLogger(label));
+  forgetDevice(dev->GetRawPtr());
+  dev->SetCallback(defaultCoreCallback());
   return dev;
 };
 
+// Decodes text from an adapter, which isn't always valid UTF-8.
+py::str decodeAdapterText(const std::string &text) {
+  PyObject *str =
+      PyUnicode_DecodeUTF8(text.data(), static_cast<Py_ssize_t>(text.size()), "replace");
+  if (!str) throw py::error_already_set();
+  return py::reinterpret_steal<py::str>(str);
+}
+
+// SetLogHandler: the handler is called on the log sink's writer thread, with the GIL.
+void setLogHandler(py::object handler) {
+  if (handler.is_none()) {
+    logSink().SetHandler(nullptr);
+    return;
+  }
+  // the writer thread may drop the last reference, so that takes the GIL too
+  std::shared_ptr<py::object> fn(new py::object(std::move(handler)), [](py::object *fn) {
+    py::gil_scoped_acquire gil;
+    delete fn;
+  });
+  logSink().SetHandler([fn](const std::vector<LogRecord> &records) {
+    py::gil_scoped_acquire gil;
+    try {
+      py::list batch(records.size());
+      for (size_t i = 0; i < records.size(); ++i) {
+        const LogRecord &record = records[i];
+        double time = std::chrono::duration<double>(record.time.time_since_epoch()).count();
+        batch[i] = py::make_tuple(time, static_cast<mm::logging::LogLevel>(record.level),
+                                  decodeAdapterText(record.label), record.thread,
+                                  decodeAdapterText(record.message));
+      }
+      (*fn)(batch);
+    } catch (py::error_already_set &e) {
+      e.discard_as_unraisable("log handler");
+    }
+  });
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
@@ -163,6 +2626,8 @@ PYBIND11_MODULE(_pymmdevice, m) {
   // define module level attribute for DEVICE_INTERFACE_VERSION
   m.attr("DEVICE_INTERFACE_VERSION") = DEVICE_INTERFACE_VERSION;
 
+  py::register_exception<SequenceError>(m, "SequenceError", PyExc_RuntimeError);
+
   // TODO: these are simply here for pybind11-stubgen ... but they don't work
   py::class_<MMThreadLock, std::shared_ptr<MMThreadLock>>(m, "MMThreadLock");
   py::class_<MM::Device>(m, "Device");
@@ -176,11 +2641,7 @@ PYBIND11_MODULE(_pymmdevice, m) {
 
   py::class_<PyCoreCallback, MM::Core>(m, "PyCoreCallback", py::dynamic_attr(),
                                        py::multiple_inheritance())
-      .def(py::init<>([]() {
-        CMMCore core;
-        printf("CoreCallback constructor\n");
-        return new PyCoreCallback(&core);
-      }))
+      .def(py::init<>([]() { return new PyCoreCallback(sharedMockCore()); }))
       .def("OnExposureChanged", &PyCoreCallback::OnExposureChanged)
 
       .def("GetDeviceProperty", &PyCoreCallback::GetDeviceProperty, "deviceName"_a, "propName"_a,
@@ -193,21 +2654,72 @@ PYBIND11_MODULE(_pymmdevice, m) {
       .def("SetSerialProperties", &PyCoreCallback::SetSerialProperties, "portName"_a,
            "answerTimeout"_a, "baudRate"_a, "delayBetweenCharsMs"_a, "handshaking"_a, "parity"_a,
            "stopBits"_a)
-      .def("WriteToSerial", &PyCoreCallback::WriteToSerial, "caller"_a, "portName"_a, "buf"_a,
-           "length"_a)
-      .def("ReadFromSerial", &PyCoreCallback::ReadFromSerial, "caller"_a, "portName"_a, "buf"_a,
-           "bufLength"_a, "bytesRead"_a)
+      // the serial calls take and return Python bytes and str in place of adapters' buffers
+      .def(
+          "WriteToSerial",
+          [](PyCoreCallback &self, const MM::Device *caller, const std::string &portName,
+             const py::bytes &data) {
+            const std::string buf = data;
+            return self.WriteToSerial(caller, portName.c_str(),
+                                      reinterpret_cast<const unsigned char *>(buf.data()),
+                                      static_cast<unsigned long>(buf.size()));
+          },
+          "caller"_a, "portName"_a, "data"_a,
+          "Write `data` to the port as an adapter would; returns the error code.")
+      .def(
+          "ReadFromSerial",
+          [](PyCoreCallback &self, const MM::Device *caller, const std::string &portName,
+             unsigned long bufLength) {
+            std::string buf(bufLength, '\0');
+            unsigned long bytesRead = 0;
+            int ret = self.ReadFromSerial(caller, portName.c_str(),
+                                          reinterpret_cast<unsigned char *>(&buf[0]), bufLength,
+                                          bytesRead);
+            buf.resize(bytesRead);
+            return std::make_pair(ret, py::bytes(buf));
+          },
+          "caller"_a, "portName"_a, "bufLength"_a = 4096,
+          "Read up to bufLength bytes from the port as an adapter would; returns (error code, "
+          "data).")
       .def("PurgeSerial", &PyCoreCallback::PurgeSerial, "caller"_a, "portName"_a)
       .def("SetSerialCommand", &PyCoreCallback::SetSerialCommand, "device"_a, "portName"_a,
            "command"_a, "term"_a)
-      .def("GetSerialAnswer", &PyCoreCallback::GetSerialAnswer, "device"_a, "portName"_a,
-           "ansLength"_a, "answerTxt"_a, "term"_a)
+      .def(
+          "GetSerialAnswer",
+          [](PyCoreCallback &self, const MM::Device *device, const std::string &portName,
+             const std::string &term, unsigned long ansLength) {
+            std::vector<char> answer(ansLength + 1, '\0');
+            int ret = self.GetSerialAnswer(device, portName.c_str(), ansLength, answer.data(),
+                                           term.c_str());
+            return std::make_pair(ret, std::string(answer.data()));
+          },
+          "device"_a, "portName"_a, "term"_a, "ansLength"_a = 1024,
+          "Read the port's next answer, up to `term`, as an adapter would; returns (error "
+          "code, answer).")
       .def("GetClockTicksUs", &PyCoreCallback::GetClockTicksUs, "caller"_a)
       // .def("GetCurrentMMTime", &PyCoreCallback::GetCurrentMMTime)
       .def("Sleep", &PyCoreCallback::Sleep, "caller"_a, "intervalMs"_a)
-      // .def("InsertImage"...
-      // .def("InsertImage"...
-      // .def("InsertImage"...
+      .def(
+          "InsertImage",
+          [](PyCoreCallback &self, const MM::Device *caller, py::array frame, bool doProcess) {
+            // (height, width) pixels, or (height, width, 4) bytes for RGB32
+            const bool rgb = frame.ndim() == 3 && frame.shape(2) == 4 && frame.itemsize() == 1;
+            if (frame.ndim() != 2 && !rgb)
+              throw py::value_error("frame must be a (height, width) or (height, width, 4) array");
+            if (!(frame.flags() & py::array::c_style))
+              throw py::value_error("frame must be C-contiguous");
+            return self.InsertImage(caller, static_cast<const unsigned char *>(frame.data()),
+                                    static_cast<unsigned>(frame.shape(1)),
+                                    static_cast<unsigned>(frame.shape(0)),
+                                    static_cast<unsigned>(rgb ? 4 : frame.itemsize()),
+                                    rgb ? 4u : 1u, nullptr, doProcess);
+          },
+          "caller"_a, "frame"_a, "doProcess"_a = true,
+          "Insert a frame into the camera's sequence buffer as its acquisition thread would; "
+          "returns the error code.\n\n"
+          "frame is a C-contiguous (height, width) array (or (height, width, 4) uint8 for RGB32 "
+          "images). With image processors attached it goes through them unless doProcess is "
+          "False, in order with the other frames either way.")
       .def("ClearImageBuffer", &PyCoreCallback::ClearImageBuffer, "caller"_a)
       .def("InitializeImageBuffer", &PyCoreCallback::InitializeImageBuffer, "channels"_a,
            "slices"_a, "w"_a, "h"_a, "pixDepth"_a)
@@ -294,14 +2806,73 @@ PYBIND11_MODULE(_pymmdevice, m) {
       .value("USBPort", MM::PortType::USBPort)
       .value("HIDPort", MM::PortType::HIDPort);
 
+  py::enum_<mm::logging::LogLevel>(m, "LogLevel")
+      .value("Trace", mm::logging::LogLevelTrace)
+      .value("Debug", mm::logging::LogLevelDebug)
+      .value("Info", mm::logging::LogLevelInfo)
+      .value("Warning", mm::logging::LogLevelWarning)
+      .value("Error", mm::logging::LogLevelError)
+      .value("Fatal", mm::logging::LogLevelFatal);
+
+  py::enum_<pixels::FocusMetric>(m, "FocusMetric")
+      .value("NormalizedVariance", pixels::FocusMetric::NormalizedVariance)
+      .value("Brenner", pixels::FocusMetric::Brenner)
+      .value("Tenengrad", pixels::FocusMetric::Tenengrad);
+
+  //////////////////////// Logging ////////////////////////
+
+  m.def(
+      "SetLogLevel",
+      [](mm::logging::LogLevel level, const std::string &label) {
+        logSink().SetLevel(level, label);
+      },
+      "level"_a, "label"_a = "",
+      "Set the lowest level logged for the device `label`, or by default if no label is "
+      "given.\n\n"
+      "Messages below it are dropped where they are logged.  The default level is Info.");
+  m.def(
+      "GetLogLevel",
+      [](const std::string &label) {
+        return static_cast<mm::logging::LogLevel>(logSink().GetLevel(label.c_str()));
+      },
+      "label"_a = "", "Return the lowest level logged for the device `label`, or by default.");
+  m.def("SetLogHandler", &setLogHandler, "handler"_a,
+        "Pass the log messages of all devices to `handler` in batches, or stop if None.\n\n"
+        "Devices only stage their messages; a background thread calls `handler` every few ms "
+        "with a time-ordered list of (time, level, label, thread, message) tuples, where "
+        "`time` is in seconds since the epoch and `label` is empty for the core.");
+  m.def(
+      "SetLogFile",
+      [](py::object path) { logSink().SetFile(path.is_none() ? "" : util::resolvePath(path)); },
+      "path"_a,
+      "Append the log messages of all devices to a file, formatted as in MMCore's logs, or "
+      "close it if None.");
+  m.def(
+      "FlushLog",
+      [] {
+        py::gil_scoped_release release;
+        logSink().Flush();
+      },
+      "Wait until every message logged so far has been written out.");
+  m.def(
+      "GetDroppedLogCount", [] { return logSink().GetDroppedCount(); },
+      "Return how many log messages were dropped because a thread logged faster than they "
+      "could be written out.");
+  // the writer thread must be done with Python before the interpreter goes away
+  py::module_::import("atexit").attr("register")(py::cpp_function([] {
+    logSink().SetHandler(nullptr);
+    py::gil_scoped_release release;
+    logSink().Stop();
+  }));
+
   //////////////////////// PluginManager ////////////////////////
 
-  py::class_<CPluginManager>(m, "PluginManager")
+  py::class_<PyPluginManager>(m, "PluginManager")
       .def(py::init())
       .def("GetSearchPaths", &CPluginManager::GetSearchPaths)
       .def(
           "SetSearchPaths",
-          [](CPluginManager &self, py::iterable paths) {
+          [](PyPluginManager &self, py::iterable paths) {
             std::vector<std::string> searchPaths;
             std::string env_path = getenv("PATH");
             for (py::handle path : paths) {
@@ -312,39 +2883,212 @@ PYBIND11_MODULE(_pymmdevice, m) {
                 env_path = path_str + ":" + env_path;
               }
             }
+            stopDiscovery(self);
             self.SetSearchPaths(searchPaths.begin(), searchPaths.end());
             // update PATH environment variable to include new paths
             setenv("PATH", env_path.c_str(), 1);
+            if (self.index) refreshAdapterIndex(self);
           },
           "paths"_a)
       .def("GetAvailableDeviceAdapters", &CPluginManager::GetAvailableDeviceAdapters)
-      .def("GetDeviceAdapter",
-           static_cast<std::shared_ptr<LoadedDeviceAdapter> (CPluginManager::*)(
-               const std::string &)>(&CPluginManager::GetDeviceAdapter),
-           "moduleName"_a)
-      .def("UnloadPluginLibrary", &CPluginManager::UnloadPluginLibrary, "moduleName"_a);
+      .def("GetDeviceAdapter", &getDeviceAdapter, "moduleName"_a)
+      .def("UnloadPluginLibrary", &CPluginManager::UnloadPluginLibrary, "moduleName"_a)
+      .def(
+          "EnableAdapterIndex",
+          [](PyPluginManager &self, py::handle indexPath) {
+            stopDiscovery(self);
+            self.index = std::make_shared<AdapterIndex>(util::resolvePath(indexPath),
+                                                        DEVICE_INTERFACE_VERSION);
+            return refreshAdapterIndex(self);
+          },
+          "indexPath"_a,
+          "Keep a record of the devices each adapter library advertises in `indexPath`.\n\n"
+          "GetIndexedDeviceAdapters and GetIndexedDevices then answer from the record instead "
+          "of loading libraries.  Libraries that are new or have changed since they were "
+          "recorded (or all of them, if the bindings were rebuilt for a new "
+          "DEVICE_INTERFACE_VERSION) are probed whenever the search paths are set or "
+          "RefreshAdapterIndex is called.  Returns the number of libraries probed.")
+      .def("RefreshAdapterIndex", &refreshAdapterIndex,
+           "Re-scan the search paths and probe new or changed adapter libraries.\n\n"
+           "Returns the number of libraries probed.")
+      .def(
+          "GetIndexedDeviceAdapters",
+          [](PyPluginManager &self) {
+            if (!self.index) throw std::runtime_error("The adapter index is not enabled");
+            return self.index->GetModuleNames();
+          },
+          "Names of the indexed adapter libraries on the search paths that loaded successfully.")
+      .def(
+          "GetIndexedDevices",
+          [](PyPluginManager &self, const std::string &moduleName) {
+            if (!self.index) throw std::runtime_error("The adapter index is not enabled");
+            IndexedAdapter adapter;
+            if (!self.index->Find(moduleName, adapter))
+              throw std::runtime_error("No adapter library named " + ToQuotedString(moduleName) +
+                                       " on the search paths");
+            if (!adapter.error.empty()) throw std::runtime_error(adapter.error);
+            std::vector<std::tuple<std::string, MM::DeviceType, std::string>> devices;
+            for (const IndexedAdapter::Device &device : adapter.devices)
+              devices.emplace_back(device.name, static_cast<MM::DeviceType>(device.type),
+                                   device.description);
+            return devices;
+          },
+          "moduleName"_a,
+          "Return (name, type, description) for each device the adapter library advertises, "
+          "from the adapter index.")
+      .def(
+          "StartDiscovery",
+          [](PyPluginManager &self, size_t maxWorkers) {
+            stopDiscovery(self);
+            self.discovery = std::make_shared<AdapterDiscovery>(self.GetSearchPaths(),
+                                                                probeAdapter, self.index,
+                                                                maxWorkers);
+            return self.discovery;
+          },
+          "max_workers"_a = 0,
+          "Find and validate the adapter libraries on the search paths in the background.\n\n"
+          "Directories are listed and libraries loaded and checked on up to max_workers threads "
+          "(0 for one per CPU), and the returned AdapterDiscovery reports progress.  While it "
+          "runs, GetDeviceAdapter loads a module the scan has not reached yet immediately.  If "
+          "the adapter index is enabled, unchanged libraries are taken from it and it is updated "
+          "when the scan completes.  Setting the search paths cancels the scan.");
+
+  py::class_<AdapterDiscovery, std::shared_ptr<AdapterDiscovery>>(m, "AdapterDiscovery")
+      .def(
+          "Wait",
+          [](AdapterDiscovery &self, py::object timeout) {
+            double timeoutMs = timeout.is_none() ? -1.0 : timeout.cast<double>() * 1000.0;
+            py::gil_scoped_release release;
+            return self.Wait(timeoutMs);
+          },
+          "timeout"_a = py::none(),
+          "Wait up to `timeout` seconds (forever if None) for the scan to complete.\n\n"
+          "Returns whether it has completed.")
+      .def("IsDone", &AdapterDiscovery::IsDone)
+      .def("GetProgress", &AdapterDiscovery::GetProgress,
+           "Return (libraries validated, total libraries); the total is 0 until every search "
+           "path has been listed.")
+      .def("GetAvailableDeviceAdapters", &AdapterDiscovery::GetModuleNames,
+           "Names of the adapter libraries validated so far that loaded successfully.")
+      .def("GetErrors", &AdapterDiscovery::GetErrors,
+           "Return {moduleName: error} for the adapter libraries that failed to load.")
+      .def("Cancel", &AdapterDiscovery::Cancel,
+           "Stop probing further libraries.  The scan completes once those in progress are "
+           "done.");
+
+  ////////////////////// EventStream //////////////////////
+
+  py::class_<PyEventStream, std::shared_ptr<PyEventStream>>(
+      m, "EventStream",
+      "Change notifications from a DeviceManager's devices, queued as they happen.\n\n"
+      "Events are tuples: (kind, deviceLabel, *data), where kind is one of 'PropertyChanged' "
+      "(data: name, value), 'PropertiesChanged', 'StagePositionChanged' (pos), "
+      "'XYStagePositionChanged' (x, y), 'ExposureChanged' (ms), 'SLMExposureChanged' (ms) or "
+      "'MagnifierChanged'.")
+      .def("Drain", &PyEventStream::Drain, "maxEvents"_a = 0,
+           "Return the queued events (at most maxEvents, if nonzero) without waiting.\n\n"
+           "With coalescing, only the latest of repeated updates to the same property, "
+           "position or exposure in the batch is kept.")
+      .def(
+          "Wait",
+          [](PyEventStream &self, py::object timeout) {
+            return self.Wait(timeout.is_none() ? -1.0 : timeout.cast<double>() * 1000.0);
+          },
+          "timeout"_a = py::none(),
+          "Wait up to `timeout` seconds (forever if None) for events.\n\n"
+          "Returns whether any may be queued.")
+      .def(
+          "fileno", [](const PyEventStream &self) { return self.Queue()->GetFileDescriptor(); },
+          "A file descriptor that is readable while events may be queued, for select() and "
+          "event loops.  -1 where unsupported (Windows).")
+      .def("GetDroppedCount",
+           [](const PyEventStream &self) { return self.Queue()->GetDroppedCount(); },
+           "Number of events dropped because the queue was full.")
+      .def("Close", &PyEventStream::Close, "Stop receiving events.")
+      .def("__enter__", [](std::shared_ptr<PyEventStream> self) { return self; })
+      .def("__exit__", [](PyEventStream &self, py::args) { self.Close(); })
+      .def("__iter__", [](std::shared_ptr<PyEventStream> self) { return self; })
+      .def("__next__", [](PyEventStream &self) {
+        py::object event = self.Next();
+        if (!event) throw py::stop_iteration();
+        return event;
+      });
 
   ////////////////////// DeviceManager //////////////////////
 
   py::class_<mm::DeviceManager, std::shared_ptr<mm::DeviceManager>>(m, "DeviceManager")
-      .def(py::init<>())
+      .def(py::init(&makeDeviceManager))
       .def("__enter__", [](mm::DeviceManager &self) -> mm::DeviceManager & { return self; })
       .def("__exit__",
-           [](mm::DeviceManager &self, py::args args) -> void { self.UnloadAllDevices(); })
+           [](mm::DeviceManager &self, py::args args) -> void { unloadAllDevices(self); })
       .def(
           "LoadDevice",
-          [](mm::DeviceManager &self, std::shared_ptr<LoadedDeviceAdapter> module,
-             const std::string &deviceName,
-             const std::string &label) -> std::shared_ptr<DeviceInstance> {
-            MockCMMCore mockCore;
-            mm::logging::internal::GenericLogger<mm::logging::EntryData> deviceLogger(0);
-            mm::logging::internal::GenericLogger<mm::logging::EntryData> coreLogger(0);
-            return self.LoadDevice(module, deviceName, label, &mockCore, deviceLogger, coreLogger);
-          },
+          &loadManagedDevice,
           "module"_a, "deviceName"_a, "label"_a, py::return_value_policy::automatic,
           "Load the specified device and assign a device label.")
-      .def("UnloadDevice", &mm::DeviceManager::UnloadDevice, "device"_a, "Unload a device.")
-      .def("UnloadAllDevices", &mm::DeviceManager::UnloadAllDevices, "Unload all devices.")
+      .def(
+          "UnloadDevice",
+          [](mm::DeviceManager &self, std::shared_ptr<DeviceInstance> device) {
+            forgetDevice(device->GetRawPtr());
+            self.UnloadDevice(device);
+            device->SetCallback(defaultCoreCallback());  // Python still holds it
+            std::shared_ptr<PyCoreCallback> callback = managerCallbacks().Find(&self);
+            if (callback) callback->Routes().Update(self);
+          },
+          "device"_a, "Unload a device.")
+      .def("UnloadAllDevices", &unloadAllDevices, "Unload all devices.")
+      .def(
+          "OpenEventStream",
+          [](const mm::DeviceManager &self, size_t capacity, bool coalesce) {
+            std::shared_ptr<PyCoreCallback> callback = managerCallbacks().Find(&self);
+            if (!callback) throw std::runtime_error("This DeviceManager has no core callback");
+            return std::make_shared<PyEventStream>(callback, capacity, coalesce);
+          },
+          "capacity"_a = 4096, "coalesce"_a = true,
+          "Subscribe to the change notifications of this manager's devices.\n\n"
+          "Notifications are queued from the adapters' threads without taking the GIL; events "
+          "beyond `capacity` that haven't been drained are dropped and counted.")
+      .def("EnableCallStats", &enableCallStats, "enable"_a = true, "trace_capacity"_a = 0,
+           "Time every call made from Python to this manager's devices.\n\n"
+           "Per device and method, GetCallStats reports the count, total, mean, min, max, "
+           "p50 and p99 of the call time, and how much of it went to waiting for the "
+           "adapter's lock and to the adapter itself (the rest is spent in the bindings).  "
+           "With trace_capacity > 0, the most recent calls are also kept for "
+           "ExportCallTrace.  Enabling again starts afresh; enable=False stops and discards "
+           "the stats.")
+      .def("GetCallStats", &getCallStats,
+           "Return the call stats collected since EnableCallStats, by label and method.")
+      .def("ExportCallTrace", &exportCallTrace, "path"_a,
+           "Write the traced calls as Chrome trace-event JSON; returns how many.\n\n"
+           "The file opens in chrome://tracing or Perfetto.  Raises RuntimeError unless "
+           "EnableCallStats was called with a trace_capacity.")
+      .def("LoadAndInitializeAll", &loadAndInitializeAll, "specs"_a, "max_workers"_a = 0,
+           "Load and initialize a batch of devices, in parallel where possible.\n\n"
+           "specs is a list of (module, deviceName, label) or (module, deviceName, label, "
+           "parentLabel) tuples.  Without a parentLabel, a device's parent is the hub in the "
+           "batch that lists it among its installed peripherals, if any.  Hubs are initialized "
+           "before their peripherals; devices from different adapter libraries are initialized "
+           "concurrently, on up to max_workers threads (0 means one per library).  Returns each "
+           "device's initialization time in ms.  If any device fails, the others are still "
+           "initialized and a RuntimeError lists the failures.")
+      .def("WaitForDevices", &waitForDevices, "labels"_a, "timeout"_a = 5.0,
+           "Wait until none of the given devices is busy; returns each one's settle time in "
+           "ms.\n\n"
+           "Busy() is polled with the GIL released, at first every 0.5 ms and backing off to "
+           "every 10 ms, and again at once whenever a stage reports a new position.  A device "
+           "that uses a delay isn't settled before GetDelayMs() has passed since the call.  "
+           "Raises TimeoutError if any is still busy after `timeout` seconds (no limit if "
+           "None).")
+      .def("SnapshotProperties", &snapshotProperties, "max_workers"_a = 0,
+           "Read every property of every loaded device.\n\n"
+           "Returns a dict of equal-length columns: 'device', 'name', 'value', 'type' and "
+           "'readOnly'.  Devices from different adapter libraries are read in parallel, on up "
+           "to max_workers threads (0 means one per library).")
+      .def("ApplyProperties", &applyProperties, "snapshot"_a, "max_workers"_a = 0,
+           "Restore a snapshot taken with SnapshotProperties.\n\n"
+           "Only writable properties whose current value differs are set, in snapshot order "
+           "within each device.  Returns the (device, name) pairs that were set.  If any "
+           "property fails, the rest are still applied and a RuntimeError lists the failures.")
       .def("GetDevice",
            (std::shared_ptr<DeviceInstance>(mm::DeviceManager::*)(const char *) const) &
                mm::DeviceManager::GetDevice,
@@ -452,6 +3196,94 @@ PYBIND11_MODULE(_pymmdevice, m) {
         return self.GetParentDevice(device);
       });
 
+  ////////////////////// HardwareSequence //////////////////////
+
+  py::class_<HardwareSequence>(m, "HardwareSequence")
+      .def(py::init<std::shared_ptr<mm::DeviceManager>, const std::string &>(), "manager"_a,
+           "cameraLabel"_a,
+           "A hardware-triggered acquisition of one camera frame per event, during which "
+           "each added device steps through its own sequence of values.")
+      .def("AddStageSequence", &HardwareSequence::AddStage, "label"_a, "positions"_a)
+      .def("AddXYStageSequence", &HardwareSequence::AddXYStage, "label"_a, "xs"_a, "ys"_a)
+      .def("AddDASequence", &HardwareSequence::AddDA, "label"_a, "voltages"_a)
+      .def("AddExposureSequence", &HardwareSequence::AddExposure, "exposures_ms"_a,
+           "Sequence the camera's own exposure time.")
+      .def("AddPropertySequence", &HardwareSequence::AddProperty, "label"_a, "name"_a,
+           "values"_a)
+      .def("GetLength", &HardwareSequence::GetLength, "Return the number of events (frames).")
+      .def("GetChunks", &HardwareSequence::GetChunks,
+           "Return the [begin, end) event ranges the sequence is run in.\n\n"
+           "Each chunk is as long as the shortest maximum sequence length of the devices.")
+      .def("Run", &HardwareSequence::Run, "interval_ms"_a = 0.0, "stopOnOverflow"_a = true,
+           "max_workers"_a = 0, py::call_guard<py::gil_scoped_release>(),
+           "Run the whole sequence, chunk by chunk, without the GIL.\n\n"
+           "For each chunk every device's sequence is uploaded (devices from different adapter "
+           "libraries in parallel, on up to max_workers threads) and started, then the camera's "
+           "sequence acquisition is started, and the device sequences are stopped once the "
+           "camera is done.  Frames land in the camera's sequence buffer, which another thread "
+           "can drain with PopNextImage meanwhile.  Returns the number of chunks completed.")
+      .def("Abort", &HardwareSequence::Abort,
+           "Stop a Run in progress on another thread; it returns after the current frame.");
+
+  py::class_<TileScan>(m, "TileScan")
+      .def(py::init<std::shared_ptr<mm::DeviceManager>, const std::string &,
+                    const std::string &>(),
+           "manager"_a, "cameraLabel"_a, "xyStageLabel"_a,
+           "A tiled acquisition of one camera frame at each of a list of XY stage positions.")
+      .def("Run", &TileScan::Run, "positions"_a, "out"_a, "offsets"_a = py::none(),
+           "settle_timeout"_a = 5.0,
+           "Visit each (x, y) position in um, wait for the stage to settle and snap a frame, "
+           "without the GIL.\n\n"
+           "`out` is either an (N, height, width) stack or a 2-D mosaic, in which case "
+           "`offsets` gives each tile's top-left (row, column).  Each frame is copied there on "
+           "a second thread while the stage moves on.  Returns a dict of 'settled_ms', "
+           "'snapped_ms' and 'copied_ms' arrays, in ms since the start (NaN for tiles not "
+           "reached).  Raises TimeoutError if the stage takes longer than settle_timeout "
+           "seconds to settle at a tile (no limit if None).")
+      .def("Abort", &TileScan::Abort,
+           "Stop a Run in progress on another thread; it returns once the current tile is "
+           "copied.");
+
+  m.def(
+      "FocusScore",
+      [](py::array image, pixels::FocusMetric metric) {
+        if (image.ndim() != 2) throw py::value_error("image must be 2-D");
+        if (!(image.flags() & py::array::c_style))
+          throw py::value_error("image must be C-contiguous");
+        if (image.dtype().kind() != 'u')
+          throw py::value_error("Focus scores need an unsigned integer image");
+        const void *data = image.data();
+        auto height = static_cast<unsigned>(image.shape(0));
+        auto width = static_cast<unsigned>(image.shape(1));
+        auto bytesPerPixel = static_cast<unsigned>(image.itemsize());
+        py::gil_scoped_release release;
+        return scoreImage(data, width, height, bytesPerPixel, metric);
+      },
+      "image"_a, "metric"_a = pixels::FocusMetric::NormalizedVariance,
+      "Score the sharpness of a 2-D uint8 or uint16 image (higher is sharper), as "
+      "SoftwareAutofocus does.");
+
+  py::class_<SoftwareAutofocus>(m, "SoftwareAutofocus")
+      .def(py::init<std::shared_ptr<mm::DeviceManager>, const std::string &,
+                    const std::string &>(),
+           "manager"_a, "cameraLabel"_a, "stageLabel"_a,
+           "Image-based autofocus with a camera and a focus stage, for rigs without an "
+           "autofocus device.")
+      .def("SnapAndScore", &SoftwareAutofocus::SnapAndScore,
+           "metric"_a = pixels::FocusMetric::NormalizedVariance,
+           "Snap a frame where the stage is and score it in the camera's buffer, without the "
+           "GIL.")
+      .def("Run", &SoftwareAutofocus::Run, "range_um"_a = 20.0, "step_um"_a = 2.0,
+           "min_step_um"_a = 0.25, "metric"_a = pixels::FocusMetric::NormalizedVariance,
+           "center_um"_a = py::none(), "settle_timeout"_a = 5.0,
+           "Find the sharpest focus position, without the GIL, and leave the stage there.\n\n"
+           "Frames are snapped every step_um over range_um around center_um (the current "
+           "position if None), then either side of the best one in quarter steps down to "
+           "min_step_um.  Returns a dict of 'position_um' and 'score' of the best position, "
+           "the 'positions' and 'scores' visited, and 'score_ms', the time spent scoring.  "
+           "Raises TimeoutError if the stage takes longer than settle_timeout seconds to "
+           "settle (no limit if None).");
+
   ////////////////////// DeviceAdapter (a.k.a. LoadedDeviceAdapter) //////////////////////
 
   py::class_<LoadedDeviceAdapter, std::shared_ptr<LoadedDeviceAdapter>>(m, "LoadedDeviceAdapter")
@@ -531,164 +3363,486 @@ PYBIND11_MODULE(_pymmdevice, m) {
   /////////////////////// CameraInstance ///////////////////////
 
   bindDeviceInstance<CameraInstance>(m, "CameraInstance")
-      .def("SnapImage", &CameraInstance::SnapImage)
-      .def("GetImageBufferAsRGB32", &CameraInstance::GetImageBufferAsRGB32)
-      .def("GetNumberOfComponents", &CameraInstance::GetNumberOfComponents)
-      .def("GetComponentName", &CameraInstance::GetComponentName)
-      .def("GetNumberOfChannels", &CameraInstance::GetNumberOfChannels)
-      .def("GetChannelName", &CameraInstance::GetChannelName)
-      .def("GetImageBufferSize", &CameraInstance::GetImageBufferSize)
-      .def("GetImageWidth", &CameraInstance::GetImageWidth)
-      .def("GetImageHeight", &CameraInstance::GetImageHeight)
-      .def("GetImageBytesPerPixel", &CameraInstance::GetImageBytesPerPixel)
-      .def("GetBitDepth", &CameraInstance::GetBitDepth)
-      .def("GetPixelSizeUm", &CameraInstance::GetPixelSizeUm)
-      .def("GetBinning", &CameraInstance::GetBinning)
-      .def("SetBinning", &CameraInstance::SetBinning)
-      .def("SetExposure", &CameraInstance::SetExposure)
-      .def("GetExposure", &CameraInstance::GetExposure)
-      .def("SetROI", &CameraInstance::SetROI)
+      .def("SnapImage", util::deviceCall<CameraInstance>(&CameraInstance::SnapImage),
+           "Expose and read out one image into the camera's buffer.\n\n"
+           "Other Python threads keep running during the exposure, and devices from other "
+           "adapter libraries (a stage, say) can be driven meanwhile; devices from the camera's "
+           "own library wait until the snap returns.")
+      .def("GetImageBufferAsRGB32",
+           util::deviceCall<CameraInstance>(&CameraInstance::GetImageBufferAsRGB32))
+      .def("GetNumberOfComponents",
+           util::deviceCall<CameraInstance>(&CameraInstance::GetNumberOfComponents))
+      .def("GetComponentName", util::deviceCall<CameraInstance>(&CameraInstance::GetComponentName))
+      .def("GetNumberOfChannels",
+           util::deviceCall<CameraInstance>(&CameraInstance::GetNumberOfChannels))
+      .def("GetChannelName", util::deviceCall<CameraInstance>(&CameraInstance::GetChannelName))
+      .def("GetImageBufferSize",
+           util::deviceCall<CameraInstance>(&CameraInstance::GetImageBufferSize))
+      .def("GetImageWidth", util::deviceCall<CameraInstance>(&CameraInstance::GetImageWidth))
+      .def("GetImageHeight", util::deviceCall<CameraInstance>(&CameraInstance::GetImageHeight))
+      .def("GetImageBytesPerPixel",
+           util::deviceCall<CameraInstance>(&CameraInstance::GetImageBytesPerPixel))
+      .def("GetBitDepth", util::deviceCall<CameraInstance>(&CameraInstance::GetBitDepth))
+      .def("GetPixelSizeUm", util::deviceCall<CameraInstance>(&CameraInstance::GetPixelSizeUm))
+      .def("GetBinning", util::deviceCall<CameraInstance>(&CameraInstance::GetBinning))
+      .def("SetBinning", util::deviceCall<CameraInstance>(&CameraInstance::SetBinning))
+      .def("SetExposure", util::deviceCall<CameraInstance>(&CameraInstance::SetExposure))
+      .def("GetExposure", util::deviceCall<CameraInstance>(&CameraInstance::GetExposure))
+      .def("SetROI", util::deviceCall<CameraInstance>(&CameraInstance::SetROI))
       .def("GetROI",
            [](CameraInstance &self) {
+             util::DeviceCallGuard guard(self);
              unsigned x, y, xSize, ySize;
              self.GetROI(x, y, xSize, ySize);
              return std::make_tuple(x, y, xSize, ySize);
            })
-      .def("ClearROI", &CameraInstance::ClearROI)
-      .def("SupportsMultiROI", &CameraInstance::SupportsMultiROI)
-      .def("IsMultiROISet", &CameraInstance::IsMultiROISet)
-      .def("GetMultiROICount", &CameraInstance::GetMultiROICount)
-      .def("SetMultiROI", &CameraInstance::SetMultiROI)
-      .def("GetMultiROI", &CameraInstance::GetMultiROI)
-      .def("StartSequenceAcquisition", static_cast<int (CameraInstance::*)(long, double, bool)>(
-                                           &CameraInstance::StartSequenceAcquisition))
-      .def("StartSequenceAcquisition",
-           static_cast<int (CameraInstance::*)(double)>(&CameraInstance::StartSequenceAcquisition))
-      .def("StopSequenceAcquisition", &CameraInstance::StopSequenceAcquisition)
-      .def("PrepareSequenceAcquisition", &CameraInstance::PrepareSequenceAcqusition)
-      .def("IsCapturing", &CameraInstance::IsCapturing)
-      .def("GetTags", &CameraInstance::GetTags)
-      .def("AddTag", &CameraInstance::AddTag)
-      .def("RemoveTag", &CameraInstance::RemoveTag)
-      .def("IsExposureSequenceable", &CameraInstance::IsExposureSequenceable)
-      .def("GetExposureSequenceMaxLength", &CameraInstance::GetExposureSequenceMaxLength)
-      .def("StartExposureSequence", &CameraInstance::StartExposureSequence)
-      .def("StopExposureSequence", &CameraInstance::StopExposureSequence)
-      .def("ClearExposureSequence", &CameraInstance::ClearExposureSequence)
-      .def("AddToExposureSequence", &CameraInstance::AddToExposureSequence)
-      .def("SendExposureSequence", &CameraInstance::SendExposureSequence)
-
-      .def("GetImageBuffer", static_cast<const unsigned char *(CameraInstance::*)()>(
-                                 &CameraInstance::GetImageBuffer))
-      .def("GetImageBuffer", static_cast<const unsigned char *(CameraInstance::*)(unsigned)>(
-                                 &CameraInstance::GetImageBuffer))
+      .def("ClearROI", util::deviceCall<CameraInstance>(&CameraInstance::ClearROI))
+      .def("SupportsMultiROI", util::deviceCall<CameraInstance>(&CameraInstance::SupportsMultiROI))
+      .def("IsMultiROISet", util::deviceCall<CameraInstance>(&CameraInstance::IsMultiROISet))
+      .def("GetMultiROICount",
+           [](CameraInstance &self) {
+             util::DeviceCallGuard guard(self);
+             unsigned count = 0;
+             int ret = self.GetMultiROICount(count);
+             if (ret != DEVICE_OK) throw std::runtime_error(getErrorMessage(&self, ret));
+             return count;
+           })
+      .def(
+          "SetMultiROI",
+          [](CameraInstance &self, const std::vector<unsigned> &xs,
+             const std::vector<unsigned> &ys, const std::vector<unsigned> &widths,
+             const std::vector<unsigned> &heights) {
+            if (ys.size() != xs.size() || widths.size() != xs.size() ||
+                heights.size() != xs.size())
+              throw py::value_error("xs, ys, widths and heights must have the same length");
+            util::DeviceCallGuard guard(self);
+            int ret = self.SetMultiROI(xs.data(), ys.data(), widths.data(), heights.data(),
+                                       static_cast<unsigned>(xs.size()));
+            if (ret != DEVICE_OK) throw std::runtime_error(getErrorMessage(&self, ret));
+          },
+          "xs"_a, "ys"_a, "widths"_a, "heights"_a)
+      .def(
+          "GetMultiROI",
+          [](CameraInstance &self) {
+            util::DeviceCallGuard guard(self);
+            unsigned count = 0;
+            int ret = self.GetMultiROICount(count);
+            if (ret != DEVICE_OK) throw std::runtime_error(getErrorMessage(&self, ret));
+            std::vector<unsigned> xs(count), ys(count), widths(count), heights(count);
+            ret = self.GetMultiROI(xs.data(), ys.data(), widths.data(), heights.data(), &count);
+            if (ret != DEVICE_OK) throw std::runtime_error(getErrorMessage(&self, ret));
+            std::vector<std::tuple<unsigned, unsigned, unsigned, unsigned>> rois;
+            for (unsigned i = 0; i < count; ++i)
+              rois.emplace_back(xs[i], ys[i], widths[i], heights[i]);
+            return rois;
+          },
+          "Return the ROIs as a list of (x, y, width, height) tuples in sensor coordinates.")
+      .def(
+          "GetMultiROIArrays",
+          [](CameraInstance &self, bool copy) {
+            const unsigned char *buffer;
+            unsigned width, bytesPerPixel;
+            std::vector<SequenceBuffer::Rect> rects;
+            {
+              util::DeviceCallGuard guard(self);
+              buffer = self.GetImageBuffer();
+              width = self.GetImageWidth();
+              bytesPerPixel = self.GetImageBytesPerPixel();
+              rects = multiROIRects(self);
+              if (rects.empty()) rects.push_back({0, 0, width, self.GetImageHeight()});
+            }
+            if (buffer == nullptr)
+              throw std::runtime_error("No image in the camera buffer; call SnapImage first");
+            py::object owner;
+            if (!copy) owner = py::cast(&self, py::return_value_policy::reference);
+            const size_t rowBytes = static_cast<size_t>(width) * bytesPerPixel;
+            py::list arrays;
+            for (const SequenceBuffer::Rect &r : rects) {
+              const unsigned char *origin = buffer + r.y * rowBytes + r.x * bytesPerPixel;
+              arrays.append(util::regionToNumpy(origin, rowBytes, r.height, r.width,
+                                                bytesPerPixel, owner));
+            }
+            return arrays;
+          },
+          "copy"_a = false,
+          "Return the pixels of each ROI of the last snapped image as a list of arrays.\n\n"
+          "By default the arrays are read-only strided views into the camera's image buffer, "
+          "with the same lifetime caveats as GetImageArray(copy=False); pass copy=True for "
+          "independent arrays.  Without multi-ROI the list holds the whole image.")
+      .def(
+          "StartSequenceAcquisition",
+          [](CameraInstance &self, long numImages, double interval_ms, bool stopOnOverflow) {
+            {
+              py::gil_scoped_release release;
+              drainFramePipeline(self);
+            }
+            util::DeviceCallGuard guard(self);
+            prepareSequenceBuffer(self);
+            return self.StartSequenceAcquisition(numImages, interval_ms, stopOnOverflow);
+          },
+          "numImages"_a, "interval_ms"_a, "stopOnOverflow"_a)
+      .def(
+          "StartSequenceAcquisition",
+          [](CameraInstance &self, double interval_ms) {
+            {
+              py::gil_scoped_release release;
+              drainFramePipeline(self);
+            }
+            util::DeviceCallGuard guard(self);
+            prepareSequenceBuffer(self);
+            return self.StartSequenceAcquisition(interval_ms);
+          },
+          "interval_ms"_a)
+      .def("StopSequenceAcquisition",
+           util::deviceCall<CameraInstance>(&CameraInstance::StopSequenceAcquisition))
+      .def("PrepareSequenceAcquisition",
+           util::deviceCall<CameraInstance>(&CameraInstance::PrepareSequenceAcqusition))
+      .def("IsCapturing", util::deviceCall<CameraInstance>(&CameraInstance::IsCapturing))
+      .def(
+          "InitializeSequenceBuffer",
+          [](CameraInstance &self, size_t capacity) {
+            util::DeviceCallGuard guard(self);
+            initializeSequenceBuffer(self, capacity);
+          },
+          "capacity"_a = 0,
+          "Preallocate the sequence buffer for the current image size.\n\n"
+          "capacity is a number of frames; 0 sizes the buffer to about 250 MB.  "
+          "StartSequenceAcquisition calls this automatically if the image size changed.")
+      .def(
+          "PopNextImage",
+          [](CameraInstance &self) {
+            std::shared_ptr<SequenceBuffer> buffer = sequenceBuffers().Find(self.GetRawPtr());
+            if (!buffer) throw py::index_error("Sequence buffer is empty");
+            if (!buffer->GetROIs().empty())
+              throw std::runtime_error(
+                  "The sequence buffer holds multi-ROI frames; use PopNextImageROIs");
+            py::array frame = util::bufferToNumpy(nullptr, buffer->GetHeight(),
+                                                  buffer->GetWidth(), buffer->GetBytesPerPixel());
+            auto *dest = static_cast<unsigned char *>(frame.mutable_data());
+            bool popped;
+            {
+              py::gil_scoped_release release;
+              popped = buffer->Pop(dest);
+            }
+            if (!popped) throw py::index_error("Sequence buffer is empty");
+            return frame;
+          },
+          "Remove the oldest frame from the sequence buffer and return it as a numpy array.")
+      .def(
+          "PopNextImageROIs",
+          [](CameraInstance &self) {
+            std::shared_ptr<SequenceBuffer> buffer = sequenceBuffers().Find(self.GetRawPtr());
+            if (!buffer) throw py::index_error("Sequence buffer is empty");
+            std::vector<SequenceBuffer::Rect> rects = buffer->GetROIs();
+            if (rects.empty()) rects.push_back({0, 0, buffer->GetWidth(), buffer->GetHeight()});
+            py::array packed(py::dtype::of<uint8_t>(),
+                             {static_cast<py::ssize_t>(buffer->GetFrameBytes())});
+            auto *dest = static_cast<unsigned char *>(packed.mutable_data());
+            bool popped;
+            {
+              py::gil_scoped_release release;
+              popped = buffer->Pop(dest);
+            }
+            if (!popped) throw py::index_error("Sequence buffer is empty");
+
+            // each ROI is a view onto its part of the packed frame
+            const unsigned bytesPerPixel = buffer->GetBytesPerPixel();
+            py::dtype dtype = util::pixelDtype(bytesPerPixel);
+            py::list arrays;
+            for (const SequenceBuffer::Rect &r : rects) {
+              const py::ssize_t rowBytes = static_cast<py::ssize_t>(r.width) * bytesPerPixel;
+              arrays.append(py::array(
+                  dtype, {static_cast<py::ssize_t>(r.height), static_cast<py::ssize_t>(r.width)},
+                  {rowBytes, static_cast<py::ssize_t>(bytesPerPixel)}, dest, packed));
+              dest += r.height * rowBytes;
+            }
+            return arrays;
+          },
+          "Remove the oldest frame from the sequence buffer and return one array per ROI.\n\n"
+          "If multi-ROI was set when the sequence started, only the ROI pixels were buffered.")
+      .def(
+          "GetRemainingImageCount",
+          [](CameraInstance &self) -> size_t {
+            std::shared_ptr<SequenceBuffer> buffer = sequenceBuffers().Find(self.GetRawPtr());
+            return buffer ? buffer->GetRemainingCount() : 0;
+          },
+          "Number of frames waiting in the sequence buffer.")
+      .def(
+          "GetSequenceBufferCapacity",
+          [](CameraInstance &self) -> size_t {
+            std::shared_ptr<SequenceBuffer> buffer = sequenceBuffers().Find(self.GetRawPtr());
+            return buffer ? buffer->GetCapacity() : 0;
+          },
+          "Number of frame slots in the sequence buffer.")
+      .def(
+          "GetSequenceBufferOverflowCount",
+          [](CameraInstance &self) -> uint64_t {
+            std::shared_ptr<SequenceBuffer> buffer = sequenceBuffers().Find(self.GetRawPtr());
+            return buffer ? buffer->GetOverflowCount() : 0;
+          },
+          "Number of frames dropped because the sequence buffer was full.")
+      .def(
+          "ClearSequenceBuffer",
+          [](CameraInstance &self) {
+            std::shared_ptr<SequenceBuffer> buffer = sequenceBuffers().Find(self.GetRawPtr());
+            if (buffer) buffer->Discard();
+          },
+          "Discard all frames waiting in the sequence buffer.")
+      .def("SetImageProcessors", &setImageProcessors, "processors"_a, "queueFrames"_a = 8,
+           "Run these image processors, in order, on every frame of a sequence acquisition.\n\n"
+           "Frames are queued (up to queueFrames of them) and processed in place on a worker "
+           "thread before they reach the sequence buffer, so processing overlaps with "
+           "acquisition.  A frame a processor fails on is dropped.  An empty list detaches the "
+           "processors; frames still queued are discarded.")
+      .def(
+          "WaitForImageProcessors",
+          [](CameraInstance &self, py::object timeout) {
+            std::shared_ptr<FramePipeline> pipeline = framePipelines().Find(self.GetRawPtr());
+            if (!pipeline) return true;
+            double timeoutMs = timeout.is_none() ? -1.0 : timeout.cast<double>() * 1000.0;
+            py::gil_scoped_release release;
+            return pipeline->WaitIdle(timeoutMs);
+          },
+          "timeout"_a = py::none(),
+          "Wait up to `timeout` seconds (forever if None) until every queued frame has been "
+          "processed and put in the sequence buffer.  Returns whether that happened.")
+      .def(
+          "GetImageProcessingStats",
+          [](CameraInstance &self) {
+            std::shared_ptr<FramePipeline> pipeline = framePipelines().Find(self.GetRawPtr());
+            py::dict stats;
+            stats["processed"] = pipeline ? pipeline->GetProcessedCount() : 0;
+            stats["errors"] = pipeline ? pipeline->GetErrorCount() : 0;
+            stats["overflows"] = pipeline ? pipeline->GetOverflowCount() : 0;
+            stats["lastError"] = pipeline ? pipeline->GetLastError() : std::string();
+            return stats;
+          },
+          "Return the number of frames processed, failed and dropped because the processing "
+          "queue was full, and the last processing error.")
+      .def("GetTags", util::deviceCall<CameraInstance>(&CameraInstance::GetTags))
+      .def("AddTag", util::deviceCall<CameraInstance>(&CameraInstance::AddTag))
+      .def("RemoveTag", util::deviceCall<CameraInstance>(&CameraInstance::RemoveTag))
+      .def("IsExposureSequenceable",
+           util::deviceCall<CameraInstance>(&CameraInstance::IsExposureSequenceable))
+      .def("GetExposureSequenceMaxLength",
+           util::deviceCall<CameraInstance>(&CameraInstance::GetExposureSequenceMaxLength))
+      .def("StartExposureSequence",
+           util::deviceCall<CameraInstance>(&CameraInstance::StartExposureSequence))
+      .def("StopExposureSequence",
+           util::deviceCall<CameraInstance>(&CameraInstance::StopExposureSequence))
+      .def("ClearExposureSequence",
+           clearSequenceCall<CameraInstance>(&CameraInstance::ClearExposureSequence))
+      .def("AddToExposureSequence",
+           addToSequenceCall<CameraInstance>(&CameraInstance::AddToExposureSequence))
+      .def(
+          "AddToExposureSequence",
+          [](CameraInstance &self, const DoubleArray &exposures) {
+            const double *data = sequenceValues(exposures, "exposures");
+            return addToSequence(
+                self, exposures.size(),
+                [&](long &max) { return self.GetExposureSequenceMaxLength(max); },
+                [&](size_t i) { return self.AddToExposureSequence(data[i]); });
+          },
+          "exposures"_a,
+          "Add every exposure time (ms) in a 1-D float64 array in one call; returns the "
+          "time taken, in ms.\n\n"
+          "Raises SequenceError if the points, together with those queued since the last "
+          "ClearExposureSequence, exceed GetExposureSequenceMaxLength or the camera rejects "
+          "one.")
+      .def("SendExposureSequence",
+           util::deviceCall<CameraInstance>(&CameraInstance::SendExposureSequence))
+
+      .def("GetImageBuffer",
+           util::deviceCall<CameraInstance>(
+               static_cast<const unsigned char *(CameraInstance::*)()>(
+                   &CameraInstance::GetImageBuffer)))
+      .def("GetImageBuffer",
+           util::deviceCall<CameraInstance>(
+               static_cast<const unsigned char *(CameraInstance::*)(unsigned)>(
+                   &CameraInstance::GetImageBuffer)))
+      .def("SnapInto", &snapInto, "out"_a, "n"_a = -1,
+           "Snap n frames into the preallocated (N, height, width) array `out`.\n\n"
+           "The snap loop runs in C++ without the GIL, writing each frame straight into "
+           "out[i].  n defaults to out.shape[0].  Returns a float64 array with the time each "
+           "frame was read out, in milliseconds since the call started.")
+      .def("GetImageChannels", &getImageChannels,
+           "Return all channels of the last snapped image in one contiguous array.\n\n"
+           "Grayscale cameras give a (channels, height, width) array.  RGB32 cameras give a "
+           "(height, width, 4) uint8 array in RGBA order, or (channels, height, width, 4) if "
+           "the camera has more than one channel.")
       .def(
           "GetImageArray",
-          [](CameraInstance &self, unsigned arg) {
-            return util::bufferToNumpy(self.GetImageBuffer(arg), self.GetImageHeight(),
-                                       self.GetImageWidth(), self.GetImageBytesPerPixel());
+          [](CameraInstance &self, unsigned arg, bool copy) {
+            const unsigned char *buffer;
+            unsigned height, width, bytesPerPixel;
+            {
+              util::DeviceCallGuard guard(self);
+              buffer = self.GetImageBuffer(arg);
+              height = self.GetImageHeight();
+              width = self.GetImageWidth();
+              bytesPerPixel = self.GetImageBytesPerPixel();
+            }
+            py::object owner;
+            if (!copy) {
+              if (buffer == nullptr)
+                throw std::runtime_error("No image in the camera buffer; call SnapImage first");
+              // tie the view to the python CameraInstance, which keeps the device alive
+              owner = py::cast(&self, py::return_value_policy::reference);
+            }
+            return util::bufferToNumpy(buffer, height, width, bytesPerPixel, owner);
           },
-          "arg"_a = 0);
+          "arg"_a = 0, "copy"_a = true,
+          "Return the last snapped image as a numpy array.\n\n"
+          "With copy=False, no bytes are copied: the array is a read-only view onto the "
+          "adapter's image buffer.  The view is only valid until the next SnapImage (which "
+          "overwrites the buffer in place) and must not be used after the camera is shut "
+          "down or unloaded.  Use copy=True (the default) for an independent array.");
 
   /////////////////////// ShutterInstance ///////////////////////
 
   bindDeviceInstance<ShutterInstance>(m, "ShutterInstance")
-      .def("SetOpen", &ShutterInstance::SetOpen, "open"_a)
+      .def("SetOpen", util::deviceCall<ShutterInstance>(&ShutterInstance::SetOpen), "open"_a)
       .def("GetOpen",
            [](ShutterInstance &self) {
+             util::DeviceCallGuard guard(self);
              bool open;
              self.GetOpen(open);
              return open;
            })
-      .def("Fire", &ShutterInstance::Fire, "deltaT"_a);
+      .def("Fire", util::deviceCall<ShutterInstance>(&ShutterInstance::Fire), "deltaT"_a);
 
   /////////////////////// StageInstance ///////////////////////
 
   bindDeviceInstance<StageInstance>(m, "StageInstance")
-      .def("SetPositionUm", &StageInstance::SetPositionUm, "pos"_a)
-      .def("SetRelativePositionUm", &StageInstance::SetRelativePositionUm, "d"_a)
-      .def("Move", &StageInstance::Move, "velocity"_a)
-      .def("Stop", &StageInstance::Stop)
-      .def("Home", &StageInstance::Home)
-      .def("SetAdapterOriginUm", &StageInstance::SetAdapterOriginUm, "d"_a)
+      .def("SetPositionUm", util::deviceCall<StageInstance>(&StageInstance::SetPositionUm),
+           "pos"_a,
+           "Move the stage to `pos` um.\n\n"
+           "The command is sent with the GIL released, so a slow stage doesn't stall other "
+           "threads; only devices from the stage's own adapter library wait for it.")
+      .def("SetRelativePositionUm",
+           util::deviceCall<StageInstance>(&StageInstance::SetRelativePositionUm), "d"_a)
+      .def("Move", util::deviceCall<StageInstance>(&StageInstance::Move), "velocity"_a)
+      .def("Stop", util::deviceCall<StageInstance>(&StageInstance::Stop))
+      .def("Home", util::deviceCall<StageInstance>(&StageInstance::Home))
+      .def("SetAdapterOriginUm",
+           util::deviceCall<StageInstance>(&StageInstance::SetAdapterOriginUm), "d"_a)
       .def("GetPositionUm",
            [](StageInstance &self) {
+             util::DeviceCallGuard guard(self);
              double pos;
              self.GetPositionUm(pos);
              return pos;
            })
-      .def("SetPositionSteps", &StageInstance::SetPositionSteps, "steps"_a)
+      .def("SetPositionSteps", util::deviceCall<StageInstance>(&StageInstance::SetPositionSteps),
+           "steps"_a)
       .def("GetPositionSteps",
            [](StageInstance &self) {
+             util::DeviceCallGuard guard(self);
              long steps;
              self.GetPositionSteps(steps);
              return steps;
            })
-      .def("SetOrigin", &StageInstance::SetOrigin)
+      .def("SetOrigin", util::deviceCall<StageInstance>(&StageInstance::SetOrigin))
       .def("GetLimits",
            [](StageInstance &self) {
+             util::DeviceCallGuard guard(self);
              double lower, upper;
              self.GetLimits(lower, upper);
              return std::make_pair(lower, upper);
            })
-      .def("GetFocusDirection", &StageInstance::GetFocusDirection)
-      .def("SetFocusDirection", &StageInstance::SetFocusDirection, "direction"_a)
+      .def("GetFocusDirection", util::deviceCall<StageInstance>(&StageInstance::GetFocusDirection))
+      .def("SetFocusDirection", util::deviceCall<StageInstance>(&StageInstance::SetFocusDirection),
+           "direction"_a)
       .def("IsStageSequenceable",
            [](StageInstance &self) {
+             util::DeviceCallGuard guard(self);
              bool isSequenceable;
              self.IsStageSequenceable(isSequenceable);
              return isSequenceable;
            })
       .def("IsStageLinearSequenceable",
            [](StageInstance &self) {
+             util::DeviceCallGuard guard(self);
              bool isSequenceable;
              self.IsStageLinearSequenceable(isSequenceable);
              return isSequenceable;
            })
-      .def("IsContinuousFocusDrive", &StageInstance::IsContinuousFocusDrive)
+      .def("IsContinuousFocusDrive",
+           util::deviceCall<StageInstance>(&StageInstance::IsContinuousFocusDrive))
       .def("GetStageSequenceMaxLength",
            [](StageInstance &self) {
+             util::DeviceCallGuard guard(self);
              long nrEvents;
              self.GetStageSequenceMaxLength(nrEvents);
              return nrEvents;
            })
-      .def("StartStageSequence", &StageInstance::StartStageSequence)
-      .def("StopStageSequence", &StageInstance::StopStageSequence)
-      .def("ClearStageSequence", &StageInstance::ClearStageSequence)
-      .def("AddToStageSequence", &StageInstance::AddToStageSequence, "position"_a)
-      .def("SendStageSequence", &StageInstance::SendStageSequence)
-      .def("SetStageLinearSequence", &StageInstance::SetStageLinearSequence, "dZ_um"_a,
+      .def("StartStageSequence",
+           util::deviceCall<StageInstance>(&StageInstance::StartStageSequence))
+      .def("StopStageSequence", util::deviceCall<StageInstance>(&StageInstance::StopStageSequence))
+      .def("ClearStageSequence",
+           clearSequenceCall<StageInstance>(&StageInstance::ClearStageSequence))
+      .def("AddToStageSequence",
+           addToSequenceCall<StageInstance>(&StageInstance::AddToStageSequence), "position"_a)
+      .def(
+          "AddToStageSequence",
+          [](StageInstance &self, const DoubleArray &positions) {
+            const double *data = sequenceValues(positions, "positions");
+            return addToSequence(
+                self, positions.size(),
+                [&](long &max) { return self.GetStageSequenceMaxLength(max); },
+                [&](size_t i) { return self.AddToStageSequence(data[i]); });
+          },
+          "positions"_a,
+          "Add every position (um) in a 1-D float64 array in one call; returns the time "
+          "taken, in ms.\n\n"
+          "Raises SequenceError if the points, together with those queued since the last "
+          "ClearStageSequence, exceed GetStageSequenceMaxLength or the stage rejects one.")
+      .def("SendStageSequence", util::deviceCall<StageInstance>(&StageInstance::SendStageSequence))
+      .def("SetStageLinearSequence",
+           util::deviceCall<StageInstance>(&StageInstance::SetStageLinearSequence), "dZ_um"_a,
            "nSlices"_a);
 
   /////////////////////// XYStageInstance ///////////////////////
 
   bindDeviceInstance<XYStageInstance>(m, "XYStageInstance")
-      .def("SetPositionUm", &XYStageInstance::SetPositionUm, "x"_a, "y"_a)
-      .def("SetRelativePositionUm", &XYStageInstance::SetRelativePositionUm, "dx"_a, "dy"_a)
-      .def("SetAdapterOriginUm", &XYStageInstance::SetAdapterOriginUm, "x"_a, "y"_a)
+      .def("SetPositionUm", util::deviceCall<XYStageInstance>(&XYStageInstance::SetPositionUm),
+           "x"_a, "y"_a,
+           "Move the stage to (x, y) um.\n\n"
+           "As for a Z stage, the GIL is released and the adapter library's lock held while "
+           "the command is sent.")
+      .def("SetRelativePositionUm",
+           util::deviceCall<XYStageInstance>(&XYStageInstance::SetRelativePositionUm), "dx"_a,
+           "dy"_a)
+      .def("SetAdapterOriginUm",
+           util::deviceCall<XYStageInstance>(&XYStageInstance::SetAdapterOriginUm), "x"_a, "y"_a)
       .def("GetPositionUm",
            [](XYStageInstance &self) {
+             util::DeviceCallGuard guard(self);
              double x, y;
              self.GetPositionUm(x, y);
              return std::make_pair(x, y);
            })
-      .def("SetPositionSteps", &XYStageInstance::SetPositionSteps, "x"_a, "y"_a)
+      .def("SetPositionSteps",
+           util::deviceCall<XYStageInstance>(&XYStageInstance::SetPositionSteps), "x"_a, "y"_a)
       .def("GetPositionSteps",
            [](XYStageInstance &self) {
+             util::DeviceCallGuard guard(self);
              long x, y;
              self.GetPositionSteps(x, y);
              return std::make_pair(x, y);
            })
-      .def("SetOrigin", &XYStageInstance::SetOrigin)
-      .def("GetStepSizeXUm", &XYStageInstance::GetStepSizeXUm)
-      .def("GetStepSizeYUm", &XYStageInstance::GetStepSizeYUm)
+      .def("SetOrigin", util::deviceCall<XYStageInstance>(&XYStageInstance::SetOrigin))
+      .def("GetStepSizeXUm", util::deviceCall<XYStageInstance>(&XYStageInstance::GetStepSizeXUm))
+      .def("GetStepSizeYUm", util::deviceCall<XYStageInstance>(&XYStageInstance::GetStepSizeYUm))
       .def("GetStepSize",  // NOT in the original class
            [](XYStageInstance &self) {
+             util::DeviceCallGuard guard(self);
              return std::make_pair(self.GetStepSizeXUm(), self.GetStepSizeYUm());
            })
       .def(
           "GetLimitsUm",
           [](XYStageInstance &self) {
+            util::DeviceCallGuard guard(self);
             double xMin, xMax, yMin, yMax;
             self.GetLimitsUm(xMin, xMax, yMin, yMax);
             return std::make_tuple(xMin, xMax, yMin, yMax);
@@ -696,50 +3850,94 @@ PYBIND11_MODULE(_pymmdevice, m) {
           "Return limits of the XY stage in um (xMin, xMax, yMin, yMax)")
       .def("IsXYStageSequenceable",
            [](XYStageInstance &self) {
+             util::DeviceCallGuard guard(self);
              bool isSequenceable;
              self.IsXYStageSequenceable(isSequenceable);
              return isSequenceable;
            })
       .def("GetXYStageSequenceMaxLength",
            [](XYStageInstance &self) {
+             util::DeviceCallGuard guard(self);
              long nrEvents;
              self.GetXYStageSequenceMaxLength(nrEvents);
              return nrEvents;
            })
-      .def("StartXYStageSequence", &XYStageInstance::StartXYStageSequence)
-      .def("StopXYStageSequence", &XYStageInstance::StopXYStageSequence)
-      .def("ClearXYStageSequence", &XYStageInstance::ClearXYStageSequence)
-      .def("AddToXYStageSequence", &XYStageInstance::AddToXYStageSequence, "positionX"_a,
-           "positionY"_a)
-      .def("SendXYStageSequence", &XYStageInstance::SendXYStageSequence);
+      .def("StartXYStageSequence",
+           util::deviceCall<XYStageInstance>(&XYStageInstance::StartXYStageSequence))
+      .def("StopXYStageSequence",
+           util::deviceCall<XYStageInstance>(&XYStageInstance::StopXYStageSequence))
+      .def("ClearXYStageSequence",
+           clearSequenceCall<XYStageInstance>(&XYStageInstance::ClearXYStageSequence))
+      .def("AddToXYStageSequence",
+           addToSequenceCall<XYStageInstance>(&XYStageInstance::AddToXYStageSequence),
+           "positionX"_a, "positionY"_a)
+      .def(
+          "AddToXYStageSequence",
+          [](XYStageInstance &self, const DoubleArray &positions) {
+            if (positions.ndim() != 2 || positions.shape(1) != 2)
+              throw py::value_error("positions must be an (N, 2) array of x, y pairs");
+            const double *data = positions.data();
+            return addToSequence(
+                self, static_cast<size_t>(positions.shape(0)),
+                [&](long &max) { return self.GetXYStageSequenceMaxLength(max); },
+                [&](size_t i) {
+                  return self.AddToXYStageSequence(data[2 * i], data[2 * i + 1]);
+                });
+          },
+          "positions"_a,
+          "Add every (x, y) position (um) in an (N, 2) float64 array in one call; returns the "
+          "time taken, in ms.\n\n"
+          "Raises SequenceError if the points, together with those queued since the last "
+          "ClearXYStageSequence, exceed GetXYStageSequenceMaxLength or the stage rejects one.")
+      .def("SendXYStageSequence",
+           util::deviceCall<XYStageInstance>(&XYStageInstance::SendXYStageSequence));
 
   /////////////////////// StateInstance ///////////////////////
 
   bindDeviceInstance<StateInstance>(m, "StateInstance")
-      .def("SetPosition", py::overload_cast<long>(&StateInstance::SetPosition), "pos"_a)
-      .def("SetPosition", py::overload_cast<const char *>(&StateInstance::SetPosition), "label"_a)
+      .def("SetPosition",
+           util::deviceCall<StateInstance>(py::overload_cast<long>(&StateInstance::SetPosition)),
+           "pos"_a)
+      .def("SetPosition",
+           util::deviceCall<StateInstance>(
+               py::overload_cast<const char *>(&StateInstance::SetPosition)),
+           "label"_a)
       .def("GetPosition",
            [](StateInstance &self) {
+             util::DeviceCallGuard guard(self);
              long pos;
              self.GetPosition(pos);
              return pos;
            })
-      .def("GetPositionLabel", [](const StateInstance &self) { return self.GetPositionLabel(); })
+      .def("GetPositionLabel",
+           [](const StateInstance &self) {
+             util::DeviceCallGuard guard(self);
+             return self.GetPositionLabel();
+           })
       .def(
           "GetPositionLabel",
-          [](const StateInstance &self, long pos) { return self.GetPositionLabel(pos); }, "pos"_a)
+          [](const StateInstance &self, long pos) {
+            util::DeviceCallGuard guard(self);
+            return self.GetPositionLabel(pos);
+          },
+          "pos"_a)
       .def(
           "GetLabelPosition",
           [](StateInstance &self, const char *label) {
+            util::DeviceCallGuard guard(self);
             long pos;
             self.GetLabelPosition(label, pos);
             return pos;
           },
           "label"_a)
-      .def("SetPositionLabel", &StateInstance::SetPositionLabel, "pos"_a, "label"_a)
-      .def("GetNumberOfPositions", &StateInstance::GetNumberOfPositions)
-      .def("SetGateOpen", &StateInstance::SetGateOpen, "open"_a = true)
+      .def("SetPositionLabel", util::deviceCall<StateInstance>(&StateInstance::SetPositionLabel),
+           "pos"_a, "label"_a)
+      .def("GetNumberOfPositions",
+           util::deviceCall<StateInstance>(&StateInstance::GetNumberOfPositions))
+      .def("SetGateOpen", util::deviceCall<StateInstance>(&StateInstance::SetGateOpen),
+           "open"_a = true)
       .def("GetGateOpen", [](StateInstance &self) {
+        util::DeviceCallGuard guard(self);
         bool open;
         self.GetGateOpen(open);
         return open;
@@ -748,53 +3946,239 @@ PYBIND11_MODULE(_pymmdevice, m) {
   /////////////////////// SerialInstance ///////////////////////
 
   bindDeviceInstance<SerialInstance>(m, "SerialInstance")
-      .def("GetPortType", &SerialInstance::GetPortType)
-      .def("SetCommand", &SerialInstance::SetCommand, "command"_a, "term"_a)
+      .def("GetPortType", util::deviceCall<SerialInstance>(&SerialInstance::GetPortType))
+      .def(
+          "SetCommand",
+          [](SerialInstance &self, const std::string &command, const std::string &term) {
+            util::DeviceCallGuard guard(self);
+            int ret = self.SetCommand(command.c_str(), term.c_str());
+            if (ret == DEVICE_OK) {
+              const std::string sent = command + term;
+              recordSerialTraffic(self.GetLabel(), SerialEvent::Write,
+                                  reinterpret_cast<const unsigned char *>(sent.data()),
+                                  sent.size());
+            }
+            return ret;
+          },
+          "command"_a, "term"_a)
       // logic borrowed from MMCore.cpp
       .def(
           "GetAnswer",
-          [](SerialInstance &self, const std::string &term) {
+          [](SerialInstance &self, const std::string &term, unsigned maxChars) {
             if (term.empty())
               throw py::value_error("Null or empty terminator; cannot delimit received message");
-
-            const int bufLen = 1024;
-            char answerBuf[bufLen];
-            int ret = self.GetAnswer(answerBuf, bufLen, term.c_str());
-            if (ret != DEVICE_OK) {
-              std::string errMsg = getErrorMessage(&self, ret);
-              throw std::runtime_error(errMsg);
-            }
-            return std::string(answerBuf);
+            std::string answer;
+            util::DeviceCallGuard guard(self);
+            checkDeviceError(self, getSerialAnswer(self, term.c_str(), maxChars, answer));
+            return answer;
           },
-          "term"_a)
+          "term"_a, "maxChars"_a = 1024,
+          "Return the next answer, up to `term`, waiting as long as the port's AnswerTimeout.\n\n"
+          "Bytes already buffered by Read or Transact come first, so the calls can be mixed.")
       .def(
           "Write",
           [](SerialInstance &self, const std::string &data) {
-            int ret =
-                self.Write(reinterpret_cast<const unsigned char *>(data.data()), data.size());
-            if (ret != DEVICE_OK) {
-              std::string errMsg = getErrorMessage(&self, ret);
-              throw std::runtime_error(errMsg);
-            }
+            util::DeviceCallGuard guard(self);
+            int ret = writeSerial(self, reinterpret_cast<const unsigned char *>(data.data()),
+                                  data.size());
+            checkDeviceError(self, ret);
             return ret;
           },
           "data"_a)
-      .def("Read",
-           [](SerialInstance &self) {
-             const int bufLen = 1024;
-             unsigned char answerBuf[bufLen];
-             unsigned long charsRead;
-             int ret = self.Read(answerBuf, bufLen, charsRead);
-             if (ret != DEVICE_OK) {
-               std::string errMsg = getErrorMessage(&self, ret);
-               throw std::runtime_error(errMsg);
-             }
-             std::vector<char> data;
-             data.resize(charsRead, 0);
-             if (charsRead > 0) std::memcpy(&(data[0]), answerBuf, charsRead);
-             return data;
-           })
-      .def("Purge", &SerialInstance::Purge);
+      .def(
+          "Write",
+          [](SerialInstance &self, py::buffer data) {
+            py::buffer_info info = data.request();
+            if (!isContiguousBuffer(info)) throw py::value_error("data must be contiguous");
+            util::DeviceCallGuard guard(self);
+            int ret = writeSerial(self, static_cast<const unsigned char *>(info.ptr),
+                                  static_cast<size_t>(info.size * info.itemsize));
+            checkDeviceError(self, ret);
+            return ret;
+          },
+          "data"_a, "Write the raw bytes of any contiguous buffer.")
+      .def(
+          "Read",
+          [](SerialInstance &self, size_t maxBytes) {
+            std::string data(maxBytes, '\0');
+            size_t count = readSerial(self, reinterpret_cast<unsigned char *>(&data[0]), maxBytes);
+            data.resize(count);
+            return py::bytes(data);
+          },
+          "maxBytes"_a = 4096, "Read up to maxBytes bytes that have arrived, without waiting.")
+      .def(
+          "ReadInto",
+          [](SerialInstance &self, py::buffer buffer) {
+            py::buffer_info info = buffer.request(true);
+            if (!isContiguousBuffer(info)) throw py::value_error("buffer must be contiguous");
+            return readSerial(self, static_cast<unsigned char *>(info.ptr),
+                              static_cast<size_t>(info.size * info.itemsize));
+          },
+          "buffer"_a,
+          "Read as many bytes as have arrived into a writable buffer, up to its size, without "
+          "waiting.  Returns the number of bytes read.")
+      .def(
+          "Transact",
+          [](SerialInstance &self, const std::string &command, const std::string &term,
+             double timeout, py::object answerTerm) {
+            std::vector<std::string> answers =
+                transactSerial(self, {command}, term, answerTerm, timeout, 1);
+            return py::bytes(answers[0]);
+          },
+          "command"_a, "term"_a, "timeout"_a = 1.0, "answerTerm"_a = py::none(),
+          "Send command + term and return the answer, up to its terminator, in one call "
+          "without the GIL.\n\n"
+          "The answer ends at answerTerm (term if None).  Raises TimeoutError if it doesn't "
+          "arrive within timeout seconds, after purging the port.")
+      .def(
+          "TransactMany",
+          [](SerialInstance &self, const std::vector<std::string> &commands,
+             const std::string &term, double timeout, py::object answerTerm, size_t window) {
+            py::list answers;
+            for (const std::string &answer :
+                 transactSerial(self, commands, term, answerTerm, timeout, window))
+              answers.append(py::bytes(answer));
+            return answers;
+          },
+          "commands"_a, "term"_a, "timeout"_a = 1.0, "answerTerm"_a = py::none(),
+          "window"_a = 0,
+          "Pipeline several commands: keep up to `window` of them (0: all) in flight and "
+          "collect their answers in order.\n\n"
+          "Otherwise like Transact; the timeout applies to each answer.")
+      .def(
+          "Purge",
+          [](SerialInstance &self) {
+            util::DeviceCallGuard guard(self);
+            std::shared_ptr<SerialStream> stream = serialStreams().Find(self.GetRawPtr());
+            if (stream) stream->Clear();
+            int ret = self.Purge();
+            if (ret == DEVICE_OK)
+              recordSerialTraffic(self.GetLabel(), SerialEvent::Purge, nullptr, 0);
+            return ret;
+          },
+          "Discard everything received but not yet read.");
+
+  py::class_<SerialRecorder, std::shared_ptr<SerialRecorder>>(
+      m, "SerialRecorder",
+      "Records the timestamped traffic of serial ports, in both directions, to a file that "
+      "SerialReplay can play back.")
+      .def(py::init<const std::string &>(), "path"_a)
+      .def("__enter__", [](std::shared_ptr<SerialRecorder> self) { return self; })
+      .def("__exit__",
+           [](std::shared_ptr<SerialRecorder> self, py::args) { closeSerialRecorder(self); })
+      .def(
+          "AddPort",
+          [](std::shared_ptr<SerialRecorder> self, const std::string &port) {
+            if (!self->IsOpen()) throw std::runtime_error("The recorder is closed");
+            self->AddPort(port);
+            serialRecorders().Attach(port, self);
+          },
+          "port"_a,
+          "Record the port with this label, whether it is used through a SerialInstance or by "
+          "adapters.")
+      .def(
+          "RemovePort",
+          [](std::shared_ptr<SerialRecorder> self, const std::string &port) {
+            if (serialRecorders().Find(port) == self) serialRecorders().Detach(port);
+            self->RemovePort(port);
+          },
+          "port"_a)
+      .def("GetPortNames", &SerialRecorder::GetPortNames)
+      .def("GetEventCount", &SerialRecorder::GetEventCount)
+      .def("GetByteCount", &SerialRecorder::GetByteCount,
+           "Number of data bytes recorded, in both directions.")
+      .def("IsOpen", &SerialRecorder::IsOpen)
+      .def("Close", &closeSerialRecorder, "Stop recording its ports and close the file.");
+
+  py::class_<SerialReplay, std::shared_ptr<SerialReplay>>(
+      m, "SerialReplay",
+      "Plays a SerialRecorder file back in place of the hardware.\n\n"
+      "Each recorded port expects the writes and purges it recorded, in order, and answers with "
+      "what it recorded reading, after the recorded delay times `time_scale` (0: at once).  "
+      "Writes that depart from the recording count as mismatches, and are refused if `strict`.")
+      .def(py::init([](const std::string &path, double timeScale, bool strict,
+                       double answerTimeout) {
+             return std::make_shared<SerialReplay>(path, timeScale, strict,
+                                                   answerTimeout * 1000.0);
+           }),
+           "path"_a, "time_scale"_a = 1.0, "strict"_a = false, "answer_timeout"_a = 5.0)
+      .def("__enter__",
+           [](std::shared_ptr<SerialReplay> self) {
+             attachSerialReplay(self, self->GetPortNames());
+             return self;
+           })
+      .def("__exit__",
+           [](std::shared_ptr<SerialReplay> self, py::args) { detachSerialReplay(self); })
+      .def(
+          "Attach",
+          [](std::shared_ptr<SerialReplay> self, py::object ports) {
+            attachSerialReplay(self, ports.is_none()
+                                         ? self->GetPortNames()
+                                         : ports.cast<std::vector<std::string>>());
+          },
+          "ports"_a = py::none(),
+          "Serve adapters' I/O on these ports (all recorded ones if None) from the recording.")
+      .def("Detach", &detachSerialReplay, "Hand the ports back to the hardware.")
+      .def("GetPortNames", &SerialReplay::GetPortNames)
+      .def("Rewind", &SerialReplay::Rewind, "Start over from the beginning of the recording.")
+      .def("IsFinished", &SerialReplay::IsFinished,
+           "Whether every recorded event has been replayed.")
+      .def("GetMismatchCount", &SerialReplay::GetMismatchCount)
+      .def("GetLastMismatch", &SerialReplay::GetLastMismatch)
+      .def(
+          "Write",
+          [](SerialReplay &self, const std::string &port, const std::string &data) {
+            checkReplayCall(self,
+                            self.Write(port, reinterpret_cast<const unsigned char *>(data.data()),
+                                       static_cast<unsigned long>(data.size())),
+                            port);
+          },
+          "port"_a, "data"_a,
+          "Write to the port as the host would.\n\n"
+          "Raises RuntimeError for a port that isn't in the recording, and, if strict, for data "
+          "that departs from it.")
+      .def(
+          "Read",
+          [](SerialReplay &self, const std::string &port, size_t maxBytes) {
+            std::string data(maxBytes, '\0');
+            unsigned long count = 0;
+            int ret = self.Read(port, reinterpret_cast<unsigned char *>(&data[0]),
+                                static_cast<unsigned long>(maxBytes), count);
+            if (ret == DEVICE_OK && count == 0 && maxBytes > 0 && !self.HasReadsLeft(port))
+              ret = DEVICE_SERIAL_TIMEOUT;
+            checkReplayCall(self, ret, port,
+                            "Nothing left to read on replayed port " + ToQuotedString(port));
+            data.resize(count);
+            return py::bytes(data);
+          },
+          "port"_a, "max_bytes"_a = 4096,
+          "Read the recorded bytes that are due, up to max_bytes, without waiting.\n\n"
+          "Returns b'' if the next ones aren't due yet.  Raises TimeoutError once the port has "
+          "nothing left to read, and RuntimeError for a port that isn't in the recording.")
+      .def(
+          "GetAnswer",
+          [](SerialReplay &self, const std::string &port, const std::string &term) {
+            if (term.empty())
+              throw py::value_error("Null or empty terminator; cannot delimit received message");
+            std::string answer;
+            int ret;
+            {
+              py::gil_scoped_release release;
+              ret = self.GetAnswer(port, term, self.GetAnswerTimeoutMs(), answer);
+            }
+            checkReplayCall(self, ret, port, "No answer on replayed port " + ToQuotedString(port));
+            return answer;
+          },
+          "port"_a, "term"_a)
+      .def(
+          "Purge",
+          [](SerialReplay &self, const std::string &port) {
+            checkReplayCall(self, self.Purge(port), port);
+          },
+          "port"_a,
+          "Purge the port as the host would.\n\n"
+          "Raises RuntimeError for a port that isn't in the recording, and, if strict, for a "
+          "purge the recording doesn't have next.");
 
   /////////////////////// GenericInstance ///////////////////////
 
@@ -804,173 +4188,268 @@ PYBIND11_MODULE(_pymmdevice, m) {
   /////////////////////// AutoFocusInstance ///////////////////////
 
   bindDeviceInstance<AutoFocusInstance>(m, "AutoFocusInstance")
-      .def("SetContinuousFocusing", &AutoFocusInstance::SetContinuousFocusing, "state"_a)
+      .def("SetContinuousFocusing",
+           util::deviceCall<AutoFocusInstance>(&AutoFocusInstance::SetContinuousFocusing),
+           "state"_a)
       .def("GetContinuousFocusing",
            [](AutoFocusInstance &self) {
+             util::DeviceCallGuard guard(self);
              bool state;
              self.GetContinuousFocusing(state);
              return state;
            })
-      .def("IsContinuousFocusLocked", &AutoFocusInstance::IsContinuousFocusLocked)
-      .def("FullFocus", &AutoFocusInstance::FullFocus)
-      .def("IncrementalFocus", &AutoFocusInstance::IncrementalFocus)
+      .def("IsContinuousFocusLocked",
+           util::deviceCall<AutoFocusInstance>(&AutoFocusInstance::IsContinuousFocusLocked))
+      .def("FullFocus", util::deviceCall<AutoFocusInstance>(&AutoFocusInstance::FullFocus),
+           "Run a full focus search.\n\n"
+           "The search runs without the GIL; devices of the same adapter library, which the "
+           "autofocus may drive itself, are locked out until it returns.")
+      .def("IncrementalFocus",
+           util::deviceCall<AutoFocusInstance>(&AutoFocusInstance::IncrementalFocus))
       .def("GetLastFocusScore",
            [](AutoFocusInstance &self) {
+             util::DeviceCallGuard guard(self);
              double score;
              self.GetLastFocusScore(score);
              return score;
            })
       .def("GetCurrentFocusScore",
            [](AutoFocusInstance &self) {
+             util::DeviceCallGuard guard(self);
              double score;
              self.GetCurrentFocusScore(score);
              return score;
            })
-      .def("AutoSetParameters", &AutoFocusInstance::AutoSetParameters)
+      .def("AutoSetParameters",
+           util::deviceCall<AutoFocusInstance>(&AutoFocusInstance::AutoSetParameters))
       .def("GetOffset",
            [](AutoFocusInstance &self) {
+             util::DeviceCallGuard guard(self);
              double offset;
              self.GetOffset(offset);
              return offset;
            })
-      .def("SetOffset", &AutoFocusInstance::SetOffset, "offset"_a);
+      .def("SetOffset", util::deviceCall<AutoFocusInstance>(&AutoFocusInstance::SetOffset),
+           "offset"_a);
 
   /////////////////////// ImageProcessorInstance ///////////////////////
 
   bindDeviceInstance<ImageProcessorInstance>(m, "ImageProcessorInstance")
       .def(
           "Process",
-          [](ImageProcessorInstance &self, unsigned char *buffer, int width, int height,
-             int byteDepth) {
-            PyErr_SetString(PyExc_NotImplementedError,
-                            "ImageProcessorInstance.Process is not implemented yet.");
-            throw py::error_already_set();
+          [](ImageProcessorInstance &self, py::array frame) {
+            // (height, width) pixels, or (height, width, 4) bytes for RGB32
+            const bool rgb = frame.ndim() == 3 && frame.shape(2) == 4 && frame.itemsize() == 1;
+            if (frame.ndim() != 2 && !rgb)
+              throw py::value_error("frame must be a (height, width) or (height, width, 4) array");
+            if (!(frame.flags() & py::array::c_style))
+              throw py::value_error("frame must be C-contiguous");
+            if (!frame.writeable()) throw py::value_error("frame must be writeable");
+            auto *pixels = static_cast<unsigned char *>(frame.mutable_data());
+            const auto height = static_cast<unsigned>(frame.shape(0));
+            const auto width = static_cast<unsigned>(frame.shape(1));
+            const auto byteDepth = static_cast<unsigned>(rgb ? 4 : frame.itemsize());
+            util::DeviceCallGuard guard(self);
+            checkDeviceError(self, self.Process(pixels, width, height, byteDepth));
           },
-          "buffer"_a, "width"_a, "height"_a, "byteDepth"_a);
+          "frame"_a,
+          "Run the processor on a frame in place, without copying it.\n\n"
+          "frame is a writeable, C-contiguous (height, width) array (or (height, width, 4) "
+          "uint8 for RGB32 images).");
 
   /////////////////////// SignalIOInstance ///////////////////////
 
   bindDeviceInstance<SignalIOInstance>(m, "SignalIOInstance")
-      .def("SetGateOpen", &SignalIOInstance::SetGateOpen, "open"_a = true)
+      .def("SetGateOpen", util::deviceCall<SignalIOInstance>(&SignalIOInstance::SetGateOpen),
+           "open"_a = true)
       .def("GetGateOpen",
            [](SignalIOInstance &self) {
+             util::DeviceCallGuard guard(self);
              bool open;
              self.GetGateOpen(open);
              return open;
            })
-      .def("SetSignal", &SignalIOInstance::SetSignal, "volts"_a)
+      .def("SetSignal", util::deviceCall<SignalIOInstance>(&SignalIOInstance::SetSignal),
+           "volts"_a)
       .def("GetSignal",
            [](SignalIOInstance &self) {
+             util::DeviceCallGuard guard(self);
              double volts;
              self.GetSignal(volts);
              return volts;
            })
       .def("GetLimits",
            [](SignalIOInstance &self) {
+             util::DeviceCallGuard guard(self);
              double minVolts, maxVolts;
              self.GetLimits(minVolts, maxVolts);
              return std::make_pair(minVolts, maxVolts);
            })
       .def("IsDASequenceable",
            [](SignalIOInstance &self) {
+             util::DeviceCallGuard guard(self);
              bool isSequenceable;
              self.IsDASequenceable(isSequenceable);
              return isSequenceable;
            })
       .def("GetDASequenceMaxLength",
            [](SignalIOInstance &self) {
+             util::DeviceCallGuard guard(self);
              long nrEvents;
              self.GetDASequenceMaxLength(nrEvents);
              return nrEvents;
            })
-      .def("StartDASequence", &SignalIOInstance::StartDASequence)
-      .def("StopDASequence", &SignalIOInstance::StopDASequence)
-      .def("ClearDASequence", &SignalIOInstance::ClearDASequence)
-      .def("AddToDASequence", &SignalIOInstance::AddToDASequence, "voltage"_a)
-      .def("SendDASequence", &SignalIOInstance::SendDASequence);
+      .def("StartDASequence",
+           util::deviceCall<SignalIOInstance>(&SignalIOInstance::StartDASequence))
+      .def("StopDASequence", util::deviceCall<SignalIOInstance>(&SignalIOInstance::StopDASequence))
+      .def("ClearDASequence",
+           clearSequenceCall<SignalIOInstance>(&SignalIOInstance::ClearDASequence))
+      .def("AddToDASequence",
+           addToSequenceCall<SignalIOInstance>(&SignalIOInstance::AddToDASequence), "voltage"_a)
+      .def(
+          "AddToDASequence",
+          [](SignalIOInstance &self, const DoubleArray &voltages) {
+            const double *data = sequenceValues(voltages, "voltages");
+            return addToSequence(
+                self, voltages.size(),
+                [&](long &max) { return self.GetDASequenceMaxLength(max); },
+                [&](size_t i) { return self.AddToDASequence(data[i]); });
+          },
+          "voltages"_a,
+          "Add every voltage in a 1-D float64 array in one call; returns the time taken, in "
+          "ms.\n\n"
+          "Raises SequenceError if the points, together with those queued since the last "
+          "ClearDASequence, exceed GetDASequenceMaxLength or the device rejects one.")
+      .def("SendDASequence",
+           util::deviceCall<SignalIOInstance>(&SignalIOInstance::SendDASequence));
 
   /////////////////////// MagnifierInstance ///////////////////////
 
   bindDeviceInstance<MagnifierInstance>(m, "MagnifierInstance")
-      .def("GetMagnification", &MagnifierInstance::GetMagnification);
+      .def("GetMagnification",
+           util::deviceCall<MagnifierInstance>(&MagnifierInstance::GetMagnification));
 
   /////////////////////// SLMInstance ///////////////////////
 
   bindDeviceInstance<SLMInstance>(m, "SLMInstance")
       .def(
           "SetImage",
-          [](SLMInstance &self, py::buffer b) {
-            PyErr_SetString(PyExc_NotImplementedError,
-                            "SLMInstance.SetImage is not implemented yet.");
-            throw py::error_already_set();
-          },
-          "pixels"_a)
-      .def("DisplayImage", &SLMInstance::DisplayImage)
-      .def("SetPixelsTo", py::overload_cast<unsigned char>(&SLMInstance::SetPixelsTo),
+          [](SLMInstance &self, py::buffer pixels) {
+            py::buffer_info info = pixels.request();
+            SLMImages images = checkSLMPixels(self, info, false);
+            util::DeviceCallGuard guard(self);
+            return setSLMImage(self, static_cast<unsigned char *>(info.ptr),
+                               images.bytesPerPixel);
+          },
+          "pixels"_a,
+          "Load an image onto the SLM, straight from any C-contiguous buffer.\n\n"
+          "pixels is (height, width) with GetBytesPerPixel()-sized items, e.g. uint8 or, for "
+          "RGB32 SLMs, uint32; RGB32 images may also be (height, width, 4) uint8.  Nothing is "
+          "copied on the way to the adapter.  Raises ValueError for an SLM that is neither "
+          "8-bit nor RGB32.")
+      .def("DisplayImage", util::deviceCall<SLMInstance>(&SLMInstance::DisplayImage))
+      .def("SetPixelsTo",
+           util::deviceCall<SLMInstance>(
+               py::overload_cast<unsigned char>(&SLMInstance::SetPixelsTo)),
            "intensity"_a)
       .def("SetPixelsTo",
-           py::overload_cast<unsigned char, unsigned char, unsigned char>(
-               &SLMInstance::SetPixelsTo),
+           util::deviceCall<SLMInstance>(
+               py::overload_cast<unsigned char, unsigned char, unsigned char>(
+                   &SLMInstance::SetPixelsTo)),
            "red"_a, "green"_a, "blue"_a)
-      .def("SetExposure", &SLMInstance::SetExposure, "interval_ms"_a)
-      .def("GetExposure", &SLMInstance::GetExposure)
-      .def("GetWidth", &SLMInstance::GetWidth)
-      .def("GetHeight", &SLMInstance::GetHeight)
-      .def("GetNumberOfComponents", &SLMInstance::GetNumberOfComponents)
-      .def("GetBytesPerPixel", &SLMInstance::GetBytesPerPixel)
+      .def("SetExposure", util::deviceCall<SLMInstance>(&SLMInstance::SetExposure),
+           "interval_ms"_a)
+      .def("GetExposure", util::deviceCall<SLMInstance>(&SLMInstance::GetExposure))
+      .def("GetWidth", util::deviceCall<SLMInstance>(&SLMInstance::GetWidth))
+      .def("GetHeight", util::deviceCall<SLMInstance>(&SLMInstance::GetHeight))
+      .def("GetNumberOfComponents",
+           util::deviceCall<SLMInstance>(&SLMInstance::GetNumberOfComponents))
+      .def("GetBytesPerPixel", util::deviceCall<SLMInstance>(&SLMInstance::GetBytesPerPixel))
       .def("IsSLMSequenceable",
            [](SLMInstance &self) {
+             util::DeviceCallGuard guard(self);
              bool isSequenceable;
              self.IsSLMSequenceable(isSequenceable);
              return isSequenceable;
            })
       .def("GetSLMSequenceMaxLength",
            [](SLMInstance &self) {
+             util::DeviceCallGuard guard(self);
              long nrEvents;
              self.GetSLMSequenceMaxLength(nrEvents);
              return nrEvents;
            })
-      .def("StartSLMSequence", &SLMInstance::StartSLMSequence)
-      .def("StopSLMSequence", &SLMInstance::StopSLMSequence)
-      .def("ClearSLMSequence", &SLMInstance::ClearSLMSequence)
+      .def("StartSLMSequence", util::deviceCall<SLMInstance>(&SLMInstance::StartSLMSequence))
+      .def("StopSLMSequence", util::deviceCall<SLMInstance>(&SLMInstance::StopSLMSequence))
+      .def("ClearSLMSequence", clearSequenceCall<SLMInstance>(&SLMInstance::ClearSLMSequence))
       .def(
           "AddToSLMSequence",
-          [](SLMInstance &self, py::buffer b) {
-            PyErr_SetString(PyExc_NotImplementedError,
-                            "SLMInstance.AddToSLMSequence is not implemented yet.");
-            throw py::error_already_set();
+          [](SLMInstance &self, py::buffer pixels) {
+            py::buffer_info info = pixels.request();
+            SLMImages images = checkSLMPixels(self, info, true);
+            const auto *data = static_cast<const unsigned char *>(info.ptr);
+            return addToSequence(
+                self, images.count, [&](long &max) { return self.GetSLMSequenceMaxLength(max); },
+                [&](size_t i) {
+                  return addToSLMSequence(self, data + i * images.imageBytes,
+                                          images.bytesPerPixel);
+                });
           },
-          "pixels"_a)
-      .def("SendSLMSequence", &SLMInstance::SendSLMSequence);
+          "pixels"_a,
+          "Add one image, or an (N, height, width[, 4]) stack of them, to the SLM sequence in "
+          "one call; returns the time taken, in ms.\n\n"
+          "Images are laid out as for SetImage and passed to the adapter without copying.  "
+          "Raises SequenceError if the images, together with those queued since the last "
+          "ClearSLMSequence, exceed GetSLMSequenceMaxLength or the SLM rejects one.")
+      .def("SendSLMSequence", util::deviceCall<SLMInstance>(&SLMInstance::SendSLMSequence));
 
   /////////////////////// GalvoInstance ///////////////////////
 
   bindDeviceInstance<GalvoInstance>(m, "GalvoInstance")
-      .def("PointAndFire", &GalvoInstance::PointAndFire, "x"_a, "y"_a, "time_us"_a)
-      .def("SetSpotInterval", &GalvoInstance::SetSpotInterval, "pulseInterval_us"_a)
-      .def("SetPosition", &GalvoInstance::SetPosition, "x"_a, "y"_a)
+      .def("PointAndFire", util::deviceCall<GalvoInstance>(&GalvoInstance::PointAndFire), "x"_a,
+           "y"_a, "time_us"_a)
+      .def("SetSpotInterval", util::deviceCall<GalvoInstance>(&GalvoInstance::SetSpotInterval),
+           "pulseInterval_us"_a)
+      .def("SetPosition", util::deviceCall<GalvoInstance>(&GalvoInstance::SetPosition), "x"_a,
+           "y"_a)
       .def("GetPosition",
            [](GalvoInstance &self) {
+             util::DeviceCallGuard guard(self);
              double x, y;
              self.GetPosition(x, y);
              return std::make_pair(x, y);
            })
-      .def("SetIlluminationState", &GalvoInstance::SetIlluminationState, "on"_a)
-      .def("GetXRange", &GalvoInstance::GetXRange)
-      .def("GetXMinimum", &GalvoInstance::GetXMinimum)
-      .def("GetYRange", &GalvoInstance::GetYRange)
-      .def("GetYMinimum", &GalvoInstance::GetYMinimum)
-      .def("AddPolygonVertex", &GalvoInstance::AddPolygonVertex, "polygonIndex"_a, "x"_a, "y"_a)
-      .def("DeletePolygons", &GalvoInstance::DeletePolygons)
-      .def("RunSequence", &GalvoInstance::RunSequence)
-      .def("LoadPolygons", &GalvoInstance::LoadPolygons)
-      .def("SetPolygonRepetitions", &GalvoInstance::SetPolygonRepetitions, "repetitions"_a)
-      .def("RunPolygons", &GalvoInstance::RunPolygons)
-      .def("StopSequence", &GalvoInstance::StopSequence)
-      .def("GetChannel", &GalvoInstance::GetChannel);
+      .def("SetIlluminationState",
+           util::deviceCall<GalvoInstance>(&GalvoInstance::SetIlluminationState), "on"_a)
+      .def("GetXRange", util::deviceCall<GalvoInstance>(&GalvoInstance::GetXRange))
+      .def("GetXMinimum", util::deviceCall<GalvoInstance>(&GalvoInstance::GetXMinimum))
+      .def("GetYRange", util::deviceCall<GalvoInstance>(&GalvoInstance::GetYRange))
+      .def("GetYMinimum", util::deviceCall<GalvoInstance>(&GalvoInstance::GetYMinimum))
+      .def("AddPolygonVertex", util::deviceCall<GalvoInstance>(&GalvoInstance::AddPolygonVertex),
+           "polygonIndex"_a, "x"_a, "y"_a)
+      .def("DeletePolygons", util::deviceCall<GalvoInstance>(&GalvoInstance::DeletePolygons))
+      .def("RunSequence", util::deviceCall<GalvoInstance>(&GalvoInstance::RunSequence))
+      .def("LoadPolygons", util::deviceCall<GalvoInstance>(&GalvoInstance::LoadPolygons))
+      .def("SetPolygonRepetitions",
+           util::deviceCall<GalvoInstance>(&GalvoInstance::SetPolygonRepetitions), "repetitions"_a)
+      .def("RunPolygons", util::deviceCall<GalvoInstance>(&GalvoInstance::RunPolygons))
+      .def("StopSequence", util::deviceCall<GalvoInstance>(&GalvoInstance::StopSequence))
+      .def("GetChannel", util::deviceCall<GalvoInstance>(&GalvoInstance::GetChannel))
+      .def("LoadPolygonsFromArray", &loadGalvoPolygons, "vertices"_a, "polygon_offsets"_a,
+           "Replace the galvo's polygons and load them onto the device in one call.\n\n"
+           "vertices is an (N, 2) array of x, y pairs; polygon i is made of the vertices from "
+           "polygon_offsets[i] up to polygon_offsets[i + 1] (or the last vertex).  Every vertex "
+           "is checked against the galvo's range before anything is sent.")
+      .def("PointAndFireSequence", &pointAndFireSequence, "points"_a, "dwell_us"_a,
+           "Point and fire at each (x, y) in the (N, 2) array `points`, for dwell_us[i] "
+           "microseconds each.\n\n"
+           "The loop runs in C++ without the GIL, after every point is checked against the "
+           "galvo's range.  Returns a float64 array with the time each spot was fired, in "
+           "milliseconds since the call started.");
 
   /////////////////////// HubInstance ///////////////////////
 
   bindDeviceInstance<HubInstance>(m, "HubInstance")
-      .def("GetInstalledPeripheralNames", &HubInstance::GetInstalledPeripheralNames);
+      .def("GetInstalledPeripheralNames",
+           util::deviceCall<HubInstance>(&HubInstance::GetInstalledPeripheralNames));
 }
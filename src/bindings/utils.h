@@ -1,40 +1,214 @@
+#pragma once
+
 #include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 
+#include <type_traits>
+
+#include "CallStats.h"
+#include "DeviceInstance.h"
+#include "DeviceThreads.h"
+#include "LoadableModules/LoadedDeviceAdapter.h"
+
 namespace py = pybind11;
 
 namespace util {
 
+/**
+ * Guards a call from Python into a device adapter.
+ *
+ * For its lifetime the guard releases the GIL and holds the lock of the device's adapter
+ * module (the same lock MMCore takes around device calls).  Releasing the GIL lets other
+ * Python threads run while the hardware responds; the module lock keeps two threads from
+ * entering the same, non-reentrant, adapter library at once.  The GIL is released *before*
+ * the module lock is taken, so waiting on a busy adapter never stalls other Python threads.
+ * Inside a timed call (see DeviceClass) it also reports its lock wait and hold times.
+ */
+class DeviceCallGuard {
+ public:
+  explicit DeviceCallGuard(const DeviceInstance &device)
+      : lock_(device.GetAdapterModule()->GetLock()) {
+    timing_.Locked();
+  }
+
+ private:
+  py::gil_scoped_release release_;  // must be declared (and so constructed) before lock_
+  CallScope::Guarded timing_;       // likewise, to time the wait for lock_
+  MMThreadGuard lock_;
+};
+
+/**
+ * Wraps a (possibly inherited) member function for binding on `DType`, so that it runs
+ * under a DeviceCallGuard.
+ *
+ * @param method The member function to call.
+ * @return A callable taking `DType &` followed by the method's arguments.
+ */
+template <typename DType, typename Ret, typename Class, typename... Args>
+auto deviceCall(Ret (Class::*method)(Args...)) {
+  return [method](DType &self, Args... args) -> Ret {
+    DeviceCallGuard guard(self);
+    return (self.*method)(std::forward<Args>(args)...);
+  };
+}
+
+template <typename DType, typename Ret, typename Class, typename... Args>
+auto deviceCall(Ret (Class::*method)(Args...) const) {
+  return [method](DType &self, Args... args) -> Ret {
+    DeviceCallGuard guard(self);
+    return (self.*method)(std::forward<Args>(args)...);
+  };
+}
+
+// The plain signature of a callable bound with def(), as a function pointer type.
+template <typename Func>
+struct CallSignature : CallSignature<decltype(&Func::operator())> {};
+
+template <typename Class, typename Ret, typename... Args>
+struct CallSignature<Ret (Class::*)(Args...) const> {
+  using type = Ret (*)(Args...);
+};
+
+template <typename Class, typename Ret, typename... Args>
+struct CallSignature<Ret (Class::*)(Args...)> {
+  using type = Ret (*)(Args...);
+};
+
+template <typename Ret, typename... Args>
+struct CallSignature<Ret (*)(Args...)> {
+  using type = Ret (*)(Args...);
+};
+
+inline const DeviceInstance *asDevice(const DeviceInstance &device, std::true_type) {
+  return &device;
+}
+
+template <typename T>
+const DeviceInstance *asDevice(const T &, std::false_type) {
+  return nullptr;
+}
+
+inline const DeviceInstance *calledDevice() { return nullptr; }
+
+// The device a bound method was called on: its first argument, if that is one.
+template <typename First, typename... Rest>
+const DeviceInstance *calledDevice(const First &first, const Rest &...) {
+  return asDevice(first, std::is_base_of<DeviceInstance, First>());
+}
+
+template <typename Func, typename Ret, typename... Args>
+auto timedCall(const char *name, Func f, Ret (*)(Args...)) {
+  return [name, f](Args... args) -> Ret {
+    std::shared_ptr<CallStats> stats;
+    if (CallProfile::AnyActive()) {
+      const DeviceInstance *device = calledDevice(args...);
+      if (device) stats = deviceCallStats().Find(device->GetRawPtr());
+    }
+    if (!stats) return f(std::forward<Args>(args)...);
+    CallScope scope(*stats, name);
+    return f(std::forward<Args>(args)...);
+  };
+}
+
+/**
+ * Wraps a callable for binding as method `name`, so that calls on a device with CallStats
+ * attached are timed into them.  Otherwise the wrapper costs one relaxed atomic load.
+ */
+template <typename Func,
+          std::enable_if_t<!std::is_member_function_pointer<std::decay_t<Func>>::value, int> = 0>
+auto timedCall(const char *name, Func &&f) {
+  using Callable = std::decay_t<Func>;
+  return timedCall(name, Callable(std::forward<Func>(f)),
+                   static_cast<typename CallSignature<Callable>::type>(nullptr));
+}
+
+// Member functions bound directly are accessors that never reach the adapter: left as is.
+template <typename Func,
+          std::enable_if_t<std::is_member_function_pointer<std::decay_t<Func>>::value, int> = 0>
+Func &&timedCall(const char *, Func &&f) {
+  return std::forward<Func>(f);
+}
+
+/**
+ * The py::class_ of a DeviceInstance type, whose def() binds every method through timedCall,
+ * so that DeviceManager.EnableCallStats covers each of them without further ado.
+ */
+template <typename DType>
+class DeviceClass : public py::class_<DType, std::shared_ptr<DType>> {
+ public:
+  using Base = py::class_<DType, std::shared_ptr<DType>>;
+  using Base::Base;
+
+  template <typename Func, typename... Extra>
+  DeviceClass &def(const char *name, Func &&f, const Extra &...extra) {
+    Base::def(name, timedCall(name, std::forward<Func>(f)), extra...);
+    return *this;
+  }
+};
+
+/**
+ * Returns the unsigned integer dtype for a pixel of `bytesPerPixel` bytes.
+ *
+ * @throws std::runtime_error if the bytes per pixel is unsupported.
+ */
+inline py::dtype pixelDtype(unsigned int bytesPerPixel) {
+  if (bytesPerPixel == 1) return py::dtype::of<uint8_t>();
+  if (bytesPerPixel == 2) return py::dtype::of<uint16_t>();
+  if (bytesPerPixel == 4) return py::dtype::of<uint32_t>();
+  if (bytesPerPixel == 8) return py::dtype::of<uint64_t>();
+  throw std::runtime_error("Unsupported bytes per pixel: " + std::to_string(bytesPerPixel));
+}
+
+/**
+ * Converts a rectangular window of a larger image to a NumPy array.
+ *
+ * Behaves like bufferToNumpy, except that consecutive rows of the window are `rowBytes`
+ * apart in `buffer` (the stride of the full image).  A copy is compact; a view (when `base`
+ * is given) is read-only and strided, so no pixels outside the window are touched.
+ *
+ * @param buffer Address of the window's first pixel.
+ * @param rowBytes The distance in bytes between the starts of two rows.
+ * @param height The height of the window.
+ * @param width The width of the window.
+ * @param bytesPerPixel The number of bytes per pixel.
+ * @param base Optional owner of `buffer`.  If set, the array wraps `buffer` without copying.
+ * @return The NumPy array representing the window.
+ */
+inline py::array regionToNumpy(const unsigned char *buffer, size_t rowBytes,
+                               unsigned int height, unsigned int width,
+                               unsigned int bytesPerPixel, py::handle base = py::handle()) {
+  py::dtype dtype = pixelDtype(bytesPerPixel);
+  std::vector<ssize_t> shape = {static_cast<ssize_t>(height), static_cast<ssize_t>(width)};
+  std::vector<ssize_t> strides = {static_cast<ssize_t>(rowBytes),
+                                  static_cast<ssize_t>(bytesPerPixel)};
+
+  if (!base) return py::array(dtype, shape, strides, buffer);
+
+  // The memory belongs to someone else (e.g. a device adapter); never let numpy write into it.
+  py::array view(dtype, shape, strides, buffer, base);
+  view.attr("setflags")(py::arg("write") = false);
+  return view;
+}
+
 /**
  * Converts a buffer to a NumPy array.
  *
+ * By default the buffer is copied into a new array.  If `base` is given, no copy is made:
+ * the returned array is a read-only view onto `buffer` that keeps `base` alive, so the
+ * caller is responsible for choosing a `base` that outlives the memory it points to.
+ *
  * @param buffer The buffer to convert.
  * @param height The height of the array.
  * @param width The width of the array.
  * @param bytesPerPixel The number of bytes per pixel.
+ * @param base Optional owner of `buffer`.  If set, the array wraps `buffer` without copying.
  * @return The NumPy array representing the buffer.
  * @throws std::runtime_error if the bytes per pixel is unsupported.
  */
 py::array bufferToNumpy(const unsigned char* buffer, unsigned int height, unsigned int width,
-                        unsigned int bytesPerPixel) {
-  py::dtype dtype;
-  if (bytesPerPixel == 1) {
-    dtype = py::dtype::of<uint8_t>();
-  } else if (bytesPerPixel == 2) {
-    dtype = py::dtype::of<uint16_t>();
-  } else if (bytesPerPixel == 4) {
-    dtype = py::dtype::of<uint32_t>();
-  } else if (bytesPerPixel == 8) {
-    dtype = py::dtype::of<uint64_t>();
-  } else {
-    throw std::runtime_error("Unsupported bytes per pixel: " + std::to_string(bytesPerPixel));
-  }
-  // Ensure shape and strides are explicitly defined as vectors
-  std::vector<ssize_t> shape = {static_cast<ssize_t>(height), static_cast<ssize_t>(width)};
-  std::vector<ssize_t> strides = {static_cast<ssize_t>(width * bytesPerPixel),
-                                  static_cast<ssize_t>(bytesPerPixel)};
-
-  return py::array(dtype, shape, strides, buffer);
+                        unsigned int bytesPerPixel, py::handle base = py::handle()) {
+  return regionToNumpy(buffer, static_cast<size_t>(width) * bytesPerPixel, height, width,
+                       bytesPerPixel, base);
 }
 
 /**
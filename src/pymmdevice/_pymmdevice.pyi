@@ -7,6 +7,7 @@ import typing_extensions
 
 __all__ = [
     "DEVICE_INTERFACE_VERSION",
+    "AdapterDiscovery",
     "AutoFocusInstance",
     "Callable",
     "CameraInstance",
@@ -16,12 +17,20 @@ __all__ = [
     "DeviceInstance",
     "DeviceManager",
     "DeviceType",
+    "EventStream",
+    "FlushLog",
     "FocusDirection",
+    "FocusMetric",
+    "FocusScore",
     "GalvoInstance",
     "GenericInstance",
+    "GetDroppedLogCount",
+    "GetLogLevel",
+    "HardwareSequence",
     "HubInstance",
     "ImageProcessorInstance",
     "LoadedDeviceAdapter",
+    "LogLevel",
     "Logger",
     "MMThreadLock",
     "MagnifierInstance",
@@ -31,21 +40,74 @@ __all__ = [
     "PropertyType",
     "PyCoreCallback",
     "SLMInstance",
+    "SequenceError",
     "SerialInstance",
+    "SerialRecorder",
+    "SerialReplay",
+    "SetLogFile",
+    "SetLogHandler",
+    "SetLogLevel",
     "ShutterInstance",
     "SignalIOInstance",
+    "SoftwareAutofocus",
     "StageInstance",
     "StateInstance",
+    "TileScan",
     "XYStageInstance",
 ]
 
+class AdapterDiscovery:
+    def Cancel(self) -> None:
+        """
+        Stop probing further libraries.  The scan completes once those in progress are done.
+        """
+    def GetAvailableDeviceAdapters(self) -> list[str]:
+        """
+        Names of the adapter libraries validated so far that loaded successfully.
+        """
+    def GetErrors(self) -> dict[str, str]:
+        """
+        Return {moduleName: error} for the adapter libraries that failed to load.
+        """
+    def GetProgress(self) -> tuple[int, int]:
+        """
+        Return (libraries validated, total libraries); the total is 0 until every search path has been listed.
+        """
+    def IsDone(self) -> bool: ...
+    def Wait(self, timeout: typing.Any = None) -> bool:
+        """
+        Wait up to `timeout` seconds (forever if None) for the scan to complete.
+
+        Returns whether it has completed.
+        """
+
 class AutoFocusInstance:
     def AddToPropertySequence(self, arg0: str, arg1: str) -> None: ...
     def AutoSetParameters(self) -> int: ...
-    def Busy(self) -> bool: ...
+    def Busy(self) -> bool:
+        """
+        Return whether the device is still carrying out a command.
+
+        Polled with the GIL released, under the adapter library's lock.
+        """
+    def ClearPropertyCache(self) -> None:
+        """
+        Drop all cached property values; the next reads go to the device.
+        """
     def ClearPropertySequence(self, arg0: str) -> None: ...
     def DetectDevice(self) -> DeviceDetectionStatus: ...
-    def FullFocus(self) -> int: ...
+    def EnablePropertyCache(self, enable: bool = True) -> None:
+        """
+        Serve GetProperty from a cache of last known values.
+
+        The cache is filled on Initialize (or now, if the device is already initialized), updated by the device's property-change notifications, and invalidated by SetProperty.  Properties the adapter changes without notifying are not refreshed; call ClearPropertyCache to force fresh reads.
+        """
+    def FullFocus(self) -> int:
+        """
+        Run a full focus search.
+
+        The search runs without the GIL; devices of the same adapter library, which the autofocus may drive itself, are locked out until it returns.
+        """
     def GetAdapterModule(self) -> LoadedDeviceAdapter: ...
     def GetContinuousFocusing(self) -> bool: ...
     def GetCurrentFocusScore(self) -> float: ...
@@ -59,6 +121,10 @@ class AutoFocusInstance:
     def GetOffset(self) -> float: ...
     def GetParentID(self) -> str: ...
     def GetProperty(self, arg0: str) -> str: ...
+    def GetPropertyCacheStats(self) -> dict:
+        """
+        Return the property cache's hit and miss counts and number of cached values.
+        """
     def GetPropertyInitStatus(self, arg0: str) -> bool: ...
     def GetPropertyLowerLimit(self, arg0: str) -> float: ...
     def GetPropertyNames(self) -> list[str]: ...
@@ -73,9 +139,15 @@ class AutoFocusInstance:
     def HasProperty(self, arg0: str) -> bool: ...
     def HasPropertyLimits(self, arg0: str) -> bool: ...
     def IncrementalFocus(self) -> int: ...
-    def Initialize(self) -> None: ...
+    def Initialize(self) -> None:
+        """
+        Initialize the device, refilling its property cache if one is enabled.
+
+        The GIL is released meanwhile; devices from the same adapter library wait for it.
+        """
     def IsContinuousFocusLocked(self) -> bool: ...
     def IsInitialized(self) -> bool: ...
+    def IsPropertyCacheEnabled(self) -> bool: ...
     def IsPropertySequenceable(self, arg0: str) -> bool: ...
     def LogMessage(self, arg0: str, arg1: bool) -> int: ...
     def SendPropertySequence(self, arg0: str) -> None: ...
@@ -111,13 +183,40 @@ class Callable:
 
 class CameraInstance:
     def AddTag(self, arg0: str, arg1: str, arg2: str) -> None: ...
+    @typing.overload
     def AddToExposureSequence(self, arg0: float) -> int: ...
+    @typing.overload
+    def AddToExposureSequence(self, exposures: numpy.ndarray[numpy.float64]) -> float:
+        """
+        Add every exposure time (ms) in a 1-D float64 array in one call; returns the time taken, in ms.
+
+        Raises SequenceError if the points, together with those queued since the last ClearExposureSequence, exceed GetExposureSequenceMaxLength or the camera rejects one.
+        """
     def AddToPropertySequence(self, arg0: str, arg1: str) -> None: ...
-    def Busy(self) -> bool: ...
+    def Busy(self) -> bool:
+        """
+        Return whether the device is still carrying out a command.
+
+        Polled with the GIL released, under the adapter library's lock.
+        """
     def ClearExposureSequence(self) -> int: ...
+    def ClearPropertyCache(self) -> None:
+        """
+        Drop all cached property values; the next reads go to the device.
+        """
     def ClearPropertySequence(self, arg0: str) -> None: ...
     def ClearROI(self) -> int: ...
+    def ClearSequenceBuffer(self) -> None:
+        """
+        Discard all frames waiting in the sequence buffer.
+        """
     def DetectDevice(self) -> DeviceDetectionStatus: ...
+    def EnablePropertyCache(self, enable: bool = True) -> None:
+        """
+        Serve GetProperty from a cache of last known values.
+
+        The cache is filled on Initialize (or now, if the device is already initialized), updated by the device's property-change notifications, and invalidated by SetProperty.  Properties the adapter changes without notifying are not refreshed; call ClearPropertyCache to force fresh reads.
+        """
     def GetAdapterModule(self) -> LoadedDeviceAdapter: ...
     def GetBinning(self) -> int: ...
     def GetBitDepth(self) -> int: ...
@@ -128,7 +227,12 @@ class CameraInstance:
     def GetErrorText(self, arg0: int) -> str: ...
     def GetExposure(self) -> float: ...
     def GetExposureSequenceMaxLength(self, arg0: int) -> int: ...
-    def GetImageArray(self, arg: int = 0) -> numpy.ndarray: ...
+    def GetImageArray(self, arg: int = 0, copy: bool = True) -> numpy.ndarray:
+        """
+        Return the last snapped image as a numpy array.
+
+        With copy=False, no bytes are copied: the array is a read-only view onto the adapter's image buffer.  The view is only valid until the next SnapImage (which overwrites the buffer in place) and must not be used after the camera is shut down or unloaded.  Use copy=True (the default) for an independent array.
+        """
     @typing.overload
     def GetImageBuffer(self) -> int: ...
     @typing.overload
@@ -136,13 +240,30 @@ class CameraInstance:
     def GetImageBufferAsRGB32(self) -> int: ...
     def GetImageBufferSize(self) -> int: ...
     def GetImageBytesPerPixel(self) -> int: ...
+    def GetImageChannels(self) -> numpy.ndarray:
+        """
+        Return all channels of the last snapped image in one contiguous array.
+
+        Grayscale cameras give a (channels, height, width) array.  RGB32 cameras give a (height, width, 4) uint8 array in RGBA order, or (channels, height, width, 4) if the camera has more than one channel.
+        """
     def GetImageHeight(self) -> int: ...
+    def GetImageProcessingStats(self) -> dict:
+        """
+        Return the number of frames processed, failed and dropped because the processing queue was full, and the last processing error.
+        """
     def GetImageWidth(self) -> int: ...
     def GetLabel(self) -> str: ...
-    def GetMultiROI(
-        self, arg0: int, arg1: int, arg2: int, arg3: int, arg4: int
-    ) -> int: ...
-    def GetMultiROICount(self, arg0: int) -> int: ...
+    def GetMultiROI(self) -> list[tuple[int, int, int, int]]:
+        """
+        Return the ROIs as a list of (x, y, width, height) tuples in sensor coordinates.
+        """
+    def GetMultiROIArrays(self, copy: bool = False) -> list:
+        """
+        Return the pixels of each ROI of the last snapped image as a list of arrays.
+
+        By default the arrays are read-only strided views into the camera's image buffer, with the same lifetime caveats as GetImageArray(copy=False); pass copy=True for independent arrays.  Without multi-ROI the list holds the whole image.
+        """
+    def GetMultiROICount(self) -> int: ...
     def GetName(self) -> str: ...
     def GetNumberOfChannels(self) -> int: ...
     def GetNumberOfComponents(self) -> int: ...
@@ -150,6 +271,10 @@ class CameraInstance:
     def GetParentID(self) -> str: ...
     def GetPixelSizeUm(self) -> float: ...
     def GetProperty(self, arg0: str) -> str: ...
+    def GetPropertyCacheStats(self) -> dict:
+        """
+        Return the property cache's hit and miss counts and number of cached values.
+        """
     def GetPropertyInitStatus(self, arg0: str) -> bool: ...
     def GetPropertyLowerLimit(self, arg0: str) -> float: ...
     def GetPropertyNames(self) -> list[str]: ...
@@ -160,18 +285,52 @@ class CameraInstance:
     def GetPropertyValueAt(self, arg0: str, arg1: int) -> str: ...
     def GetROI(self) -> tuple[int, int, int, int]: ...
     def GetRawPtr(self) -> Device: ...
+    def GetRemainingImageCount(self) -> int:
+        """
+        Number of frames waiting in the sequence buffer.
+        """
+    def GetSequenceBufferCapacity(self) -> int:
+        """
+        Number of frame slots in the sequence buffer.
+        """
+    def GetSequenceBufferOverflowCount(self) -> int:
+        """
+        Number of frames dropped because the sequence buffer was full.
+        """
     def GetTags(self) -> str: ...
     def GetType(self) -> DeviceType: ...
     def HasInitializationBeenAttempted(self) -> bool: ...
     def HasProperty(self, arg0: str) -> bool: ...
     def HasPropertyLimits(self, arg0: str) -> bool: ...
-    def Initialize(self) -> None: ...
+    def Initialize(self) -> None:
+        """
+        Initialize the device, refilling its property cache if one is enabled.
+
+        The GIL is released meanwhile; devices from the same adapter library wait for it.
+        """
+    def InitializeSequenceBuffer(self, capacity: int = 0) -> None:
+        """
+        Preallocate the sequence buffer for the current image size.
+
+        capacity is a number of frames; 0 sizes the buffer to about 250 MB.  StartSequenceAcquisition calls this automatically if the image size changed.
+        """
     def IsCapturing(self) -> bool: ...
     def IsExposureSequenceable(self, arg0: bool) -> int: ...
     def IsInitialized(self) -> bool: ...
     def IsMultiROISet(self) -> bool: ...
+    def IsPropertyCacheEnabled(self) -> bool: ...
     def IsPropertySequenceable(self, arg0: str) -> bool: ...
     def LogMessage(self, arg0: str, arg1: bool) -> int: ...
+    def PopNextImage(self) -> numpy.ndarray:
+        """
+        Remove the oldest frame from the sequence buffer and return it as a numpy array.
+        """
+    def PopNextImageROIs(self) -> list:
+        """
+        Remove the oldest frame from the sequence buffer and return one array per ROI.
+
+        If multi-ROI was set when the sequence started, only the ROI pixels were buffered.
+        """
     def PrepareSequenceAcquisition(self) -> int: ...
     def RemoveTag(self, arg0: str) -> None: ...
     def SendExposureSequence(self) -> int: ...
@@ -181,26 +340,51 @@ class CameraInstance:
     def SetDelayMs(self, arg0: float) -> None: ...
     def SetDescription(self, arg0: str) -> None: ...
     def SetExposure(self, arg0: float) -> None: ...
+    def SetImageProcessors(
+        self, processors: list[ImageProcessorInstance], queueFrames: int = 8
+    ) -> None:
+        """
+        Run these image processors, in order, on every frame of a sequence acquisition.
+
+        Frames are queued (up to queueFrames of them) and processed in place on a worker thread before they reach the sequence buffer, so processing overlaps with acquisition.  A frame a processor fails on is dropped.  An empty list detaches the processors; frames still queued are discarded.
+        """
     def SetMultiROI(
-        self, arg0: int, arg1: int, arg2: int, arg3: int, arg4: int
-    ) -> int: ...
+        self, xs: list[int], ys: list[int], widths: list[int], heights: list[int]
+    ) -> None: ...
     def SetParentID(self, arg0: str) -> None: ...
     def SetProperty(self, arg0: str, arg1: str) -> None: ...
     def SetROI(self, arg0: int, arg1: int, arg2: int, arg3: int) -> int: ...
     def Shutdown(self) -> None: ...
-    def SnapImage(self) -> int: ...
+    def SnapImage(self) -> int:
+        """
+        Expose and read out one image into the camera's buffer.
+
+        Other Python threads keep running during the exposure, and devices from other adapter libraries (a stage, say) can be driven meanwhile; devices from the camera's own library wait until the snap returns.
+        """
+    def SnapInto(self, out: numpy.ndarray, n: int = -1) -> numpy.ndarray[numpy.float64]:
+        """
+        Snap n frames into the preallocated (N, height, width) array `out`.
+
+        The snap loop runs in C++ without the GIL, writing each frame straight into out[i].  n defaults to out.shape[0].  Returns a float64 array with the time each frame was read out, in milliseconds since the call started.
+        """
     def StartExposureSequence(self) -> int: ...
     def StartPropertySequence(self, arg0: str) -> None: ...
     @typing.overload
-    def StartSequenceAcquisition(self, arg0: int, arg1: float, arg2: bool) -> int: ...
+    def StartSequenceAcquisition(
+        self, numImages: int, interval_ms: float, stopOnOverflow: bool
+    ) -> int: ...
     @typing.overload
-    def StartSequenceAcquisition(self, arg0: float) -> int: ...
+    def StartSequenceAcquisition(self, interval_ms: float) -> int: ...
     def StopExposureSequence(self) -> int: ...
     def StopPropertySequence(self, arg0: str) -> None: ...
     def StopSequenceAcquisition(self) -> int: ...
     def SupportsDeviceDetection(self) -> bool: ...
     def SupportsMultiROI(self) -> bool: ...
     def UsesDelay(self) -> bool: ...
+    def WaitForImageProcessors(self, timeout: typing.Any = None) -> bool:
+        """
+        Wait up to `timeout` seconds (forever if None) until every queued frame has been processed and put in the sequence buffer.  Returns whether that happened.
+        """
     def __enter__(self) -> CameraInstance: ...
     def __exit__(self, *args) -> None: ...
     def __init__(
@@ -269,6 +453,30 @@ class DeviceInstance:
     pass
 
 class DeviceManager:
+    def ApplyProperties(
+        self, snapshot: dict, max_workers: int = 0
+    ) -> list[tuple[str, str]]:
+        """
+        Restore a snapshot taken with SnapshotProperties.
+
+        Only writable properties whose current value differs are set, in snapshot order within each device.  Returns the (device, name) pairs that were set.  If any property fails, the rest are still applied and a RuntimeError lists the failures.
+        """
+    def EnableCallStats(self, enable: bool = True, trace_capacity: int = 0) -> None:
+        """
+        Time every call made from Python to this manager's devices.
+
+        Per device and method, GetCallStats reports the count, total, mean, min, max, p50 and p99 of the call time, and how much of it went to waiting for the adapter's lock and to the adapter itself (the rest is spent in the bindings).  With trace_capacity > 0, the most recent calls are also kept for ExportCallTrace.  Enabling again starts afresh; enable=False stops and discards the stats.
+        """
+    def ExportCallTrace(self, path: str) -> int:
+        """
+        Write the traced calls as Chrome trace-event JSON; returns how many.
+
+        The file opens in chrome://tracing or Perfetto.  Raises RuntimeError unless EnableCallStats was called with a trace_capacity.
+        """
+    def GetCallStats(self) -> dict[str, dict[str, dict[str, float]]]:
+        """
+        Return the call stats collected since EnableCallStats, by label and method.
+        """
     def GetCameraDevice(self, device: DeviceInstance) -> CameraInstance:
         """
         Get a device by label, requiring a specific type.
@@ -315,12 +523,34 @@ class DeviceManager:
         """
         Get a device by label, requiring a specific type.
         """
+    def LoadAndInitializeAll(
+        self, specs: list[tuple], max_workers: int = 0
+    ) -> dict[str, float]:
+        """
+        Load and initialize a batch of devices, in parallel where possible.
+
+        specs is a list of (module, deviceName, label) or (module, deviceName, label, parentLabel) tuples.  Without a parentLabel, a device's parent is the hub in the batch that lists it among its installed peripherals, if any.  Hubs are initialized before their peripherals; devices from different adapter libraries are initialized concurrently, on up to max_workers threads (0 means one per library).  Returns each device's initialization time in ms.  If any device fails, the others are still initialized and a RuntimeError lists the failures.
+        """
     def LoadDevice(
         self, module: LoadedDeviceAdapter, deviceName: str, label: str
     ) -> DeviceInstance:
         """
         Load the specified device and assign a device label.
         """
+    def OpenEventStream(
+        self, capacity: int = 4096, coalesce: bool = True
+    ) -> EventStream:
+        """
+        Subscribe to the change notifications of this manager's devices.
+
+        Notifications are queued from the adapters' threads without taking the GIL; events beyond `capacity` that haven't been drained are dropped and counted.
+        """
+    def SnapshotProperties(self, max_workers: int = 0) -> dict:
+        """
+        Read every property of every loaded device.
+
+        Returns a dict of equal-length columns: 'device', 'name', 'value', 'type' and 'readOnly'.  Devices from different adapter libraries are read in parallel, on up to max_workers threads (0 means one per library).
+        """
     def UnloadAllDevices(self) -> None:
         """
         Unload all devices.
@@ -329,6 +559,14 @@ class DeviceManager:
         """
         Unload a device.
         """
+    def WaitForDevices(
+        self, labels: list[str], timeout: float | None = 5.0
+    ) -> dict[str, float]:
+        """
+        Wait until none of the given devices is busy; returns each one's settle time in ms.
+
+        Busy() is polled with the GIL released, at first every 0.5 ms and backing off to every 10 ms, and again at once whenever a stage reports a new position.  A device that uses a delay isn't settled before GetDelayMs() has passed since the call.  Raises TimeoutError if any is still busy after `timeout` seconds (no limit if None).
+        """
     def __enter__(self) -> DeviceManager: ...
     def __exit__(self, *args) -> None: ...
     def __init__(self) -> None: ...
@@ -415,6 +653,41 @@ class DeviceType:
     @property
     def value(self) -> int: ...
 
+class EventStream:
+    """
+    Change notifications from a DeviceManager's devices, queued as they happen.
+
+    Events are tuples: (kind, deviceLabel, *data), where kind is one of 'PropertyChanged' (data: name, value), 'PropertiesChanged', 'StagePositionChanged' (pos), 'XYStagePositionChanged' (x, y), 'ExposureChanged' (ms), 'SLMExposureChanged' (ms) or 'MagnifierChanged'.
+    """
+    def Close(self) -> None:
+        """
+        Stop receiving events.
+        """
+    def Drain(self, maxEvents: int = 0) -> list[tuple]:
+        """
+        Return the queued events (at most maxEvents, if nonzero) without waiting.
+
+        With coalescing, only the latest of repeated updates to the same property, position or exposure in the batch is kept.
+        """
+    def GetDroppedCount(self) -> int:
+        """
+        Number of events dropped because the queue was full.
+        """
+    def Wait(self, timeout: typing.Any = None) -> bool:
+        """
+        Wait up to `timeout` seconds (forever if None) for events.
+
+        Returns whether any may be queued.
+        """
+    def __enter__(self) -> EventStream: ...
+    def __exit__(self, *args) -> None: ...
+    def __iter__(self) -> EventStream: ...
+    def __next__(self) -> tuple: ...
+    def fileno(self) -> int:
+        """
+        A file descriptor that is readable while events may be queued, for select() and event loops.  -1 where unsupported (Windows).
+        """
+
 class FocusDirection:
     """
     Members:
@@ -453,13 +726,62 @@ class FocusDirection:
     @property
     def value(self) -> int: ...
 
+class FocusMetric:
+    """
+    Members:
+
+      NormalizedVariance
+
+      Brenner
+
+      Tenengrad
+    """
+
+    Brenner: typing.ClassVar[FocusMetric]  # value = <FocusMetric.Brenner: 1>
+    NormalizedVariance: typing.ClassVar[
+        FocusMetric
+    ]  # value = <FocusMetric.NormalizedVariance: 0>
+    Tenengrad: typing.ClassVar[FocusMetric]  # value = <FocusMetric.Tenengrad: 2>
+    __members__: typing.ClassVar[
+        dict[str, FocusMetric]
+    ]  # value = {'NormalizedVariance': <FocusMetric.NormalizedVariance: 0>, 'Brenner': <FocusMetric.Brenner: 1>, 'Tenengrad': <FocusMetric.Tenengrad: 2>}
+    def __eq__(self, other: typing.Any) -> bool: ...
+    def __getstate__(self) -> int: ...
+    def __hash__(self) -> int: ...
+    def __index__(self) -> int: ...
+    def __init__(self, value: int) -> None: ...
+    def __int__(self) -> int: ...
+    def __ne__(self, other: typing.Any) -> bool: ...
+    def __repr__(self) -> str: ...
+    def __setstate__(self, state: int) -> None: ...
+    def __str__(self) -> str: ...
+    @property
+    def name(self) -> str: ...
+    @property
+    def value(self) -> int: ...
+
 class GalvoInstance:
     def AddPolygonVertex(self, polygonIndex: int, x: float, y: float) -> int: ...
     def AddToPropertySequence(self, arg0: str, arg1: str) -> None: ...
-    def Busy(self) -> bool: ...
+    def Busy(self) -> bool:
+        """
+        Return whether the device is still carrying out a command.
+
+        Polled with the GIL released, under the adapter library's lock.
+        """
+    def ClearPropertyCache(self) -> None:
+        """
+        Drop all cached property values; the next reads go to the device.
+        """
     def ClearPropertySequence(self, arg0: str) -> None: ...
     def DeletePolygons(self) -> int: ...
     def DetectDevice(self) -> DeviceDetectionStatus: ...
+    def EnablePropertyCache(self, enable: bool = True) -> None:
+        """
+        Serve GetProperty from a cache of last known values.
+
+        The cache is filled on Initialize (or now, if the device is already initialized), updated by the device's property-change notifications, and invalidated by SetProperty.  Properties the adapter changes without notifying are not refreshed; call ClearPropertyCache to force fresh reads.
+        """
     def GetAdapterModule(self) -> LoadedDeviceAdapter: ...
     def GetChannel(self) -> str: ...
     def GetDelayMs(self) -> float: ...
@@ -471,6 +793,10 @@ class GalvoInstance:
     def GetParentID(self) -> str: ...
     def GetPosition(self) -> tuple[float, float]: ...
     def GetProperty(self, arg0: str) -> str: ...
+    def GetPropertyCacheStats(self) -> dict:
+        """
+        Return the property cache's hit and miss counts and number of cached values.
+        """
     def GetPropertyInitStatus(self, arg0: str) -> bool: ...
     def GetPropertyLowerLimit(self, arg0: str) -> float: ...
     def GetPropertyNames(self) -> list[str]: ...
@@ -488,12 +814,36 @@ class GalvoInstance:
     def HasInitializationBeenAttempted(self) -> bool: ...
     def HasProperty(self, arg0: str) -> bool: ...
     def HasPropertyLimits(self, arg0: str) -> bool: ...
-    def Initialize(self) -> None: ...
+    def Initialize(self) -> None:
+        """
+        Initialize the device, refilling its property cache if one is enabled.
+
+        The GIL is released meanwhile; devices from the same adapter library wait for it.
+        """
     def IsInitialized(self) -> bool: ...
+    def IsPropertyCacheEnabled(self) -> bool: ...
     def IsPropertySequenceable(self, arg0: str) -> bool: ...
     def LoadPolygons(self) -> int: ...
+    def LoadPolygonsFromArray(
+        self, vertices: numpy.ndarray[numpy.float64], polygon_offsets: list[int]
+    ) -> None:
+        """
+        Replace the galvo's polygons and load them onto the device in one call.
+
+        vertices is an (N, 2) array of x, y pairs; polygon i is made of the vertices from polygon_offsets[i] up to polygon_offsets[i + 1] (or the last vertex).  Every vertex is checked against the galvo's range before anything is sent.
+        """
     def LogMessage(self, arg0: str, arg1: bool) -> int: ...
     def PointAndFire(self, x: float, y: float, time_us: float) -> int: ...
+    def PointAndFireSequence(
+        self,
+        points: numpy.ndarray[numpy.float64],
+        dwell_us: numpy.ndarray[numpy.float64],
+    ) -> numpy.ndarray[numpy.float64]:
+        """
+        Point and fire at each (x, y) in the (N, 2) array `points`, for dwell_us[i] microseconds each.
+
+        The loop runs in C++ without the GIL, after every point is checked against the galvo's range.  Returns a float64 array with the time each spot was fired, in milliseconds since the call started.
+        """
     def RunPolygons(self) -> int: ...
     def RunSequence(self) -> int: ...
     def SendPropertySequence(self, arg0: str) -> None: ...
@@ -529,9 +879,24 @@ class GalvoInstance:
 
 class GenericInstance:
     def AddToPropertySequence(self, arg0: str, arg1: str) -> None: ...
-    def Busy(self) -> bool: ...
+    def Busy(self) -> bool:
+        """
+        Return whether the device is still carrying out a command.
+
+        Polled with the GIL released, under the adapter library's lock.
+        """
+    def ClearPropertyCache(self) -> None:
+        """
+        Drop all cached property values; the next reads go to the device.
+        """
     def ClearPropertySequence(self, arg0: str) -> None: ...
     def DetectDevice(self) -> DeviceDetectionStatus: ...
+    def EnablePropertyCache(self, enable: bool = True) -> None:
+        """
+        Serve GetProperty from a cache of last known values.
+
+        The cache is filled on Initialize (or now, if the device is already initialized), updated by the device's property-change notifications, and invalidated by SetProperty.  Properties the adapter changes without notifying are not refreshed; call ClearPropertyCache to force fresh reads.
+        """
     def GetAdapterModule(self) -> LoadedDeviceAdapter: ...
     def GetDelayMs(self) -> float: ...
     def GetDescription(self) -> str: ...
@@ -541,6 +906,10 @@ class GenericInstance:
     def GetNumberOfPropertyValues(self, arg0: str) -> int: ...
     def GetParentID(self) -> str: ...
     def GetProperty(self, arg0: str) -> str: ...
+    def GetPropertyCacheStats(self) -> dict:
+        """
+        Return the property cache's hit and miss counts and number of cached values.
+        """
     def GetPropertyInitStatus(self, arg0: str) -> bool: ...
     def GetPropertyLowerLimit(self, arg0: str) -> float: ...
     def GetPropertyNames(self) -> list[str]: ...
@@ -554,8 +923,14 @@ class GenericInstance:
     def HasInitializationBeenAttempted(self) -> bool: ...
     def HasProperty(self, arg0: str) -> bool: ...
     def HasPropertyLimits(self, arg0: str) -> bool: ...
-    def Initialize(self) -> None: ...
+    def Initialize(self) -> None:
+        """
+        Initialize the device, refilling its property cache if one is enabled.
+
+        The GIL is released meanwhile; devices from the same adapter library wait for it.
+        """
     def IsInitialized(self) -> bool: ...
+    def IsPropertyCacheEnabled(self) -> bool: ...
     def IsPropertySequenceable(self, arg0: str) -> bool: ...
     def LogMessage(self, arg0: str, arg1: bool) -> int: ...
     def SendPropertySequence(self, arg0: str) -> None: ...
@@ -584,11 +959,62 @@ class GenericInstance:
     ) -> None: ...
     def __repr__(self) -> str: ...
 
+class HardwareSequence:
+    def Abort(self) -> None:
+        """
+        Stop a Run in progress on another thread; it returns after the current frame.
+        """
+    def AddDASequence(self, label: str, voltages: list[float]) -> None: ...
+    def AddExposureSequence(self, exposures_ms: list[float]) -> None:
+        """
+        Sequence the camera's own exposure time.
+        """
+    def AddPropertySequence(self, label: str, name: str, values: list[str]) -> None: ...
+    def AddStageSequence(self, label: str, positions: list[float]) -> None: ...
+    def AddXYStageSequence(self, label: str, xs: list[float], ys: list[float]) -> None: ...
+    def GetChunks(self) -> list[tuple[int, int]]:
+        """
+        Return the [begin, end) event ranges the sequence is run in.
+
+        Each chunk is as long as the shortest maximum sequence length of the devices.
+        """
+    def GetLength(self) -> int:
+        """
+        Return the number of events (frames).
+        """
+    def Run(
+        self, interval_ms: float = 0.0, stopOnOverflow: bool = True, max_workers: int = 0
+    ) -> int:
+        """
+        Run the whole sequence, chunk by chunk, without the GIL.
+
+        For each chunk every device's sequence is uploaded (devices from different adapter libraries in parallel, on up to max_workers threads) and started, then the camera's sequence acquisition is started, and the device sequences are stopped once the camera is done.  Frames land in the camera's sequence buffer, which another thread can drain with PopNextImage meanwhile.  Returns the number of chunks completed.
+        """
+    def __init__(self, manager: DeviceManager, cameraLabel: str) -> None:
+        """
+        A hardware-triggered acquisition of one camera frame per event, during which each added device steps through its own sequence of values.
+        """
+
 class HubInstance:
     def AddToPropertySequence(self, arg0: str, arg1: str) -> None: ...
-    def Busy(self) -> bool: ...
+    def Busy(self) -> bool:
+        """
+        Return whether the device is still carrying out a command.
+
+        Polled with the GIL released, under the adapter library's lock.
+        """
+    def ClearPropertyCache(self) -> None:
+        """
+        Drop all cached property values; the next reads go to the device.
+        """
     def ClearPropertySequence(self, arg0: str) -> None: ...
     def DetectDevice(self) -> DeviceDetectionStatus: ...
+    def EnablePropertyCache(self, enable: bool = True) -> None:
+        """
+        Serve GetProperty from a cache of last known values.
+
+        The cache is filled on Initialize (or now, if the device is already initialized), updated by the device's property-change notifications, and invalidated by SetProperty.  Properties the adapter changes without notifying are not refreshed; call ClearPropertyCache to force fresh reads.
+        """
     def GetAdapterModule(self) -> LoadedDeviceAdapter: ...
     def GetDelayMs(self) -> float: ...
     def GetDescription(self) -> str: ...
@@ -599,6 +1025,10 @@ class HubInstance:
     def GetNumberOfPropertyValues(self, arg0: str) -> int: ...
     def GetParentID(self) -> str: ...
     def GetProperty(self, arg0: str) -> str: ...
+    def GetPropertyCacheStats(self) -> dict:
+        """
+        Return the property cache's hit and miss counts and number of cached values.
+        """
     def GetPropertyInitStatus(self, arg0: str) -> bool: ...
     def GetPropertyLowerLimit(self, arg0: str) -> float: ...
     def GetPropertyNames(self) -> list[str]: ...
@@ -612,8 +1042,14 @@ class HubInstance:
     def HasInitializationBeenAttempted(self) -> bool: ...
     def HasProperty(self, arg0: str) -> bool: ...
     def HasPropertyLimits(self, arg0: str) -> bool: ...
-    def Initialize(self) -> None: ...
+    def Initialize(self) -> None:
+        """
+        Initialize the device, refilling its property cache if one is enabled.
+
+        The GIL is released meanwhile; devices from the same adapter library wait for it.
+        """
     def IsInitialized(self) -> bool: ...
+    def IsPropertyCacheEnabled(self) -> bool: ...
     def IsPropertySequenceable(self, arg0: str) -> bool: ...
     def LogMessage(self, arg0: str, arg1: bool) -> int: ...
     def SendPropertySequence(self, arg0: str) -> None: ...
@@ -644,9 +1080,24 @@ class HubInstance:
 
 class ImageProcessorInstance:
     def AddToPropertySequence(self, arg0: str, arg1: str) -> None: ...
-    def Busy(self) -> bool: ...
+    def Busy(self) -> bool:
+        """
+        Return whether the device is still carrying out a command.
+
+        Polled with the GIL released, under the adapter library's lock.
+        """
+    def ClearPropertyCache(self) -> None:
+        """
+        Drop all cached property values; the next reads go to the device.
+        """
     def ClearPropertySequence(self, arg0: str) -> None: ...
     def DetectDevice(self) -> DeviceDetectionStatus: ...
+    def EnablePropertyCache(self, enable: bool = True) -> None:
+        """
+        Serve GetProperty from a cache of last known values.
+
+        The cache is filled on Initialize (or now, if the device is already initialized), updated by the device's property-change notifications, and invalidated by SetProperty.  Properties the adapter changes without notifying are not refreshed; call ClearPropertyCache to force fresh reads.
+        """
     def GetAdapterModule(self) -> LoadedDeviceAdapter: ...
     def GetDelayMs(self) -> float: ...
     def GetDescription(self) -> str: ...
@@ -656,6 +1107,10 @@ class ImageProcessorInstance:
     def GetNumberOfPropertyValues(self, arg0: str) -> int: ...
     def GetParentID(self) -> str: ...
     def GetProperty(self, arg0: str) -> str: ...
+    def GetPropertyCacheStats(self) -> dict:
+        """
+        Return the property cache's hit and miss counts and number of cached values.
+        """
     def GetPropertyInitStatus(self, arg0: str) -> bool: ...
     def GetPropertyLowerLimit(self, arg0: str) -> float: ...
     def GetPropertyNames(self) -> list[str]: ...
@@ -669,11 +1124,22 @@ class ImageProcessorInstance:
     def HasInitializationBeenAttempted(self) -> bool: ...
     def HasProperty(self, arg0: str) -> bool: ...
     def HasPropertyLimits(self, arg0: str) -> bool: ...
-    def Initialize(self) -> None: ...
+    def Initialize(self) -> None:
+        """
+        Initialize the device, refilling its property cache if one is enabled.
+
+        The GIL is released meanwhile; devices from the same adapter library wait for it.
+        """
     def IsInitialized(self) -> bool: ...
+    def IsPropertyCacheEnabled(self) -> bool: ...
     def IsPropertySequenceable(self, arg0: str) -> bool: ...
     def LogMessage(self, arg0: str, arg1: bool) -> int: ...
-    def Process(self, buffer: int, width: int, height: int, byteDepth: int) -> None: ...
+    def Process(self, frame: numpy.ndarray) -> None:
+        """
+        Run the processor on a frame in place, without copying it.
+
+        frame is a writeable, C-contiguous (height, width) array (or (height, width, 4) uint8 for RGB32 images).
+        """
     def SendPropertySequence(self, arg0: str) -> None: ...
     def SetCallback(self, arg0: Core) -> None: ...
     def SetDelayMs(self, arg0: float) -> None: ...
@@ -714,6 +1180,47 @@ class LoadedDeviceAdapter:
     def __repr__(self) -> str: ...
     def load_camera(self, name: str, label: str) -> CameraInstance: ...
 
+class LogLevel:
+    """
+    Members:
+
+      Trace
+
+      Debug
+
+      Info
+
+      Warning
+
+      Error
+
+      Fatal
+    """
+
+    Debug: typing.ClassVar[LogLevel]  # value = <LogLevel.Debug: 1>
+    Error: typing.ClassVar[LogLevel]  # value = <LogLevel.Error: 4>
+    Fatal: typing.ClassVar[LogLevel]  # value = <LogLevel.Fatal: 5>
+    Info: typing.ClassVar[LogLevel]  # value = <LogLevel.Info: 2>
+    Trace: typing.ClassVar[LogLevel]  # value = <LogLevel.Trace: 0>
+    Warning: typing.ClassVar[LogLevel]  # value = <LogLevel.Warning: 3>
+    __members__: typing.ClassVar[
+        dict[str, LogLevel]
+    ]  # value = {'Trace': <LogLevel.Trace: 0>, 'Debug': <LogLevel.Debug: 1>, 'Info': <LogLevel.Info: 2>, 'Warning': <LogLevel.Warning: 3>, 'Error': <LogLevel.Error: 4>, 'Fatal': <LogLevel.Fatal: 5>}
+    def __eq__(self, other: typing.Any) -> bool: ...
+    def __getstate__(self) -> int: ...
+    def __hash__(self) -> int: ...
+    def __index__(self) -> int: ...
+    def __init__(self, value: int) -> None: ...
+    def __int__(self) -> int: ...
+    def __ne__(self, other: typing.Any) -> bool: ...
+    def __repr__(self) -> str: ...
+    def __setstate__(self, state: int) -> None: ...
+    def __str__(self) -> str: ...
+    @property
+    def name(self) -> str: ...
+    @property
+    def value(self) -> int: ...
+
 class Logger:
     pass
 
@@ -722,9 +1229,24 @@ class MMThreadLock:
 
 class MagnifierInstance:
     def AddToPropertySequence(self, arg0: str, arg1: str) -> None: ...
-    def Busy(self) -> bool: ...
+    def Busy(self) -> bool:
+        """
+        Return whether the device is still carrying out a command.
+
+        Polled with the GIL released, under the adapter library's lock.
+        """
+    def ClearPropertyCache(self) -> None:
+        """
+        Drop all cached property values; the next reads go to the device.
+        """
     def ClearPropertySequence(self, arg0: str) -> None: ...
     def DetectDevice(self) -> DeviceDetectionStatus: ...
+    def EnablePropertyCache(self, enable: bool = True) -> None:
+        """
+        Serve GetProperty from a cache of last known values.
+
+        The cache is filled on Initialize (or now, if the device is already initialized), updated by the device's property-change notifications, and invalidated by SetProperty.  Properties the adapter changes without notifying are not refreshed; call ClearPropertyCache to force fresh reads.
+        """
     def GetAdapterModule(self) -> LoadedDeviceAdapter: ...
     def GetDelayMs(self) -> float: ...
     def GetDescription(self) -> str: ...
@@ -735,6 +1257,10 @@ class MagnifierInstance:
     def GetNumberOfPropertyValues(self, arg0: str) -> int: ...
     def GetParentID(self) -> str: ...
     def GetProperty(self, arg0: str) -> str: ...
+    def GetPropertyCacheStats(self) -> dict:
+        """
+        Return the property cache's hit and miss counts and number of cached values.
+        """
     def GetPropertyInitStatus(self, arg0: str) -> bool: ...
     def GetPropertyLowerLimit(self, arg0: str) -> float: ...
     def GetPropertyNames(self) -> list[str]: ...
@@ -748,8 +1274,14 @@ class MagnifierInstance:
     def HasInitializationBeenAttempted(self) -> bool: ...
     def HasProperty(self, arg0: str) -> bool: ...
     def HasPropertyLimits(self, arg0: str) -> bool: ...
-    def Initialize(self) -> None: ...
+    def Initialize(self) -> None:
+        """
+        Initialize the device, refilling its property cache if one is enabled.
+
+        The GIL is released meanwhile; devices from the same adapter library wait for it.
+        """
     def IsInitialized(self) -> bool: ...
+    def IsPropertyCacheEnabled(self) -> bool: ...
     def IsPropertySequenceable(self, arg0: str) -> bool: ...
     def LogMessage(self, arg0: str, arg1: bool) -> int: ...
     def SendPropertySequence(self, arg0: str) -> None: ...
@@ -782,10 +1314,36 @@ class MockCMMCore:
     pass
 
 class PluginManager:
+    def EnableAdapterIndex(self, indexPath: typing.Any) -> int:
+        """
+        Keep a record of the devices each adapter library advertises in `indexPath`.
+
+        GetIndexedDeviceAdapters and GetIndexedDevices then answer from the record instead of loading libraries.  Libraries that are new or have changed since they were recorded (or all of them, if the bindings were rebuilt for a new DEVICE_INTERFACE_VERSION) are probed whenever the search paths are set or RefreshAdapterIndex is called.  Returns the number of libraries probed.
+        """
     def GetAvailableDeviceAdapters(self) -> list[str]: ...
     def GetDeviceAdapter(self, moduleName: str) -> LoadedDeviceAdapter: ...
+    def GetIndexedDeviceAdapters(self) -> list[str]:
+        """
+        Names of the indexed adapter libraries on the search paths that loaded successfully.
+        """
+    def GetIndexedDevices(self, moduleName: str) -> list[tuple[str, DeviceType, str]]:
+        """
+        Return (name, type, description) for each device the adapter library advertises, from the adapter index.
+        """
     def GetSearchPaths(self) -> list[str]: ...
+    def RefreshAdapterIndex(self) -> int:
+        """
+        Re-scan the search paths and probe new or changed adapter libraries.
+
+        Returns the number of libraries probed.
+        """
     def SetSearchPaths(self, paths: typing.Iterable) -> None: ...
+    def StartDiscovery(self, max_workers: int = 0) -> AdapterDiscovery:
+        """
+        Find and validate the adapter libraries on the search paths in the background.
+
+        Directories are listed and libraries loaded and checked on up to max_workers threads (0 for one per CPU), and the returned AdapterDiscovery reports progress.  While it runs, GetDeviceAdapter loads a module the scan has not reached yet immediately.  If the adapter index is enabled, unchanged libraries are taken from it and it is updated when the scan completes.  Setting the search paths cancels the scan.
+        """
     def UnloadPluginLibrary(self, moduleName: str) -> None: ...
     def __init__(self) -> None: ...
 
@@ -875,12 +1433,23 @@ class PyCoreCallback(Core):
     def GetImage(self) -> str: ...
     def GetImageDimensions(self, width: int, height: int, depth: int) -> int: ...
     def GetSerialAnswer(
-        self, device: Device, portName: str, ansLength: int, answerTxt: str, term: str
-    ) -> int: ...
+        self, device: Device, portName: str, term: str, ansLength: int = 1024
+    ) -> tuple[int, str]:
+        """
+        Read the port's next answer, up to `term`, as an adapter would; returns (error code, answer).
+        """
     def GetXYPosition(self, x: float, y: float) -> int: ...
     def InitializeImageBuffer(
         self, channels: int, slices: int, w: int, h: int, pixDepth: int
     ) -> bool: ...
+    def InsertImage(
+        self, caller: Device, frame: numpy.ndarray, doProcess: bool = True
+    ) -> int:
+        """
+        Insert a frame into the camera's sequence buffer as its acquisition thread would; returns the error code.
+
+        frame is a C-contiguous (height, width) array (or (height, width, 4) uint8 for RGB32 images). With image processors attached it goes through them unless doProcess is False, in order with the other frames either way.
+        """
     def LogMessage(self, caller: Device, msg: str, debugOnly: bool) -> int: ...
     def MoveFocus(self, v: float) -> int: ...
     def MoveXYStage(self, vX: float, vY: float) -> int: ...
@@ -903,8 +1472,11 @@ class PyCoreCallback(Core):
     def PrepareForAcq(self, caller: Device) -> int: ...
     def PurgeSerial(self, caller: Device, portName: str) -> int: ...
     def ReadFromSerial(
-        self, caller: Device, portName: str, buf: int, bufLength: int, bytesRead: int
-    ) -> int: ...
+        self, caller: Device, portName: str, bufLength: int = 4096
+    ) -> tuple[int, bytes]:
+        """
+        Read up to bufLength bytes from the port as an adapter would; returns (error code, data).
+        """
     def SetConfig(self, group: str, name: str) -> int: ...
     def SetDeviceProperty(self, deviceName: str, propName: str, value: str) -> int: ...
     def SetExposure(self, expMs: float) -> int: ...
@@ -924,19 +1496,40 @@ class PyCoreCallback(Core):
     ) -> int: ...
     def SetXYPosition(self, x: float, y: float) -> int: ...
     def Sleep(self, caller: Device, intervalMs: float) -> None: ...
-    def WriteToSerial(
-        self, caller: Device, portName: str, buf: int, length: int
-    ) -> int: ...
+    def WriteToSerial(self, caller: Device, portName: str, data: bytes) -> int:
+        """
+        Write `data` to the port as an adapter would; returns the error code.
+        """
     def __init__(self) -> None: ...
 
 class SLMInstance:
     def AddToPropertySequence(self, arg0: str, arg1: str) -> None: ...
-    def AddToSLMSequence(self, pixels: typing_extensions.Buffer) -> None: ...
-    def Busy(self) -> bool: ...
+    def AddToSLMSequence(self, pixels: typing_extensions.Buffer) -> float:
+        """
+        Add one image, or an (N, height, width[, 4]) stack of them, to the SLM sequence in one call; returns the time taken, in ms.
+
+        Images are laid out as for SetImage and passed to the adapter without copying.  Raises SequenceError if the images, together with those queued since the last ClearSLMSequence, exceed GetSLMSequenceMaxLength or the SLM rejects one.
+        """
+    def Busy(self) -> bool:
+        """
+        Return whether the device is still carrying out a command.
+
+        Polled with the GIL released, under the adapter library's lock.
+        """
+    def ClearPropertyCache(self) -> None:
+        """
+        Drop all cached property values; the next reads go to the device.
+        """
     def ClearPropertySequence(self, arg0: str) -> None: ...
     def ClearSLMSequence(self) -> int: ...
     def DetectDevice(self) -> DeviceDetectionStatus: ...
     def DisplayImage(self) -> int: ...
+    def EnablePropertyCache(self, enable: bool = True) -> None:
+        """
+        Serve GetProperty from a cache of last known values.
+
+        The cache is filled on Initialize (or now, if the device is already initialized), updated by the device's property-change notifications, and invalidated by SetProperty.  Properties the adapter changes without notifying are not refreshed; call ClearPropertyCache to force fresh reads.
+        """
     def GetAdapterModule(self) -> LoadedDeviceAdapter: ...
     def GetBytesPerPixel(self) -> int: ...
     def GetDelayMs(self) -> float: ...
@@ -950,6 +1543,10 @@ class SLMInstance:
     def GetNumberOfPropertyValues(self, arg0: str) -> int: ...
     def GetParentID(self) -> str: ...
     def GetProperty(self, arg0: str) -> str: ...
+    def GetPropertyCacheStats(self) -> dict:
+        """
+        Return the property cache's hit and miss counts and number of cached values.
+        """
     def GetPropertyInitStatus(self, arg0: str) -> bool: ...
     def GetPropertyLowerLimit(self, arg0: str) -> float: ...
     def GetPropertyNames(self) -> list[str]: ...
@@ -965,8 +1562,14 @@ class SLMInstance:
     def HasInitializationBeenAttempted(self) -> bool: ...
     def HasProperty(self, arg0: str) -> bool: ...
     def HasPropertyLimits(self, arg0: str) -> bool: ...
-    def Initialize(self) -> None: ...
+    def Initialize(self) -> None:
+        """
+        Initialize the device, refilling its property cache if one is enabled.
+
+        The GIL is released meanwhile; devices from the same adapter library wait for it.
+        """
     def IsInitialized(self) -> bool: ...
+    def IsPropertyCacheEnabled(self) -> bool: ...
     def IsPropertySequenceable(self, arg0: str) -> bool: ...
     def IsSLMSequenceable(self) -> bool: ...
     def LogMessage(self, arg0: str, arg1: bool) -> int: ...
@@ -976,7 +1579,12 @@ class SLMInstance:
     def SetDelayMs(self, arg0: float) -> None: ...
     def SetDescription(self, arg0: str) -> None: ...
     def SetExposure(self, interval_ms: float) -> int: ...
-    def SetImage(self, pixels: typing_extensions.Buffer) -> None: ...
+    def SetImage(self, pixels: typing_extensions.Buffer) -> int:
+        """
+        Load an image onto the SLM, straight from any C-contiguous buffer.
+
+        pixels is (height, width) with GetBytesPerPixel()-sized items, e.g. uint8 or, for RGB32 SLMs, uint32; RGB32 images may also be (height, width, 4) uint8.  Nothing is copied on the way to the adapter.  Raises ValueError for an SLM that is neither 8-bit nor RGB32.
+        """
     def SetParentID(self, arg0: str) -> None: ...
     @typing.overload
     def SetPixelsTo(self, intensity: int) -> int: ...
@@ -1005,13 +1613,36 @@ class SLMInstance:
     ) -> None: ...
     def __repr__(self) -> str: ...
 
+class SequenceError(RuntimeError):
+    pass
+
 class SerialInstance:
     def AddToPropertySequence(self, arg0: str, arg1: str) -> None: ...
-    def Busy(self) -> bool: ...
+    def Busy(self) -> bool:
+        """
+        Return whether the device is still carrying out a command.
+
+        Polled with the GIL released, under the adapter library's lock.
+        """
+    def ClearPropertyCache(self) -> None:
+        """
+        Drop all cached property values; the next reads go to the device.
+        """
     def ClearPropertySequence(self, arg0: str) -> None: ...
     def DetectDevice(self) -> DeviceDetectionStatus: ...
+    def EnablePropertyCache(self, enable: bool = True) -> None:
+        """
+        Serve GetProperty from a cache of last known values.
+
+        The cache is filled on Initialize (or now, if the device is already initialized), updated by the device's property-change notifications, and invalidated by SetProperty.  Properties the adapter changes without notifying are not refreshed; call ClearPropertyCache to force fresh reads.
+        """
     def GetAdapterModule(self) -> LoadedDeviceAdapter: ...
-    def GetAnswer(self, term: str) -> str: ...
+    def GetAnswer(self, term: str, maxChars: int = 1024) -> str:
+        """
+        Return the next answer, up to `term`, waiting as long as the port's AnswerTimeout.
+
+        Bytes already buffered by Read or Transact come first, so the calls can be mixed.
+        """
     def GetDelayMs(self) -> float: ...
     def GetDescription(self) -> str: ...
     def GetErrorText(self, arg0: int) -> str: ...
@@ -1021,6 +1652,10 @@ class SerialInstance:
     def GetParentID(self) -> str: ...
     def GetPortType(self) -> PortType: ...
     def GetProperty(self, arg0: str) -> str: ...
+    def GetPropertyCacheStats(self) -> dict:
+        """
+        Return the property cache's hit and miss counts and number of cached values.
+        """
     def GetPropertyInitStatus(self, arg0: str) -> bool: ...
     def GetPropertyLowerLimit(self, arg0: str) -> float: ...
     def GetPropertyNames(self) -> list[str]: ...
@@ -1034,12 +1669,28 @@ class SerialInstance:
     def HasInitializationBeenAttempted(self) -> bool: ...
     def HasProperty(self, arg0: str) -> bool: ...
     def HasPropertyLimits(self, arg0: str) -> bool: ...
-    def Initialize(self) -> None: ...
+    def Initialize(self) -> None:
+        """
+        Initialize the device, refilling its property cache if one is enabled.
+
+        The GIL is released meanwhile; devices from the same adapter library wait for it.
+        """
     def IsInitialized(self) -> bool: ...
+    def IsPropertyCacheEnabled(self) -> bool: ...
     def IsPropertySequenceable(self, arg0: str) -> bool: ...
     def LogMessage(self, arg0: str, arg1: bool) -> int: ...
-    def Purge(self) -> int: ...
-    def Read(self) -> list[str]: ...
+    def Purge(self) -> int:
+        """
+        Discard everything received but not yet read.
+        """
+    def Read(self, maxBytes: int = 4096) -> bytes:
+        """
+        Read up to maxBytes bytes that have arrived, without waiting.
+        """
+    def ReadInto(self, buffer: typing_extensions.Buffer) -> int:
+        """
+        Read as many bytes as have arrived into a writable buffer, up to its size, without waiting.  Returns the number of bytes read.
+        """
     def SendPropertySequence(self, arg0: str) -> None: ...
     def SetCallback(self, arg0: Core) -> None: ...
     def SetCommand(self, command: str, term: str) -> int: ...
@@ -1052,7 +1703,34 @@ class SerialInstance:
     def StopPropertySequence(self, arg0: str) -> None: ...
     def SupportsDeviceDetection(self) -> bool: ...
     def UsesDelay(self) -> bool: ...
-    def Write(self, data: str) -> int: ...
+    def Transact(
+        self, command: str, term: str, timeout: float = 1.0, answerTerm: str | None = None
+    ) -> bytes:
+        """
+        Send command + term and return the answer, up to its terminator, in one call without the GIL.
+
+        The answer ends at answerTerm (term if None).  Raises TimeoutError if it doesn't arrive within timeout seconds, after purging the port.
+        """
+    def TransactMany(
+        self,
+        commands: list[str],
+        term: str,
+        timeout: float = 1.0,
+        answerTerm: str | None = None,
+        window: int = 0,
+    ) -> list[bytes]:
+        """
+        Pipeline several commands: keep up to `window` of them (0: all) in flight and collect their answers in order.
+
+        Otherwise like Transact; the timeout applies to each answer.
+        """
+    @typing.overload
+    def Write(self, data: str | bytes) -> int: ...
+    @typing.overload
+    def Write(self, data: typing_extensions.Buffer) -> int:
+        """
+        Write the raw bytes of any contiguous buffer.
+        """
     def __enter__(self) -> SerialInstance: ...
     def __exit__(self, *args) -> None: ...
     def __init__(
@@ -1068,11 +1746,104 @@ class SerialInstance:
     ) -> None: ...
     def __repr__(self) -> str: ...
 
+class SerialRecorder:
+    """
+    Records the timestamped traffic of serial ports, in both directions, to a file that SerialReplay can play back.
+    """
+    def AddPort(self, port: str) -> None:
+        """
+        Record the port with this label, whether it is used through a SerialInstance or by adapters.
+        """
+    def Close(self) -> None:
+        """
+        Stop recording its ports and close the file.
+        """
+    def GetByteCount(self) -> int:
+        """
+        Number of data bytes recorded, in both directions.
+        """
+    def GetEventCount(self) -> int: ...
+    def GetPortNames(self) -> list[str]: ...
+    def IsOpen(self) -> bool: ...
+    def RemovePort(self, port: str) -> None: ...
+    def __enter__(self) -> SerialRecorder: ...
+    def __exit__(self, *args) -> None: ...
+    def __init__(self, path: str) -> None: ...
+
+class SerialReplay:
+    """
+    Plays a SerialRecorder file back in place of the hardware.
+
+    Each recorded port expects the writes and purges it recorded, in order, and answers with what it recorded reading, after the recorded delay times `time_scale` (0: at once).  Writes that depart from the recording count as mismatches, and are refused if `strict`.
+    """
+    def Attach(self, ports: list[str] | None = None) -> None:
+        """
+        Serve adapters' I/O on these ports (all recorded ones if None) from the recording.
+        """
+    def Detach(self) -> None:
+        """
+        Hand the ports back to the hardware.
+        """
+    def GetAnswer(self, port: str, term: str) -> str: ...
+    def GetLastMismatch(self) -> str: ...
+    def GetMismatchCount(self) -> int: ...
+    def GetPortNames(self) -> list[str]: ...
+    def IsFinished(self) -> bool:
+        """
+        Whether every recorded event has been replayed.
+        """
+    def Purge(self, port: str) -> None:
+        """
+        Purge the port as the host would.
+
+        Raises RuntimeError for a port that isn't in the recording, and, if strict, for a purge the recording doesn't have next.
+        """
+    def Read(self, port: str, max_bytes: int = 4096) -> bytes:
+        """
+        Read the recorded bytes that are due, up to max_bytes, without waiting.
+
+        Returns b'' if the next ones aren't due yet.  Raises TimeoutError once the port has nothing left to read, and RuntimeError for a port that isn't in the recording.
+        """
+    def Rewind(self) -> None:
+        """
+        Start over from the beginning of the recording.
+        """
+    def Write(self, port: str, data: str | bytes) -> None:
+        """
+        Write to the port as the host would.
+
+        Raises RuntimeError for a port that isn't in the recording, and, if strict, for data that departs from it.
+        """
+    def __enter__(self) -> SerialReplay: ...
+    def __exit__(self, *args) -> None: ...
+    def __init__(
+        self,
+        path: str,
+        time_scale: float = 1.0,
+        strict: bool = False,
+        answer_timeout: float = 5.0,
+    ) -> None: ...
+
 class ShutterInstance:
     def AddToPropertySequence(self, arg0: str, arg1: str) -> None: ...
-    def Busy(self) -> bool: ...
+    def Busy(self) -> bool:
+        """
+        Return whether the device is still carrying out a command.
+
+        Polled with the GIL released, under the adapter library's lock.
+        """
+    def ClearPropertyCache(self) -> None:
+        """
+        Drop all cached property values; the next reads go to the device.
+        """
     def ClearPropertySequence(self, arg0: str) -> None: ...
     def DetectDevice(self) -> DeviceDetectionStatus: ...
+    def EnablePropertyCache(self, enable: bool = True) -> None:
+        """
+        Serve GetProperty from a cache of last known values.
+
+        The cache is filled on Initialize (or now, if the device is already initialized), updated by the device's property-change notifications, and invalidated by SetProperty.  Properties the adapter changes without notifying are not refreshed; call ClearPropertyCache to force fresh reads.
+        """
     def Fire(self, deltaT: float) -> int: ...
     def GetAdapterModule(self) -> LoadedDeviceAdapter: ...
     def GetDelayMs(self) -> float: ...
@@ -1084,6 +1855,10 @@ class ShutterInstance:
     def GetOpen(self) -> bool: ...
     def GetParentID(self) -> str: ...
     def GetProperty(self, arg0: str) -> str: ...
+    def GetPropertyCacheStats(self) -> dict:
+        """
+        Return the property cache's hit and miss counts and number of cached values.
+        """
     def GetPropertyInitStatus(self, arg0: str) -> bool: ...
     def GetPropertyLowerLimit(self, arg0: str) -> float: ...
     def GetPropertyNames(self) -> list[str]: ...
@@ -1097,8 +1872,14 @@ class ShutterInstance:
     def HasInitializationBeenAttempted(self) -> bool: ...
     def HasProperty(self, arg0: str) -> bool: ...
     def HasPropertyLimits(self, arg0: str) -> bool: ...
-    def Initialize(self) -> None: ...
+    def Initialize(self) -> None:
+        """
+        Initialize the device, refilling its property cache if one is enabled.
+
+        The GIL is released meanwhile; devices from the same adapter library wait for it.
+        """
     def IsInitialized(self) -> bool: ...
+    def IsPropertyCacheEnabled(self) -> bool: ...
     def IsPropertySequenceable(self, arg0: str) -> bool: ...
     def LogMessage(self, arg0: str, arg1: bool) -> int: ...
     def SendPropertySequence(self, arg0: str) -> None: ...
@@ -1129,12 +1910,35 @@ class ShutterInstance:
     def __repr__(self) -> str: ...
 
 class SignalIOInstance:
+    @typing.overload
     def AddToDASequence(self, voltage: float) -> int: ...
+    @typing.overload
+    def AddToDASequence(self, voltages: numpy.ndarray[numpy.float64]) -> float:
+        """
+        Add every voltage in a 1-D float64 array in one call; returns the time taken, in ms.
+
+        Raises SequenceError if the points, together with those queued since the last ClearDASequence, exceed GetDASequenceMaxLength or the device rejects one.
+        """
     def AddToPropertySequence(self, arg0: str, arg1: str) -> None: ...
-    def Busy(self) -> bool: ...
+    def Busy(self) -> bool:
+        """
+        Return whether the device is still carrying out a command.
+
+        Polled with the GIL released, under the adapter library's lock.
+        """
     def ClearDASequence(self) -> int: ...
+    def ClearPropertyCache(self) -> None:
+        """
+        Drop all cached property values; the next reads go to the device.
+        """
     def ClearPropertySequence(self, arg0: str) -> None: ...
     def DetectDevice(self) -> DeviceDetectionStatus: ...
+    def EnablePropertyCache(self, enable: bool = True) -> None:
+        """
+        Serve GetProperty from a cache of last known values.
+
+        The cache is filled on Initialize (or now, if the device is already initialized), updated by the device's property-change notifications, and invalidated by SetProperty.  Properties the adapter changes without notifying are not refreshed; call ClearPropertyCache to force fresh reads.
+        """
     def GetAdapterModule(self) -> LoadedDeviceAdapter: ...
     def GetDASequenceMaxLength(self) -> int: ...
     def GetDelayMs(self) -> float: ...
@@ -1147,6 +1951,10 @@ class SignalIOInstance:
     def GetNumberOfPropertyValues(self, arg0: str) -> int: ...
     def GetParentID(self) -> str: ...
     def GetProperty(self, arg0: str) -> str: ...
+    def GetPropertyCacheStats(self) -> dict:
+        """
+        Return the property cache's hit and miss counts and number of cached values.
+        """
     def GetPropertyInitStatus(self, arg0: str) -> bool: ...
     def GetPropertyLowerLimit(self, arg0: str) -> float: ...
     def GetPropertyNames(self) -> list[str]: ...
@@ -1161,9 +1969,15 @@ class SignalIOInstance:
     def HasInitializationBeenAttempted(self) -> bool: ...
     def HasProperty(self, arg0: str) -> bool: ...
     def HasPropertyLimits(self, arg0: str) -> bool: ...
-    def Initialize(self) -> None: ...
+    def Initialize(self) -> None:
+        """
+        Initialize the device, refilling its property cache if one is enabled.
+
+        The GIL is released meanwhile; devices from the same adapter library wait for it.
+        """
     def IsDASequenceable(self) -> bool: ...
     def IsInitialized(self) -> bool: ...
+    def IsPropertyCacheEnabled(self) -> bool: ...
     def IsPropertySequenceable(self, arg0: str) -> bool: ...
     def LogMessage(self, arg0: str, arg1: bool) -> int: ...
     def SendDASequence(self) -> int: ...
@@ -1197,13 +2011,60 @@ class SignalIOInstance:
     ) -> None: ...
     def __repr__(self) -> str: ...
 
+class SoftwareAutofocus:
+    def Run(
+        self,
+        range_um: float = 20.0,
+        step_um: float = 2.0,
+        min_step_um: float = 0.25,
+        metric: FocusMetric = FocusMetric.NormalizedVariance,
+        center_um: float | None = None,
+        settle_timeout: float | None = 5.0,
+    ) -> dict[str, typing.Any]:
+        """
+        Find the sharpest focus position, without the GIL, and leave the stage there.
+
+        Frames are snapped every step_um over range_um around center_um (the current position if None), then either side of the best one in quarter steps down to min_step_um.  Returns a dict of 'position_um' and 'score' of the best position, the 'positions' and 'scores' visited, and 'score_ms', the time spent scoring.  Raises TimeoutError if the stage takes longer than settle_timeout seconds to settle (no limit if None).
+        """
+    def SnapAndScore(self, metric: FocusMetric = FocusMetric.NormalizedVariance) -> float:
+        """
+        Snap a frame where the stage is and score it in the camera's buffer, without the GIL.
+        """
+    def __init__(self, manager: DeviceManager, cameraLabel: str, stageLabel: str) -> None:
+        """
+        Image-based autofocus with a camera and a focus stage, for rigs without an autofocus device.
+        """
+
 class StageInstance:
     def AddToPropertySequence(self, arg0: str, arg1: str) -> None: ...
+    @typing.overload
     def AddToStageSequence(self, position: float) -> int: ...
-    def Busy(self) -> bool: ...
+    @typing.overload
+    def AddToStageSequence(self, positions: numpy.ndarray[numpy.float64]) -> float:
+        """
+        Add every position (um) in a 1-D float64 array in one call; returns the time taken, in ms.
+
+        Raises SequenceError if the points, together with those queued since the last ClearStageSequence, exceed GetStageSequenceMaxLength or the stage rejects one.
+        """
+    def Busy(self) -> bool:
+        """
+        Return whether the device is still carrying out a command.
+
+        Polled with the GIL released, under the adapter library's lock.
+        """
+    def ClearPropertyCache(self) -> None:
+        """
+        Drop all cached property values; the next reads go to the device.
+        """
     def ClearPropertySequence(self, arg0: str) -> None: ...
     def ClearStageSequence(self) -> int: ...
     def DetectDevice(self) -> DeviceDetectionStatus: ...
+    def EnablePropertyCache(self, enable: bool = True) -> None:
+        """
+        Serve GetProperty from a cache of last known values.
+
+        The cache is filled on Initialize (or now, if the device is already initialized), updated by the device's property-change notifications, and invalidated by SetProperty.  Properties the adapter changes without notifying are not refreshed; call ClearPropertyCache to force fresh reads.
+        """
     def GetAdapterModule(self) -> LoadedDeviceAdapter: ...
     def GetDelayMs(self) -> float: ...
     def GetDescription(self) -> str: ...
@@ -1217,6 +2078,10 @@ class StageInstance:
     def GetPositionSteps(self) -> int: ...
     def GetPositionUm(self) -> float: ...
     def GetProperty(self, arg0: str) -> str: ...
+    def GetPropertyCacheStats(self) -> dict:
+        """
+        Return the property cache's hit and miss counts and number of cached values.
+        """
     def GetPropertyInitStatus(self, arg0: str) -> bool: ...
     def GetPropertyLowerLimit(self, arg0: str) -> float: ...
     def GetPropertyNames(self) -> list[str]: ...
@@ -1232,9 +2097,15 @@ class StageInstance:
     def HasProperty(self, arg0: str) -> bool: ...
     def HasPropertyLimits(self, arg0: str) -> bool: ...
     def Home(self) -> int: ...
-    def Initialize(self) -> None: ...
+    def Initialize(self) -> None:
+        """
+        Initialize the device, refilling its property cache if one is enabled.
+
+        The GIL is released meanwhile; devices from the same adapter library wait for it.
+        """
     def IsContinuousFocusDrive(self) -> bool: ...
     def IsInitialized(self) -> bool: ...
+    def IsPropertyCacheEnabled(self) -> bool: ...
     def IsPropertySequenceable(self, arg0: str) -> bool: ...
     def IsStageLinearSequenceable(self) -> bool: ...
     def IsStageSequenceable(self) -> bool: ...
@@ -1250,7 +2121,12 @@ class StageInstance:
     def SetOrigin(self) -> int: ...
     def SetParentID(self, arg0: str) -> None: ...
     def SetPositionSteps(self, steps: int) -> int: ...
-    def SetPositionUm(self, pos: float) -> int: ...
+    def SetPositionUm(self, pos: float) -> int:
+        """
+        Move the stage to `pos` um.
+
+        The command is sent with the GIL released, so a slow stage doesn't stall other threads; only devices from the stage's own adapter library wait for it.
+        """
     def SetProperty(self, arg0: str, arg1: str) -> None: ...
     def SetRelativePositionUm(self, d: float) -> int: ...
     def SetStageLinearSequence(self, dZ_um: float, nSlices: int) -> int: ...
@@ -1279,9 +2155,24 @@ class StageInstance:
 
 class StateInstance:
     def AddToPropertySequence(self, arg0: str, arg1: str) -> None: ...
-    def Busy(self) -> bool: ...
+    def Busy(self) -> bool:
+        """
+        Return whether the device is still carrying out a command.
+
+        Polled with the GIL released, under the adapter library's lock.
+        """
+    def ClearPropertyCache(self) -> None:
+        """
+        Drop all cached property values; the next reads go to the device.
+        """
     def ClearPropertySequence(self, arg0: str) -> None: ...
     def DetectDevice(self) -> DeviceDetectionStatus: ...
+    def EnablePropertyCache(self, enable: bool = True) -> None:
+        """
+        Serve GetProperty from a cache of last known values.
+
+        The cache is filled on Initialize (or now, if the device is already initialized), updated by the device's property-change notifications, and invalidated by SetProperty.  Properties the adapter changes without notifying are not refreshed; call ClearPropertyCache to force fresh reads.
+        """
     def GetAdapterModule(self) -> LoadedDeviceAdapter: ...
     def GetDelayMs(self) -> float: ...
     def GetDescription(self) -> str: ...
@@ -1299,6 +2190,10 @@ class StateInstance:
     @typing.overload
     def GetPositionLabel(self, pos: int) -> str: ...
     def GetProperty(self, arg0: str) -> str: ...
+    def GetPropertyCacheStats(self) -> dict:
+        """
+        Return the property cache's hit and miss counts and number of cached values.
+        """
     def GetPropertyInitStatus(self, arg0: str) -> bool: ...
     def GetPropertyLowerLimit(self, arg0: str) -> float: ...
     def GetPropertyNames(self) -> list[str]: ...
@@ -1312,8 +2207,14 @@ class StateInstance:
     def HasInitializationBeenAttempted(self) -> bool: ...
     def HasProperty(self, arg0: str) -> bool: ...
     def HasPropertyLimits(self, arg0: str) -> bool: ...
-    def Initialize(self) -> None: ...
+    def Initialize(self) -> None:
+        """
+        Initialize the device, refilling its property cache if one is enabled.
+
+        The GIL is released meanwhile; devices from the same adapter library wait for it.
+        """
     def IsInitialized(self) -> bool: ...
+    def IsPropertyCacheEnabled(self) -> bool: ...
     def IsPropertySequenceable(self, arg0: str) -> bool: ...
     def LogMessage(self, arg0: str, arg1: bool) -> int: ...
     def SendPropertySequence(self, arg0: str) -> None: ...
@@ -1348,13 +2249,58 @@ class StateInstance:
     ) -> None: ...
     def __repr__(self) -> str: ...
 
+class TileScan:
+    def Abort(self) -> None:
+        """
+        Stop a Run in progress on another thread; it returns once the current tile is copied.
+        """
+    def Run(
+        self,
+        positions: numpy.ndarray[numpy.float64],
+        out: numpy.ndarray,
+        offsets: numpy.ndarray | None = None,
+        settle_timeout: float | None = 5.0,
+    ) -> dict[str, numpy.ndarray[numpy.float64]]:
+        """
+        Visit each (x, y) position in um, wait for the stage to settle and snap a frame, without the GIL.
+
+        `out` is either an (N, height, width) stack or a 2-D mosaic, in which case `offsets` gives each tile's top-left (row, column).  Each frame is copied there on a second thread while the stage moves on.  Returns a dict of 'settled_ms', 'snapped_ms' and 'copied_ms' arrays, in ms since the start (NaN for tiles not reached).  Raises TimeoutError if the stage takes longer than settle_timeout seconds to settle at a tile (no limit if None).
+        """
+    def __init__(self, manager: DeviceManager, cameraLabel: str, xyStageLabel: str) -> None:
+        """
+        A tiled acquisition of one camera frame at each of a list of XY stage positions.
+        """
+
 class XYStageInstance:
     def AddToPropertySequence(self, arg0: str, arg1: str) -> None: ...
+    @typing.overload
     def AddToXYStageSequence(self, positionX: float, positionY: float) -> int: ...
-    def Busy(self) -> bool: ...
+    @typing.overload
+    def AddToXYStageSequence(self, positions: numpy.ndarray[numpy.float64]) -> float:
+        """
+        Add every (x, y) position (um) in an (N, 2) float64 array in one call; returns the time taken, in ms.
+
+        Raises SequenceError if the points, together with those queued since the last ClearXYStageSequence, exceed GetXYStageSequenceMaxLength or the stage rejects one.
+        """
+    def Busy(self) -> bool:
+        """
+        Return whether the device is still carrying out a command.
+
+        Polled with the GIL released, under the adapter library's lock.
+        """
+    def ClearPropertyCache(self) -> None:
+        """
+        Drop all cached property values; the next reads go to the device.
+        """
     def ClearPropertySequence(self, arg0: str) -> None: ...
     def ClearXYStageSequence(self) -> int: ...
     def DetectDevice(self) -> DeviceDetectionStatus: ...
+    def EnablePropertyCache(self, enable: bool = True) -> None:
+        """
+        Serve GetProperty from a cache of last known values.
+
+        The cache is filled on Initialize (or now, if the device is already initialized), updated by the device's property-change notifications, and invalidated by SetProperty.  Properties the adapter changes without notifying are not refreshed; call ClearPropertyCache to force fresh reads.
+        """
     def GetAdapterModule(self) -> LoadedDeviceAdapter: ...
     def GetDelayMs(self) -> float: ...
     def GetDescription(self) -> str: ...
@@ -1370,6 +2316,10 @@ class XYStageInstance:
     def GetPositionSteps(self) -> tuple[int, int]: ...
     def GetPositionUm(self) -> tuple[float, float]: ...
     def GetProperty(self, arg0: str) -> str: ...
+    def GetPropertyCacheStats(self) -> dict:
+        """
+        Return the property cache's hit and miss counts and number of cached values.
+        """
     def GetPropertyInitStatus(self, arg0: str) -> bool: ...
     def GetPropertyLowerLimit(self, arg0: str) -> float: ...
     def GetPropertyNames(self) -> list[str]: ...
@@ -1387,8 +2337,14 @@ class XYStageInstance:
     def HasInitializationBeenAttempted(self) -> bool: ...
     def HasProperty(self, arg0: str) -> bool: ...
     def HasPropertyLimits(self, arg0: str) -> bool: ...
-    def Initialize(self) -> None: ...
+    def Initialize(self) -> None:
+        """
+        Initialize the device, refilling its property cache if one is enabled.
+
+        The GIL is released meanwhile; devices from the same adapter library wait for it.
+        """
     def IsInitialized(self) -> bool: ...
+    def IsPropertyCacheEnabled(self) -> bool: ...
     def IsPropertySequenceable(self, arg0: str) -> bool: ...
     def IsXYStageSequenceable(self) -> bool: ...
     def LogMessage(self, arg0: str, arg1: bool) -> int: ...
@@ -1401,7 +2357,12 @@ class XYStageInstance:
     def SetOrigin(self) -> int: ...
     def SetParentID(self, arg0: str) -> None: ...
     def SetPositionSteps(self, x: int, y: int) -> int: ...
-    def SetPositionUm(self, x: float, y: float) -> int: ...
+    def SetPositionUm(self, x: float, y: float) -> int:
+        """
+        Move the stage to (x, y) um.
+
+        As for a Z stage, the GIL is released and the adapter library's lock held while the command is sent.
+        """
     def SetProperty(self, arg0: str, arg1: str) -> None: ...
     def SetRelativePositionUm(self, dx: float, dy: float) -> int: ...
     def Shutdown(self) -> None: ...
@@ -1426,4 +2387,45 @@ class XYStageInstance:
     ) -> None: ...
     def __repr__(self) -> str: ...
 
+def FlushLog() -> None:
+    """
+    Wait until every message logged so far has been written out.
+    """
+
+def FocusScore(
+    image: numpy.ndarray, metric: FocusMetric = FocusMetric.NormalizedVariance
+) -> float:
+    """
+    Score the sharpness of a 2-D uint8 or uint16 image (higher is sharper), as SoftwareAutofocus does.
+    """
+
+def GetDroppedLogCount() -> int:
+    """
+    Return how many log messages were dropped because a thread logged faster than they could be written out.
+    """
+
+def GetLogLevel(label: str = "") -> LogLevel:
+    """
+    Return the lowest level logged for the device `label`, or by default.
+    """
+
+def SetLogFile(path: typing.Any) -> None:
+    """
+    Append the log messages of all devices to a file, formatted as in MMCore's logs, or close it if None.
+    """
+
+def SetLogHandler(handler: typing.Any) -> None:
+    """
+    Pass the log messages of all devices to `handler` in batches, or stop if None.
+
+    Devices only stage their messages; a background thread calls `handler` every few ms with a time-ordered list of (time, level, label, thread, message) tuples, where `time` is in seconds since the epoch and `label` is empty for the core.
+    """
+
+def SetLogLevel(level: LogLevel, label: str = "") -> None:
+    """
+    Set the lowest level logged for the device `label`, or by default if no label is given.
+
+    Messages below it are dropped where they are logged.  The default level is Info.
+    """
+
 DEVICE_INTERFACE_VERSION: int = 71
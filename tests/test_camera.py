@@ -1,5 +1,7 @@
 from __future__ import annotations
 
+import threading
+import time
 from typing import cast
 
 import numpy as np
@@ -49,3 +51,269 @@ def test_demo_camera_context(pm: pmmd.PluginManager) -> None:
         assert cam.GetROI() == (0, 0, 256, 256)
         cam.SetROI(64, 64, 128, 128)
         assert cam.GetROI() == (64, 64, 128, 128)
+
+
+def test_image_array_no_copy(pm: pmmd.PluginManager) -> None:
+    module = pm.GetDeviceAdapter("DemoCamera")
+
+    with module.load_camera("DCam", "MyCamera") as cam:
+        with pytest.raises(RuntimeError, match="call SnapImage first"):
+            cam.GetImageArray(copy=False)
+
+        cam.SnapImage()
+        view = cam.GetImageArray(copy=False)
+        assert view.shape == (cam.GetImageHeight(), cam.GetImageWidth())
+        assert not view.flags.owndata
+        assert not view.flags.writeable
+        # every zero-copy view points at the same adapter-owned frame: 0 bytes copied
+        assert np.shares_memory(view, cam.GetImageArray(copy=False))
+
+        copied = cam.GetImageArray()
+        assert copied.flags.owndata
+        assert not np.shares_memory(view, copied)
+        np.testing.assert_array_equal(view, copied)
+
+
+def test_sequence_acquisition(pm: pmmd.PluginManager) -> None:
+    module = pm.GetDeviceAdapter("DemoCamera")
+
+    with module.load_camera("DCam", "MyCamera") as cam:
+        cam.SetExposure(1)
+        cam.InitializeSequenceBuffer(20)
+        assert cam.GetSequenceBufferCapacity() == 20
+        assert cam.GetRemainingImageCount() == 0
+
+        cam.StartSequenceAcquisition(10, 0, True)
+        deadline = time.monotonic() + 5
+        while cam.IsCapturing() and time.monotonic() < deadline:
+            time.sleep(0.01)
+
+        assert cam.GetRemainingImageCount() == 10
+        assert cam.GetSequenceBufferOverflowCount() == 0
+        for _ in range(10):
+            frame = cam.PopNextImage()
+            assert frame.shape == (cam.GetImageHeight(), cam.GetImageWidth())
+        assert cam.GetRemainingImageCount() == 0
+        with pytest.raises(IndexError):
+            cam.PopNextImage()
+
+
+def test_sequence_buffer_overflow(pm: pmmd.PluginManager) -> None:
+    module = pm.GetDeviceAdapter("DemoCamera")
+
+    with module.load_camera("DCam", "MyCamera") as cam:
+        cam.SetExposure(1)
+        cam.InitializeSequenceBuffer(2)
+        cam.StartSequenceAcquisition(10, 0, True)
+        deadline = time.monotonic() + 5
+        while cam.IsCapturing() and time.monotonic() < deadline:
+            time.sleep(0.01)
+
+        assert cam.GetRemainingImageCount() == 2
+        assert cam.GetSequenceBufferOverflowCount() >= 1
+        cam.ClearSequenceBuffer()
+        assert cam.GetRemainingImageCount() == 0
+
+
+def test_snap_releases_gil(pm: pmmd.PluginManager) -> None:
+    module = pm.GetDeviceAdapter("DemoCamera")
+    with module.load_camera("DCam", "MyCamera") as cam:
+        cam.SetExposure(200)
+
+        thread = threading.Thread(target=cam.SnapImage)
+        thread.start()
+        ticks = 0
+        while thread.is_alive():
+            ticks += 1
+            time.sleep(0.001)
+        thread.join()
+
+        # with the GIL held for the whole snap, this loop could not have run meanwhile
+        assert ticks > 20
+        assert cam.GetImageArray().shape == (512, 512)
+
+
+def test_snap_overlaps_stage_moves(
+    pm: pmmd.PluginManager, dm: pmmd.DeviceManager
+) -> None:
+    try:
+        tester = pm.GetDeviceAdapter("SequenceTester")
+    except RuntimeError:
+        pytest.skip("SequenceTester adapter not available")
+    demo = pm.GetDeviceAdapter("DemoCamera")
+    dm.LoadAndInitializeAll(
+        [
+            (demo, "DCam", "Cam"),
+            (tester, "THub", "Hub"),
+            (tester, "TZStage", "Z", "Hub"),
+        ]
+    )
+    cam = dm.GetDevice("Cam")
+    z = dm.GetDevice("Z")
+    cam.SetExposure(300)
+
+    window: list[float] = []
+
+    def snap() -> None:
+        window.append(time.monotonic())
+        cam.SnapImage()
+        window.append(time.monotonic())
+
+    thread = threading.Thread(target=snap)
+    thread.start()
+    moved: list[float] = []
+    while thread.is_alive():
+        z.SetPositionUm(float(len(moved)))
+        assert z.GetPositionUm() == float(len(moved))
+        moved.append(time.monotonic())
+    thread.join()
+
+    # the stage's library has a lock of its own, so it moved while the camera's was held
+    during = [t for t in moved if window[0] < t < window[1]]
+    assert len(during) > 20
+
+
+def test_snap_into(pm: pmmd.PluginManager) -> None:
+    module = pm.GetDeviceAdapter("DemoCamera")
+    with module.load_camera("DCam", "MyCamera") as cam:
+        cam.SetExposure(1)
+        cam.SetBinning(2)
+        h, w = cam.GetImageHeight(), cam.GetImageWidth()
+
+        stack = np.zeros((5, h, w), dtype=np.uint8)
+        stamps = cam.SnapInto(stack, 3)
+        assert stamps.shape == (3,)
+        assert np.all(np.diff(stamps) >= 0)
+        assert stack[:3].any()
+        assert not stack[3:].any()
+
+        assert cam.SnapInto(stack).shape == (5,)
+
+        with pytest.raises(ValueError, match="frames are"):
+            cam.SnapInto(np.zeros((2, h + 1, w), dtype=np.uint8))
+        with pytest.raises(ValueError, match="bytes per item"):
+            cam.SnapInto(np.zeros((2, h, w), dtype=np.uint16))
+        with pytest.raises(ValueError, match="Cannot snap"):
+            cam.SnapInto(stack, 6)
+
+
+def test_image_channels(pm: pmmd.PluginManager) -> None:
+    module = pm.GetDeviceAdapter("DemoCamera")
+    with module.load_camera("DCam", "MyCamera") as cam:
+        cam.SetBinning(2)
+        cam.SnapImage()
+        channels = cam.GetImageChannels()
+        assert channels.shape == (1, 256, 256)
+        np.testing.assert_array_equal(channels[0], cam.GetImageArray())
+
+        cam.SetProperty("PixelType", "32bitRGB")
+        cam.SnapImage()
+        rgba = cam.GetImageChannels()
+        assert rgba.shape == (256, 256, 4)
+        assert rgba.dtype == np.uint8
+        bgra = cam.GetImageArray()  # packed 0xAARRGGBB
+        np.testing.assert_array_equal(rgba[..., 0], (bgra >> 16) & 0xFF)
+        np.testing.assert_array_equal(rgba[..., 1], (bgra >> 8) & 0xFF)
+        np.testing.assert_array_equal(rgba[..., 2], bgra & 0xFF)
+
+
+def test_multi_roi(pm: pmmd.PluginManager) -> None:
+    module = pm.GetDeviceAdapter("DemoCamera")
+    with module.load_camera("DCam", "MyCamera") as cam:
+        if cam.HasProperty("AllowMultiROI"):
+            cam.SetProperty("AllowMultiROI", "1")
+        if not cam.SupportsMultiROI():
+            pytest.skip("camera does not support multi-ROI")
+
+        cam.SetExposure(1)
+        rois = [(10, 20, 16, 8), (100, 40, 4, 12)]
+        cam.SetMultiROI(*(list(v) for v in zip(*rois)))
+        assert cam.IsMultiROISet()
+        assert cam.GetMultiROICount() == 2
+        assert cam.GetMultiROI() == rois
+
+        cam.SnapImage()
+        full = cam.GetImageArray()
+        views = cam.GetMultiROIArrays()
+        for (x, y, w, h), view in zip(rois, views):
+            assert view.shape == (h, w)
+            assert not view.flags.writeable
+            np.testing.assert_array_equal(view, full[y - 20 : y - 20 + h, x - 10 : x - 10 + w])
+
+        cam.StartSequenceAcquisition(3, 0, True)
+        deadline = time.monotonic() + 5
+        while cam.GetRemainingImageCount() < 3 and time.monotonic() < deadline:
+            time.sleep(0.01)
+        assert cam.GetSequenceBufferCapacity() > 0
+        frame = cam.PopNextImageROIs()
+        assert [a.shape for a in frame] == [(h, w) for _, _, w, h in rois]
+        with pytest.raises(RuntimeError, match="PopNextImageROIs"):
+            cam.PopNextImage()
+        cam.StopSequenceAcquisition()
+
+
+def test_image_processors(pm: pmmd.PluginManager) -> None:
+    module = pm.GetDeviceAdapter("DemoCamera")
+    flip = module.LoadDevice("ImageFlipX", "MyFlip")
+    with flip, module.load_camera("DCam", "MyCamera") as cam:
+        frame = np.zeros((4, 6), dtype=np.uint16)
+        flip.Process(frame)  # in place
+        with pytest.raises(ValueError, match="writeable"):
+            frame.setflags(write=False)
+            flip.Process(frame)
+
+        # with FastImage the camera repeats the last snapped frame, so every processed
+        # frame must be its mirror image
+        cam.SetExposure(1)
+        cam.SnapImage()
+        original = cam.GetImageArray(copy=True)
+        cam.SetProperty("FastImage", "1")
+        cam.InitializeSequenceBuffer(20)
+        cam.SetImageProcessors([flip])
+        # twice in a row: the second start drains the frames of the first still queued
+        # for the processor, which shares the camera's adapter module (and lock)
+        for _ in range(2):
+            cam.StartSequenceAcquisition(10, 0, True)
+            deadline = time.monotonic() + 5
+            while cam.IsCapturing() and time.monotonic() < deadline:
+                time.sleep(0.01)
+        assert cam.WaitForImageProcessors(timeout=5)
+
+        assert cam.GetRemainingImageCount() == 10  # the buffer restarts with each sequence
+        for _ in range(10):
+            np.testing.assert_array_equal(cam.PopNextImage(), original[:, ::-1])
+
+        stats = cam.GetImageProcessingStats()
+        assert stats["processed"] == 20
+        assert stats["errors"] == 0
+        assert stats["overflows"] == 0
+        cam.SetImageProcessors([])
+        assert cam.GetImageProcessingStats()["processed"] == 0
+
+
+def test_image_processors_skipped_frames(pm: pmmd.PluginManager) -> None:
+    module = pm.GetDeviceAdapter("DemoCamera")
+    flip = module.LoadDevice("ImageFlipX", "MyFlip")
+    with flip, module.load_camera("DCam", "MyCamera") as cam:
+        cam.InitializeSequenceBuffer(20)
+        cam.SetImageProcessors([flip], queueFrames=20)
+        dtype = {1: np.uint8, 2: np.uint16, 4: np.uint32}[cam.GetImageBytesPerPixel()]
+        shape = (cam.GetImageHeight(), cam.GetImageWidth())
+        frames = [np.full(shape, i, dtype=dtype) for i in range(12)]
+        for frame in frames:
+            frame[:, 0] = 100  # so that a flipped frame differs from the original
+
+        # frames the camera inserts unprocessed still queue behind the processed ones
+        callback = pmmd.PyCoreCallback()
+        for i, frame in enumerate(frames):
+            ret = callback.InsertImage(cam.GetRawPtr(), frame, doProcess=i % 2 == 0)
+            assert ret == 0
+        assert cam.WaitForImageProcessors(timeout=5)
+
+        assert cam.GetRemainingImageCount() == 12
+        for i, frame in enumerate(frames):
+            expected = frame[:, ::-1] if i % 2 == 0 else frame
+            np.testing.assert_array_equal(cam.PopNextImage(), expected)
+        assert cam.GetImageProcessingStats()["processed"] == 6
+        cam.SetImageProcessors([])
+
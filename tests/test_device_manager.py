@@ -1,7 +1,14 @@
 from __future__ import annotations
 
+import json
+import select
+import sys
+import threading
+from pathlib import Path
 from typing import TYPE_CHECKING
 
+import pytest
+
 import pymmdevice as pmmd
 
 if TYPE_CHECKING:
@@ -40,3 +47,276 @@ def test_loaded_module(pm: pmmd.PluginManager, dm: pmmd.DeviceManager) -> None:
     assert module.GetAdvertisedDeviceType("DCam") == pmmd.DeviceType.CameraDevice
     assert "DCam" in module.GetAvailableDeviceNames()
     assert module.GetName() == "DemoCamera"
+
+
+def test_load_and_initialize_all(pm: pmmd.PluginManager, dm: pmmd.DeviceManager) -> None:
+    module = pm.GetDeviceAdapter("DemoCamera")
+    specs = [
+        (module, "DCam", "MyCam"),
+        (module, "DStage", "MyStage"),
+        (module, "DHub", "MyHub"),
+    ]
+    timings = dm.LoadAndInitializeAll(specs, max_workers=4)
+    assert list(timings) == ["MyCam", "MyStage", "MyHub"]
+    assert all(t >= 0 for t in timings.values())
+
+    for label in timings:
+        assert dm.GetDevice(label).IsInitialized()
+    # the hub lists the stage among its peripherals, so it became the stage's parent
+    hub = dm.GetDevice("MyHub")
+    assert "DStage" in hub.GetInstalledPeripheralNames()
+    stage = dm.GetDevice("MyStage")
+    assert stage.GetParentID() == "MyHub"
+    assert dm.GetParentDevice(stage) is dm.GetDevice("MyHub")
+
+
+def test_hardware_sequence(pm: pmmd.PluginManager, dm: pmmd.DeviceManager) -> None:
+    module = pm.GetDeviceAdapter("DemoCamera")
+    dm.LoadAndInitializeAll([(module, "DCam", "Cam"), (module, "DStage", "Z")])
+    cam = dm.GetDevice("Cam")
+    cam.SetExposure(1)
+    cam.InitializeSequenceBuffer(50)
+
+    seq = pmmd.HardwareSequence(dm, "Cam")
+    with pytest.raises(RuntimeError, match="not hardware-sequenceable"):
+        seq.AddStageSequence("Z", [0.0, 1.0])
+    with pytest.raises(TypeError, match="not an XY stage"):
+        seq.AddXYStageSequence("Z", [0.0], [0.0])
+
+    dm.GetDevice("Z").SetProperty("UseSequences", "Yes")
+    positions = [float(i) for i in range(25)]
+    seq.AddStageSequence("Z", positions)
+    assert seq.GetLength() == 25
+    with pytest.raises(ValueError, match="25 events"):
+        seq.AddStageSequence("Z", [0.0, 1.0])
+
+    chunks = seq.GetChunks()
+    assert chunks[0][0] == 0 and chunks[-1][1] == 25
+    assert all(a[1] == b[0] for a, b in zip(chunks, chunks[1:]))
+
+    assert seq.Run() == len(chunks)
+    assert cam.GetRemainingImageCount() == 25
+
+
+def test_array_sequence_upload(pm: pmmd.PluginManager, dm: pmmd.DeviceManager) -> None:
+    import numpy as np
+
+    module = pm.GetDeviceAdapter("DemoCamera")
+    dm.LoadAndInitializeAll([(module, "DStage", "Z")])
+    stage = dm.GetDevice("Z")
+    with pytest.raises(pmmd.SequenceError, match="not sequenceable"):
+        stage.AddToStageSequence(np.zeros(4))
+
+    stage.SetProperty("UseSequences", "Yes")
+    max_length = stage.GetStageSequenceMaxLength()
+    stage.ClearStageSequence()
+    assert stage.AddToStageSequence(np.linspace(0, 10, max_length - 3)) >= 0
+    assert stage.AddToStageSequence([1.0, 2.0]) >= 0  # any float sequence converts
+    assert stage.AddToStageSequence(3.0) == 0
+    # the points already queued count towards the limit
+    with pytest.raises(pmmd.SequenceError, match=f"already holds {max_length} of"):
+        stage.AddToStageSequence([4.0])
+    stage.ClearStageSequence()
+    with pytest.raises(pmmd.SequenceError, match="at most"):
+        stage.AddToStageSequence(np.zeros(max_length + 1))
+    assert stage.AddToStageSequence(np.zeros(max_length)) >= 0
+    with pytest.raises(ValueError, match="1-D"):
+        stage.AddToStageSequence(np.zeros((2, 2)))
+    assert stage.SendStageSequence() == 0
+
+
+def test_core_callback(pm: pmmd.PluginManager) -> None:
+    module = pm.GetDeviceAdapter("DemoCamera")
+    dm = pmmd.DeviceManager()
+    dm.LoadAndInitializeAll(
+        [(module, "DHub", "Hub"), (module, "DCam", "Cam"), (module, "DStage", "Z")]
+    )
+    cam = dm.GetDevice("Cam")
+    cam.SetExposure(1)
+    cam.SnapImage()
+    assert cam.GetImageArray().size > 0
+
+    dm.UnloadDevice(dm.GetDevice("Z"))
+    assert "Z" not in dm.GetDeviceList()
+
+    # unloading the rest leaves a device that Python still holds safe to touch
+    del dm
+    assert cam.GetLabel() == "Cam"
+
+
+def test_core_callback_parent_hub(pm: pmmd.PluginManager) -> None:
+    # SequenceTester's peripherals won't initialize unless GetParentHub finds their hub
+    try:
+        tester = pm.GetDeviceAdapter("SequenceTester")
+    except RuntimeError:
+        pytest.skip("SequenceTester adapter not available")
+    with pmmd.DeviceManager() as dm:
+        dm.LoadAndInitializeAll(
+            [(tester, "THub", "Hub"), (tester, "TZStage", "Z", "Hub")]
+        )
+        z = dm.GetDevice("Z")
+        assert z.IsInitialized()
+        z.SetPositionUm(5.0)
+        assert z.GetPositionUm() == 5.0
+
+    with pmmd.DeviceManager() as dm:
+        with pytest.raises(RuntimeError, match="Z"):
+            dm.LoadAndInitializeAll([(tester, "TZStage", "Z")])
+
+
+def test_event_stream(pm: pmmd.PluginManager, dm: pmmd.DeviceManager) -> None:
+    module = pm.GetDeviceAdapter("DemoCamera")
+    dm.LoadAndInitializeAll([(module, "DCam", "Cam"), (module, "DStage", "Z")])
+    z = dm.GetDevice("Z")
+    with dm.OpenEventStream() as events:
+        for pos in (1.0, 2.0, 3.0):
+            z.SetPositionUm(pos)
+        dm.GetDevice("Cam").SetExposure(12)
+
+        if sys.platform != "win32":
+            readable, _, _ = select.select([events], [], [], 1)
+            assert readable
+        assert events.Wait(timeout=1)
+        batch = events.Drain()
+        # repeated moves are coalesced into the latest
+        assert [e for e in batch if e[0] == "StagePositionChanged"] == [
+            ("StagePositionChanged", "Z", 3.0)
+        ]
+        assert ("ExposureChanged", "Cam", 12.0) in batch
+        assert events.Drain() == []
+        assert events.GetDroppedCount() == 0
+
+        z.SetPositionUm(4.0)
+        assert next(iter(events)) == ("StagePositionChanged", "Z", 4.0)
+
+
+@pytest.mark.skipif(sys.platform == "win32", reason="select() needs sockets on Windows")
+def test_event_stream_wakeups(pm: pmmd.PluginManager, dm: pmmd.DeviceManager) -> None:
+    module = pm.GetDeviceAdapter("DemoCamera")
+    dm.LoadAndInitializeAll([(module, "DStage", "Z")])
+    z = dm.GetDevice("Z")
+    moves = 2000
+    with dm.OpenEventStream(coalesce=False) as events:
+        producer = threading.Thread(
+            target=lambda: [z.SetPositionUm(float(i)) for i in range(moves)]
+        )
+        producer.start()
+        # drains racing with pushes must leave the stream readable while events remain
+        received = 0
+        while received < moves:
+            readable, _, _ = select.select([events], [], [], 2)
+            assert readable, f"stream not readable after {received} of {moves} events"
+            received += sum(e[0] == "StagePositionChanged" for e in events.Drain())
+        producer.join()
+        assert events.GetDroppedCount() == 0
+
+
+def test_call_stats(
+    pm: pmmd.PluginManager, dm: pmmd.DeviceManager, tmp_path: Path
+) -> None:
+    module = pm.GetDeviceAdapter("DemoCamera")
+    dm.LoadAndInitializeAll([(module, "DCam", "Cam")])
+    cam = dm.GetDevice("Cam")
+    cam.SnapImage()  # not profiled yet
+    assert dm.GetCallStats() == {}
+
+    dm.EnableCallStats(trace_capacity=8)
+    for _ in range(5):
+        cam.SnapImage()
+    cam.GetProperty("Binning")
+
+    stats = dm.GetCallStats()["Cam"]
+    snap = stats["SnapImage"]
+    assert snap["count"] == 5
+    assert 0 < snap["min_ms"] <= snap["mean_ms"] <= snap["max_ms"]
+    assert 0 < snap["p50_ms"] <= snap["p99_ms"]
+    assert snap["lock_wait_ms"] + snap["adapter_ms"] <= snap["total_ms"]
+    assert stats["GetProperty"]["count"] == 1
+
+    trace = tmp_path / "calls.json"
+    assert dm.ExportCallTrace(str(trace)) == 6
+    events = json.loads(trace.read_text())["traceEvents"]
+    assert [e["name"] for e in events] == ["SnapImage"] * 5 + ["GetProperty"]
+    assert all(e["ph"] == "X" and e["args"]["device"] == "Cam" for e in events)
+
+    dm.EnableCallStats(False)
+    cam.SnapImage()
+    assert dm.GetCallStats() == {}
+    with pytest.raises(RuntimeError, match="not enabled"):
+        dm.ExportCallTrace(str(trace))
+
+
+def test_wait_for_devices(pm: pmmd.PluginManager, dm: pmmd.DeviceManager) -> None:
+    module = pm.GetDeviceAdapter("DemoCamera")
+    dm.LoadAndInitializeAll(
+        [(module, "DStage", "Z"), (module, "DXYStage", "XY"), (module, "DShutter", "S")]
+    )
+    dm.GetDevice("Z").SetPositionUm(10)
+    dm.GetDevice("XY").SetPositionUm(5, 5)
+    settled = dm.WaitForDevices(["Z", "XY", "S"], timeout=None)
+    assert set(settled) == {"Z", "XY", "S"}
+    assert all(ms >= 0 for ms in settled.values())
+
+    assert dm.WaitForDevices([]) == {}
+    with pytest.raises(RuntimeError):
+        dm.WaitForDevices(["Nope"])
+
+
+def test_tile_scan(pm: pmmd.PluginManager, dm: pmmd.DeviceManager) -> None:
+    import numpy as np
+
+    module = pm.GetDeviceAdapter("DemoCamera")
+    dm.LoadAndInitializeAll(
+        [(module, "DCam", "Cam"), (module, "DXYStage", "XY"), (module, "DStage", "Z")]
+    )
+    cam = dm.GetDevice("Cam")
+    cam.SetExposure(1)
+    h, w = cam.GetImageHeight(), cam.GetImageWidth()
+    dtype = np.dtype(f"uint{8 * cam.GetImageBytesPerPixel()}")
+    with pytest.raises(TypeError, match="not an XY stage"):
+        pmmd.TileScan(dm, "Cam", "Z")
+
+    scan = pmmd.TileScan(dm, "Cam", "XY")
+    positions = np.array([[0, 0], [100, 0], [0, 100], [100, 100]], dtype=float)
+    stack = np.zeros((4, h, w), dtype)
+    times = scan.Run(positions, stack)
+    assert set(times) == {"settled_ms", "snapped_ms", "copied_ms"}
+    assert np.all(times["settled_ms"] <= times["snapped_ms"])
+    assert np.all(times["snapped_ms"] <= times["copied_ms"])
+    assert stack.any(axis=(1, 2)).all()
+    assert dm.GetDevice("XY").GetPositionUm() == pytest.approx((100, 100), abs=0.1)
+
+    mosaic = np.zeros((2 * h, 2 * w), dtype)
+    offsets = np.array([[0, 0], [0, w], [h, 0], [h, w]])
+    scan.Run(positions, mosaic, offsets)
+    assert all(mosaic[r : r + h, c : c + w].any() for r, c in offsets)
+
+    with pytest.raises(ValueError, match="needs tile offsets"):
+        scan.Run(positions, mosaic)
+    with pytest.raises(ValueError, match="does not fit"):
+        scan.Run(positions, mosaic[:h], offsets)
+    with pytest.raises(ValueError, match="bytes per pixel"):
+        scan.Run(positions, np.zeros((4, h, w), np.uint64))
+
+
+def test_software_autofocus(pm: pmmd.PluginManager, dm: pmmd.DeviceManager) -> None:
+    module = pm.GetDeviceAdapter("DemoCamera")
+    dm.LoadAndInitializeAll([(module, "DCam", "Cam"), (module, "DStage", "Z")])
+    dm.GetDevice("Cam").SetExposure(1)
+    with pytest.raises(TypeError, match="not a stage"):
+        pmmd.SoftwareAutofocus(dm, "Cam", "Cam")
+
+    af = pmmd.SoftwareAutofocus(dm, "Cam", "Z")
+    assert af.SnapAndScore(pmmd.FocusMetric.Brenner) > 0
+
+    result = af.Run(range_um=8, step_um=2, min_step_um=0.5, center_um=50)
+    positions, scores = result["positions"], result["scores"]
+    assert len(positions) == len(scores) >= 5
+    assert all(46 <= z <= 54 for z in positions)
+    assert result["score"] == max(scores)
+    assert result["score_ms"] >= 0
+    best = result["position_um"]
+    assert dm.GetDevice("Z").GetPositionUm() == pytest.approx(best, abs=0.1)
+
+    with pytest.raises(ValueError, match="step_um"):
+        af.Run(step_um=0)
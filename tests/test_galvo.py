@@ -0,0 +1,27 @@
+from __future__ import annotations
+
+import numpy as np
+import pytest
+
+import pymmdevice as pmmd
+
+
+def test_galvo_arrays(pm: pmmd.PluginManager) -> None:
+    module = pm.GetDeviceAdapter("DemoCamera")
+    with module.LoadDevice("DGalvo", "MyGalvo") as galvo:
+        x0, y0 = galvo.GetXMinimum(), galvo.GetYMinimum()
+        xr, yr = galvo.GetXRange(), galvo.GetYRange()
+        square = np.array([[0, 0], [1, 0], [1, 1], [0, 1]], dtype=float)
+        vertices = np.concatenate([square, square * 0.5]) * [xr / 2, yr / 2] + [x0, y0]
+        galvo.LoadPolygonsFromArray(vertices, [0, 4])
+
+        with pytest.raises(ValueError, match="outside the galvo range"):
+            galvo.LoadPolygonsFromArray(vertices + [xr * 2, 0], [0, 4])
+        with pytest.raises(ValueError, match="increasing"):
+            galvo.LoadPolygonsFromArray(vertices, [0, 4, 2])
+        with pytest.raises(ValueError, match="vertices is empty"):
+            galvo.LoadPolygonsFromArray(np.empty((0, 2)), [])
+
+        stamps = galvo.PointAndFireSequence(vertices, np.full(len(vertices), 10.0))
+        assert stamps.shape == (len(vertices),)
+        assert np.all(np.diff(stamps) >= 0)
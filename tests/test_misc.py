@@ -1,6 +1,83 @@
+import time
+from pathlib import Path
+
+import pytest
+
 import pymmdevice as pmmd
 
 
 def test_version() -> None:
     assert isinstance(pmmd.DEVICE_INTERFACE_VERSION, int)
     assert pmmd.DEVICE_INTERFACE_VERSION >= 70
+
+
+def test_logging(
+    pm: pmmd.PluginManager, dm: pmmd.DeviceManager, tmp_path: Path
+) -> None:
+    batches: list[list[tuple]] = []
+    log_file = tmp_path / "device.log"
+    cam = dm.LoadDevice(pm.GetDeviceAdapter("DemoCamera"), "DCam", "Cam")
+    try:
+        pmmd.SetLogHandler(batches.append)
+        pmmd.SetLogFile(str(log_file))
+        assert pmmd.GetLogLevel() == pmmd.LogLevel.Info
+
+        before = time.time()
+        cam.LogMessage("hello", False)
+        cam.LogMessage("details", True)  # below the default level
+        pmmd.SetLogLevel(pmmd.LogLevel.Debug, "Cam")
+        assert pmmd.GetLogLevel("Cam") == pmmd.LogLevel.Debug
+        cam.LogMessage("more details", True)
+        pmmd.FlushLog()
+
+        records = [r for batch in batches for r in batch if r[2] == "Cam"]
+        assert [(r[1], r[4]) for r in records] == [
+            (pmmd.LogLevel.Info, "hello"),
+            (pmmd.LogLevel.Debug, "more details"),
+        ]
+        assert before <= records[0][0] <= time.time()
+        lines = log_file.read_text().splitlines()
+        assert lines[-2].endswith(" [IFO,dev:Cam] hello")
+        assert lines[-1].endswith(" [dbg,dev:Cam] more details")
+        assert pmmd.GetDroppedLogCount() == 0
+    finally:
+        pmmd.SetLogHandler(None)
+        pmmd.SetLogFile(None)
+        pmmd.SetLogLevel(pmmd.LogLevel.Info, "Cam")
+
+
+def test_focus_score() -> None:
+    import numpy as np
+
+    rng = np.random.default_rng(0)
+    image = rng.integers(0, 4096, (37, 53), dtype=np.uint16)
+    p = image.astype(float)
+
+    mean = p.mean()
+    assert pmmd.FocusScore(image) == pytest.approx(p.var() / mean)
+    brenner = ((p[:, 2:] - p[:, :-2]) ** 2).mean()
+    assert pmmd.FocusScore(image, pmmd.FocusMetric.Brenner) == pytest.approx(brenner)
+    gx = (
+        (p[:-2, 2:] + 2 * p[1:-1, 2:] + p[2:, 2:])
+        - (p[:-2, :-2] + 2 * p[1:-1, :-2] + p[2:, :-2])
+    )
+    gy = (
+        (p[2:, :-2] + 2 * p[2:, 1:-1] + p[2:, 2:])
+        - (p[:-2, :-2] + 2 * p[:-2, 1:-1] + p[:-2, 2:])
+    )
+    tenengrad = (gx**2 + gy**2).mean()
+    score = pmmd.FocusScore(image, pmmd.FocusMetric.Tenengrad)
+    assert score == pytest.approx(tenengrad)
+
+    # a blurred copy scores lower on every metric
+    blurred = ((image[:, :-1].astype(np.uint32) + image[:, 1:]) // 2).astype(np.uint16)
+    for metric in pmmd.FocusMetric.__members__.values():
+        assert pmmd.FocusScore(blurred, metric) < pmmd.FocusScore(image, metric)
+    assert pmmd.FocusScore(np.zeros((4, 4), np.uint8)) == 0
+
+    with pytest.raises(ValueError, match="2-D"):
+        pmmd.FocusScore(image[0])
+    with pytest.raises(ValueError, match="C-contiguous"):
+        pmmd.FocusScore(image[:, ::2])
+    with pytest.raises(ValueError, match="1 or 2 bytes"):
+        pmmd.FocusScore(image.astype(np.uint32))
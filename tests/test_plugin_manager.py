@@ -1,5 +1,6 @@
 from __future__ import annotations
 
+from pathlib import Path
 from typing import TYPE_CHECKING
 
 import pytest
@@ -60,6 +61,64 @@ def test_all_devices(pm: pmmd.PluginManager, device_info: Di) -> None:
         assert dev
 
 
+def test_adapter_index(mm_lib_dir: str, tmp_path: Path) -> None:
+    index_file = tmp_path / "adapters.idx"
+    pm = pmmd.PluginManager()
+    pm.SetSearchPaths([mm_lib_dir])
+    assert pm.EnableAdapterIndex(str(index_file)) > 0
+    assert index_file.exists()
+    assert "DemoCamera" in pm.GetIndexedDeviceAdapters()
+    devices = pm.GetIndexedDevices("DemoCamera")
+    assert ("DCam", pmmd.DeviceType.CameraDevice, "Demo camera") in devices
+
+    # a second manager is served entirely from the file
+    pm2 = pmmd.PluginManager()
+    pm2.SetSearchPaths([mm_lib_dir])
+    assert pm2.EnableAdapterIndex(str(index_file)) == 0
+    assert pm2.GetIndexedDevices("DemoCamera") == devices
+    assert pm2.RefreshAdapterIndex() == 0
+
+    with pytest.raises(RuntimeError, match="No adapter library"):
+        pm2.GetIndexedDevices("FooCamera")
+
+
+def test_discovery(mm_lib_dir: str, tmp_path: Path) -> None:
+    pm = pmmd.PluginManager()
+    pm.SetSearchPaths([mm_lib_dir])
+    discovery = pm.StartDiscovery()
+    # doesn't wait for the scan
+    assert isinstance(pm.GetDeviceAdapter("DemoCamera"), pmmd.LoadedDeviceAdapter)
+    assert discovery.Wait(timeout=60)
+    assert discovery.IsDone()
+    assert "DemoCamera" in discovery.GetAvailableDeviceAdapters()
+    validated, total = discovery.GetProgress()
+    assert validated == total > 0
+    assert validated == len(discovery.GetAvailableDeviceAdapters()) + len(
+        discovery.GetErrors()
+    )
+
+    # a module the scan may be probing right now is waited for, not loaded alongside
+    for _ in range(5):
+        pm.UnloadPluginLibrary("DemoCamera")
+        discovery = pm.StartDiscovery(max_workers=8)
+        module = pm.GetDeviceAdapter("DemoCamera")
+        assert "DCam" in module.GetAvailableDeviceNames()
+        assert discovery.Wait(timeout=60)
+
+    # with the index enabled, a second scan doesn't probe anything
+    pm.EnableAdapterIndex(str(tmp_path / "adapters.idx"))
+    discovery = pm.StartDiscovery(max_workers=2)
+    assert discovery.Wait()
+    assert "DemoCamera" in discovery.GetAvailableDeviceAdapters()
+    assert pm.RefreshAdapterIndex() == 0
+
+    discovery = pm.StartDiscovery()
+    discovery.Cancel()
+    assert discovery.Wait(timeout=60)
+    pm.SetSearchPaths([])
+    assert pm.StartDiscovery().Wait(timeout=60)
+
+
 # def test_loaded_module_from_file(mm_lib_dir: str) -> None:
 #     democam_file = sorted(Path(mm_lib_dir).glob("libmmgr_dal_DemoCamera.*"))[0]
 #     module = pmmd.LoadedDeviceAdapter.from_file(str(democam_file))
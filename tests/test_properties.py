@@ -0,0 +1,52 @@
+from __future__ import annotations
+
+import pymmdevice as pmmd
+
+
+def test_property_cache(pm: pmmd.PluginManager) -> None:
+    module = pm.GetDeviceAdapter("DemoCamera")
+    cam = module.load_camera("DCam", "MyCamera")
+    assert not cam.IsPropertyCacheEnabled()
+    cam.EnablePropertyCache()
+    assert cam.IsPropertyCacheEnabled()
+
+    with cam:
+        stats = cam.GetPropertyCacheStats()
+        assert stats["size"] == len(cam.GetPropertyNames())
+        assert stats["hits"] == stats["misses"] == 0
+
+        assert cam.GetProperty("Binning") == "1"
+        assert cam.GetProperty("Binning") == "1"
+        assert cam.GetPropertyCacheStats()["hits"] == 2
+
+        cam.SetProperty("Binning", "2")
+        assert cam.GetProperty("Binning") == "2"
+        assert cam.GetPropertyCacheStats()["misses"] == 1
+
+        cam.ClearPropertyCache()
+        assert cam.GetPropertyCacheStats()["size"] == 0
+        assert cam.GetProperty("Binning") == "2"
+
+        cam.EnablePropertyCache(False)
+        assert not cam.IsPropertyCacheEnabled()
+        assert cam.GetPropertyCacheStats()["hits"] == 0
+
+
+def test_snapshot_and_apply(pm: pmmd.PluginManager, dm: pmmd.DeviceManager) -> None:
+    module = pm.GetDeviceAdapter("DemoCamera")
+    for name in ("DCam", "DStage", "DWheel"):
+        dm.LoadDevice(module, name, f"My{name}").Initialize()
+
+    snap = dm.SnapshotProperties()
+    assert set(snap) == {"device", "name", "value", "type", "readOnly"}
+    assert len({len(col) for col in snap.values()}) == 1
+    assert set(snap["device"]) == {"MyDCam", "MyDStage", "MyDWheel"}
+    assert all(isinstance(t, pmmd.PropertyType) for t in snap["type"])
+
+    # nothing changed: nothing to set
+    assert dm.ApplyProperties(snap) == []
+
+    cam = dm.GetDevice("MyDCam")
+    cam.SetProperty("Binning", "2")
+    assert dm.ApplyProperties(snap) == [("MyDCam", "Binning")]
+    assert cam.GetProperty("Binning") == "1"
@@ -0,0 +1,199 @@
+from __future__ import annotations
+
+import os
+import select
+import struct
+import sys
+import threading
+import time
+from pathlib import Path
+from typing import Iterator
+
+import pytest
+
+import pymmdevice as pmmd
+
+# what the simulated device answers, by command; anything else is echoed in upper case
+ANSWERS = {b"SILENT": b"", b"TWO": b"one\rtwo\r", b"PART": b"partial"}
+
+
+def _serve(fd: int, stop: threading.Event) -> None:
+    """Play a device that answers each \\r-terminated command on the pty master `fd`."""
+    pending = b""
+    while not stop.is_set():
+        if not select.select([fd], [], [], 0.02)[0]:
+            continue
+        try:
+            pending += os.read(fd, 1024)
+        except OSError:
+            return
+        while b"\r" in pending:
+            command, pending = pending.split(b"\r", 1)
+            os.write(fd, ANSWERS.get(command, command.upper() + b"\r"))
+
+
+@pytest.fixture
+def port(pm: pmmd.PluginManager) -> Iterator[pmmd.SerialInstance]:
+    """A SerialManager port on a pseudo-terminal, with a simulated device behind it."""
+    if sys.platform == "win32":
+        pytest.skip("needs a pseudo-terminal")
+    try:
+        module = pm.GetDeviceAdapter("SerialManager")
+    except RuntimeError:
+        pytest.skip("SerialManager adapter not available")
+    master, slave = os.openpty()
+    stop = threading.Event()
+    device = threading.Thread(target=_serve, args=(master, stop), daemon=True)
+    try:
+        port = module.LoadDevice(os.ttyname(slave), "Port")
+        try:
+            port.Initialize()
+        except RuntimeError as e:
+            pytest.skip(f"cannot open a pseudo-terminal as a serial port: {e}")
+        device.start()
+        yield port
+        port.Shutdown()
+    finally:
+        stop.set()
+        if device.is_alive():
+            device.join()
+        os.close(master)
+        os.close(slave)
+
+
+def test_transact(port: pmmd.SerialInstance) -> None:
+    assert port.Transact("a", "\r") == b"A"
+    assert port.TransactMany(["b", "c", "d"], "\r", window=2) == [b"B", b"C", b"D"]
+    assert port.TransactMany([], "\r") == []
+
+    # a single command times out rather than returning a placeholder answer
+    with pytest.raises(TimeoutError, match="command 0"):
+        port.Transact("SILENT", "\r", timeout=0.1)
+    # the unterminated answer is purged, so it doesn't end up in the next one
+    with pytest.raises(TimeoutError):
+        port.Transact("PART", "\r", timeout=0.1)
+    assert port.Transact("e", "\r") == b"E"
+    with pytest.raises(TimeoutError, match="command 1"):
+        port.TransactMany(["f", "SILENT", "g"], "\r", timeout=0.1, window=1)
+
+    with pytest.raises(ValueError, match="terminator"):
+        port.Transact("a", "")
+
+
+def _read_line(port: pmmd.SerialInstance) -> bytes:
+    received = b""
+    deadline = time.monotonic() + 2
+    while not received.endswith(b"\r") and time.monotonic() < deadline:
+        received += port.Read()
+    return received
+
+
+def test_read_and_get_answer(port: pmmd.SerialInstance) -> None:
+    # what Transact reads past its answer is handed to GetAnswer and Read next
+    assert port.Transact("TWO", "\r") == b"one"
+    assert port.GetAnswer("\r") == "two"
+    assert port.Transact("TWO", "\r") == b"one"
+    assert _read_line(port) == b"two\r"
+
+    port.Write(b"hello\r")
+    assert _read_line(port) == b"HELLO\r"
+
+    buffer = bytearray(8)
+    port.SetCommand("xy", "\r")
+    assert port.GetAnswer("\r") == "XY"
+    assert port.ReadInto(buffer) == 0
+
+    # readers on several threads share one buffer, so no answer is lost between them
+    answers: list[bytes] = []
+    threads = [
+        threading.Thread(target=lambda c=c: answers.append(port.Transact(c, "\r")))
+        for c in "hijk"
+    ]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    assert sorted(answers) == [b"H", b"I", b"J", b"K"]
+
+
+def _serial_record(us: int, port: int, kind: int, data: bytes) -> bytes:
+    return struct.pack("<QHBI", us, port, kind, len(data)) + data
+
+
+def test_serial_replay(tmp_path: Path) -> None:
+    # an empty recording is just the header
+    with pmmd.SerialRecorder(str(tmp_path / "empty.mmserial")) as recorder:
+        recorder.AddPort("COM9")
+        assert recorder.GetPortNames() == ["COM9"]
+    assert not recorder.IsOpen()
+    assert (tmp_path / "empty.mmserial").read_bytes() == b"MMSERIAL" + struct.pack("<I", 1)
+
+    # a device that answers "V?" 50 ms after it was asked
+    path = tmp_path / "trace.mmserial"
+    path.write_bytes(
+        b"MMSERIAL"
+        + struct.pack("<I", 1)
+        + _serial_record(0, 0, 0, b"COM1")
+        + _serial_record(0, 0, 3, b"")
+        + _serial_record(1000, 0, 1, b"V?\r")
+        + _serial_record(51000, 0, 2, b"1.0\r")
+    )
+
+    replay = pmmd.SerialReplay(str(path))
+    assert replay.GetPortNames() == ["COM1"]
+    replay.Purge("COM1")
+    replay.Write("COM1", b"V?\r")
+    assert replay.Read("COM1") == b""  # not yet
+    start = time.perf_counter()
+    assert replay.GetAnswer("COM1", "\r") == "1.0"
+    assert time.perf_counter() - start > 0.03
+    assert replay.IsFinished()
+    assert replay.GetMismatchCount() == 0
+
+    replay = pmmd.SerialReplay(str(path), time_scale=0, answer_timeout=0.01)
+    replay.Purge("COM1")
+    replay.Write("COM1", b"X?\r")
+    assert replay.GetMismatchCount() == 1
+    assert "V?" in replay.GetLastMismatch()
+    assert replay.Read("COM1") == b"1.0\r"
+    with pytest.raises(TimeoutError):
+        replay.GetAnswer("COM1", "\r")
+
+    with pytest.raises(ValueError):
+        replay.Attach(["COM2"])
+
+    # strict replay refuses what departs from the recording, like the port it stands in for
+    replay = pmmd.SerialReplay(str(path), time_scale=0, strict=True)
+    replay.Purge("COM1")
+    with pytest.raises(RuntimeError, match="Refused by strict replay"):
+        replay.Write("COM1", b"X?\r")
+    with pytest.raises(RuntimeError, match="Unknown replayed port"):
+        replay.Purge("COM2")
+
+
+def test_record_and_replay(port: pmmd.SerialInstance, tmp_path: Path) -> None:
+    path = tmp_path / "port.mmserial"
+    with pmmd.SerialRecorder(str(path)) as recorder:
+        recorder.AddPort("Port")
+        assert port.SetCommand("ab", "\r") == 0
+        assert port.GetAnswer("\r") == "AB"
+        assert port.SetCommand("TWO", "\r") == 0
+        assert port.GetAnswer("\r") == "one"
+        assert port.GetAnswer("\r") == "two"
+    assert recorder.GetEventCount() >= 4
+
+    # adapters' calls on the port are served from the recording, not the device
+    callback = pmmd.PyCoreCallback()
+    with pmmd.SerialReplay(str(path), time_scale=0, strict=True) as replay:
+        assert callback.SetSerialCommand(None, "Port", "ab", "\r") == 0
+        assert callback.GetSerialAnswer(None, "Port", "\r") == (0, "AB")
+        assert callback.SetSerialCommand(None, "Port", "TWO", "\r") == 0
+        assert callback.GetSerialAnswer(None, "Port", "\r") == (0, "one")
+        assert callback.ReadFromSerial(None, "Port") == (0, b"two\r")
+        assert replay.IsFinished()
+        assert replay.GetMismatchCount() == 0
+
+        with pytest.raises(TimeoutError, match="Nothing left"):
+            replay.Read("Port")
+        with pytest.raises(RuntimeError, match="Unknown replayed port"):
+            replay.Read("Elsewhere")